@@ -0,0 +1,220 @@
+#pragma once
+/* AllocationTracker.h : This file contains the code necessary to count
+ *      heap allocations. The global operator new and delete are
+ *		replaced with versions that count every allocation against the
+ *		subsystem the calling thread is working for.
+ *
+ *				A thread names the subsystem it works for with an
+ *				AllocationScope, which puts the previous one back when it
+ *				ends. Jobs are counted against the subsystem of the thread
+ *				that started them. A ZeroAllocationScope also asserts, in
+ *				debug builds, that nothing was allocated for its subsystem
+ *				while it was alive, for code that runs every frame. Work
+ *				that is only done once, like compiling a shader the first
+ *				time it is drawn with, is given its own subsystem so it
+ *				does not trip the check.
+ *
+ *				Counting is compiled into debug builds and into any build
+ *				with TRACK_ALLOCATIONS defined. Other builds keep the
+ *				standard operator new and every count stays zero.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#if defined(_DEBUG) || defined(TRACK_ALLOCATIONS)
+#define ALLOCATION_TRACKING
+#endif
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Subsystems allocations are counted against
+enum AllocationTag {
+	ALLOC_OTHER,				// Threads and code no subsystem was given to
+	ALLOC_STARTUP,				// Setup and building the scene
+	ALLOC_INPUT,				// Reading the keyboard each frame
+	ALLOC_SIMULATION,			// The rest of the simulation thread
+	ALLOC_RENDER,				// The render thread
+	ALLOC_SHADERS,				// Compiling, checking, and reloading shader programs
+	ALLOC_LIGHTMAP,				// Uploading a finished lightmap
+	ALLOC_TAG_COUNT
+};
+
+/* This class counts the heap allocations of each subsystem
+*/
+class AllocationTracker {
+private:
+	static std::atomic<uint64_t> counts[ALLOC_TAG_COUNT];	// Allocations of each subsystem
+	static std::atomic<uint64_t> bytes[ALLOC_TAG_COUNT];	// Bytes requested by each subsystem
+	static thread_local AllocationTag threadTag;			// Subsystem the calling thread works for
+
+public:
+	// True if this build counts allocations
+	static bool Enabled();
+	// Count an allocation against the calling thread's subsystem
+	static void Record(size_t size);
+	// Subsystem the calling thread works for
+	static AllocationTag Tag();
+	// Count the calling thread's allocations against a subsystem from now on
+	static void SetTag(AllocationTag tag);
+	// Allocations counted against a subsystem since the start
+	static uint64_t Count(AllocationTag tag);
+	// Bytes requested by a subsystem since the start
+	static uint64_t Bytes(AllocationTag tag);
+	// Name of a subsystem for reports
+	static const char* Name(AllocationTag tag);
+};
+
+/* This class counts the calling thread's allocations against a subsystem while it is alive
+*/
+class AllocationScope {
+private:
+	AllocationTag previous;				// Subsystem to go back to
+
+	// Copying would put the previous subsystem back twice
+	AllocationScope(const AllocationScope&);
+	AllocationScope& operator=(const AllocationScope&);
+
+public:
+	// Start counting against a subsystem
+	explicit AllocationScope(AllocationTag tag);
+	// Go back to the previous subsystem
+	~AllocationScope();
+};
+
+/* This class counts against a subsystem like AllocationScope and asserts in debug builds that the subsystem allocated nothing
+*/
+class ZeroAllocationScope {
+private:
+	AllocationScope scope;
+	AllocationTag tag;
+	uint64_t start;						// Count of the subsystem when the scope began
+
+public:
+	// Start counting against a subsystem
+	explicit ZeroAllocationScope(AllocationTag tag);
+	// Check that the subsystem did not allocate
+	~ZeroAllocationScope();
+};
+
+std::atomic<uint64_t> AllocationTracker::counts[ALLOC_TAG_COUNT];
+std::atomic<uint64_t> AllocationTracker::bytes[ALLOC_TAG_COUNT];
+thread_local AllocationTag AllocationTracker::threadTag = ALLOC_OTHER;
+
+// True if this build counts allocations
+bool AllocationTracker::Enabled() {
+#ifdef ALLOCATION_TRACKING
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Count an allocation
+void AllocationTracker::Record(size_t size) {
+	counts[threadTag].fetch_add(1, std::memory_order_relaxed);
+	bytes[threadTag].fetch_add(size, std::memory_order_relaxed);
+}
+
+// Subsystem the calling thread works for
+AllocationTag AllocationTracker::Tag() {
+	return threadTag;
+}
+
+// Count the calling thread's allocations against a subsystem
+void AllocationTracker::SetTag(AllocationTag tag) {
+	threadTag = tag;
+}
+
+// Allocations counted against a subsystem
+uint64_t AllocationTracker::Count(AllocationTag tag) {
+	return counts[tag].load(std::memory_order_relaxed);
+}
+
+// Bytes requested by a subsystem
+uint64_t AllocationTracker::Bytes(AllocationTag tag) {
+	return bytes[tag].load(std::memory_order_relaxed);
+}
+
+// Name of a subsystem
+const char* AllocationTracker::Name(AllocationTag tag) {
+	static const char* const names[ALLOC_TAG_COUNT] = { "other", "startup", "input", "simulation", "render", "shaders", "lightmap" };
+	return names[tag];
+}
+
+// Start counting against a subsystem
+AllocationScope::AllocationScope(AllocationTag tag) {
+	previous = AllocationTracker::Tag();
+	AllocationTracker::SetTag(tag);
+}
+
+// Go back to the previous subsystem
+AllocationScope::~AllocationScope() {
+	AllocationTracker::SetTag(previous);
+}
+
+// Start counting against a subsystem
+ZeroAllocationScope::ZeroAllocationScope(AllocationTag tag) : scope(tag) {
+	this->tag = tag;
+	start = AllocationTracker::Count(tag);
+}
+
+// Check that the subsystem did not allocate
+ZeroAllocationScope::~ZeroAllocationScope() {
+	// Code that runs every frame should only use memory set aside before the frame
+	assert(AllocationTracker::Count(tag) == start && "heap allocation in code that runs every frame");
+}
+
+#ifdef ALLOCATION_TRACKING
+// Replacements for the global allocation functions that count each allocation
+void* operator new(size_t size) {
+	AllocationTracker::Record(size);
+	void* memory = malloc(size ? size : 1);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	AllocationTracker::Record(size);
+	return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) noexcept {
+	return operator new(size, nothrow);
+}
+
+void operator delete(void* memory) noexcept {
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+	free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+	free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+	free(memory);
+}
+#endif
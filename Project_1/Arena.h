@@ -0,0 +1,309 @@
+#pragma once
+/* Arena.h : This file contains the code necessary to hand out short
+ *      lived memory without going to the heap for every allocation.
+ *		An arena is a list of large blocks. Allocating moves a pointer
+ *		forward through the current block, and everything allocated
+ *		after a mark is given back at once by moving the pointer back.
+ *
+ *				The render thread resets a frame arena at the start of
+ *				every frame. If a frame needed more than one block, the
+ *				reset replaces them with a single block big enough for
+ *				all of them, so once the scene has been seen no frame
+ *				takes memory from the heap.
+ *
+ *				Every thread also has a scratch arena for the temporary
+ *				arrays the shape generators fill while a scene is built.
+ *				An ArenaScope gives back what was allocated while it
+ *				lived, and ArenaAllocator lets a std::vector grow inside
+ *				an arena. Freeing single allocations does nothing.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Position in an arena to rewind to
+struct ArenaMark {
+	void* block;				// Block that was current, null if the arena had none yet
+	size_t used;				// Bytes used in that block
+};
+
+/* This class allocates from large blocks by moving a pointer and frees everything after a mark at once
+*/
+class Arena {
+private:
+	// Header at the start of every block. The memory handed out follows it
+	struct Block {
+		Block* next;
+		size_t size;				// Bytes after the header
+		size_t used;				// Bytes handed out from this block
+	};
+	// Header size rounded up so the memory after it has the strictest alignment malloc gives
+	static const size_t HEADER_SIZE = (sizeof(Block) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+	static const size_t SCRATCH_BLOCK_SIZE = 256 * 1024;	// Block size of every thread's scratch arena
+
+	Block* first;
+	Block* current;					// Block allocations come from
+	size_t blockSize;				// Smallest size of a new block
+	bool overflowed;				// True if allocations moved past the first block since the last reset
+
+	// Take a block with room for size bytes from the heap
+	Block* NewBlock(size_t size);
+	// Give every block back to the heap
+	void FreeBlocks();
+	// Memory after a block's header
+	static char* Data(Block* block);
+
+	// Copying would free the blocks twice
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+
+public:
+	// Constructor. No memory is taken until the first allocation
+	explicit Arena(size_t blockSize);
+	// Free the blocks
+	~Arena();
+	// Size bytes starting at a multiple of alignment, which must be a power of two no larger than alignof(std::max_align_t)
+	void* Allocate(size_t size, size_t alignment);
+	// Uninitialized room for count values. Their destructors are never called, so T should not need one
+	template <class T>
+	T* AllocateArray(size_t count);
+	// Position to rewind to later
+	ArenaMark Mark() const;
+	// Give back everything allocated after a mark. Blocks are kept for the allocations that follow
+	void Rewind(const ArenaMark& mark);
+	// Give back everything, merging the blocks into one if more than one was needed
+	void Reset();
+	// Bytes handed out since the last reset, including alignment padding
+	size_t Used() const;
+	// Scratch arena of the calling thread
+	static Arena& Scratch();
+};
+
+/* This class gives back everything allocated from an arena while it is alive
+*/
+class ArenaScope {
+private:
+	Arena& arena;
+	ArenaMark mark;
+
+	// Copying would rewind twice
+	ArenaScope(const ArenaScope&);
+	ArenaScope& operator=(const ArenaScope&);
+
+public:
+	// Remember where the arena is
+	explicit ArenaScope(Arena& arena);
+	// Rewind the arena to where it was
+	~ArenaScope();
+};
+
+/* This class lets standard containers allocate from an arena. Deallocating does nothing
+*/
+template <class T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+	Arena* arena;
+
+	// Allocator for an arena
+	explicit ArenaAllocator(Arena& arena);
+	// Same arena for another type
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& other);
+	// Room for count values
+	T* allocate(size_t count);
+	// The memory is given back when the arena is rewound
+	void deallocate(T*, size_t);
+};
+
+// Allocators are equal when they share an arena
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right);
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right);
+
+// Vector whose storage is in an arena
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+// Constructor
+Arena::Arena(size_t blockSize) {
+	first = nullptr;
+	current = nullptr;
+	this->blockSize = blockSize;
+	overflowed = false;
+}
+
+// Free the blocks
+Arena::~Arena() {
+	FreeBlocks();
+}
+
+// Take a block from the heap
+Arena::Block* Arena::NewBlock(size_t size) {
+	Block* block = (Block*)malloc(HEADER_SIZE + size);
+	if (!block) {
+		throw std::bad_alloc();
+	}
+	block->next = nullptr;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+// Give every block back to the heap
+void Arena::FreeBlocks() {
+	while (first) {
+		Block* next = first->next;
+		free(first);
+		first = next;
+	}
+	current = nullptr;
+}
+
+// Memory after a block's header
+char* Arena::Data(Block* block) {
+	return (char*)block + HEADER_SIZE;
+}
+
+// Size bytes starting at a multiple of alignment
+void* Arena::Allocate(size_t size, size_t alignment) {
+	while (current) {
+		size_t start = (current->used + alignment - 1) & ~(alignment - 1);
+		if (start + size <= current->size) {
+			current->used = start + size;
+			return Data(current) + start;
+		}
+		if (!current->next) {
+			break;
+		}
+		// Reuse a block kept from before a rewind
+		current = current->next;
+		current->used = 0;
+		overflowed = true;
+	}
+
+	// Out of room, so take another block big enough for this allocation
+	Block* block = NewBlock(std::max(blockSize, size + alignment));
+	if (current) {
+		current->next = block;
+		overflowed = true;
+	}
+	else {
+		first = block;
+	}
+	current = block;
+	return Allocate(size, alignment);
+}
+
+// Uninitialized room for count values
+template <class T>
+T* Arena::AllocateArray(size_t count) {
+	return (T*)Allocate(count * sizeof(T), alignof(T));
+}
+
+// Position to rewind to later
+ArenaMark Arena::Mark() const {
+	ArenaMark mark = { current, current ? current->used : 0 };
+	return mark;
+}
+
+// Give back everything allocated after a mark
+void Arena::Rewind(const ArenaMark& mark) {
+	if (!mark.block) {
+		current = first;
+		if (current) {
+			current->used = 0;
+		}
+		return;
+	}
+	current = (Block*)mark.block;
+	current->used = mark.used;
+}
+
+// Give back everything
+void Arena::Reset() {
+	if (!overflowed) {
+		Rewind(ArenaMark());
+		return;
+	}
+	// One block the size of all of them keeps the next frame in a single block
+	size_t total = 0;
+	for (Block* block = first; block; block = block->next) {
+		total += block->size;
+	}
+	FreeBlocks();
+	first = NewBlock(total);
+	current = first;
+	overflowed = false;
+}
+
+// Bytes handed out since the last reset
+size_t Arena::Used() const {
+	size_t used = 0;
+	for (Block* block = first; block; block = block->next) {
+		used += block->used;
+		if (block == current) {
+			break;
+		}
+	}
+	return used;
+}
+
+// Scratch arena of the calling thread
+Arena& Arena::Scratch() {
+	static thread_local Arena scratch(SCRATCH_BLOCK_SIZE);
+	return scratch;
+}
+
+// Remember where the arena is
+ArenaScope::ArenaScope(Arena& arena) : arena(arena) {
+	mark = arena.Mark();
+}
+
+// Rewind the arena to where it was
+ArenaScope::~ArenaScope() {
+	arena.Rewind(mark);
+}
+
+// Allocator for an arena
+template <class T>
+ArenaAllocator<T>::ArenaAllocator(Arena& arena) {
+	this->arena = &arena;
+}
+
+// Same arena for another type
+template <class T>
+template <class U>
+ArenaAllocator<T>::ArenaAllocator(const ArenaAllocator<U>& other) {
+	arena = other.arena;
+}
+
+// Room for count values
+template <class T>
+T* ArenaAllocator<T>::allocate(size_t count) {
+	return arena->AllocateArray<T>(count);
+}
+
+// The memory is given back when the arena is rewound
+template <class T>
+void ArenaAllocator<T>::deallocate(T*, size_t) {
+}
+
+// Allocators are equal when they share an arena
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right) {
+	return left.arena == right.arena;
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right) {
+	return left.arena != right.arena;
+}
@@ -0,0 +1,366 @@
+#pragma once
+/* Bvh.h : This file contains the code necessary to build a bounding
+ *      volume hierarchy over the objects in the scene. The hierarchy
+ *		is used to cull whole groups of objects against the view
+ *		frustum and to find the object hit by a ray.
+ *
+ *				Nodes are built with the surface area heuristic and
+ *				stored depth first in one flat array. A left child always
+ *				directly follows its parent, so only the right child index
+ *				is stored and a node fits in 32 bytes.
+ *
+ *				When objects move the hierarchy is refit instead of rebuilt.
+ *
+ *				The nodes at SUBTREE_DEPTH, and the leaves above it, are
+ *				remembered when the hierarchy is built. Together they hold
+ *				every item once, so the frustum can be culled one subtree
+ *				per job, with whole nodes still accepted or rejected by a
+ *				single test.
+ *
+ *				Traversal keeps pending nodes on a fixed size stack, which
+ *				holds at most one node per level plus one. The build stops
+ *				splitting at MAX_DEPTH, so a badly split scene makes a
+ *				large leaf instead of a tree deeper than the stack.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// A node of the bounding volume hierarchy
+struct BvhNode {
+	AABB bounds;				// Bounds of every item below this node
+	int rightOrFirst;			// Interior node: index of the right child. Leaf: first entry in the item order
+	int count;					// Number of items in a leaf, 0 for interior nodes
+};
+
+/* This class holds a bounding volume hierarchy over a list of bounding boxes.
+*  Items are referred to by their index in the list passed to Build
+*/
+class Bvh {
+private:
+	static const int NUM_BINS = 12;			// Number of candidate split positions tested per axis
+	static const int MAX_LEAF_ITEMS = 4;	// Leaves above MAX_DEPTH never hold more items than this
+	static const int STACK_SIZE = 128;		// Traversal stack depth
+	static const int MAX_DEPTH = STACK_SIZE / 2;	// Deepest level of the tree. Nodes here are leaves however many items they hold
+	static const int SUBTREE_DEPTH = 4;		// Level of the subtrees handed out for culling, up to 16 of them
+	std::vector<BvhNode> nodes;				// Nodes in depth first order, root first
+	std::vector<int> itemOrder;				// Item indices ordered so every leaf references a contiguous range
+	std::vector<AABB> itemBounds;			// Bounds of each item
+	std::vector<glm::vec3> centroids;		// Center of each item's bounds, used while building
+	std::vector<int> subtrees;				// Roots of the subtrees at SUBTREE_DEPTH and leaves above it
+
+	// Build the node for a range of the item order at a depth below the root and return its index
+	int BuildNode(int first, int count, int depth);
+	// Area of a box's surface
+	static float SurfaceArea(const AABB& box);
+	// True if the ray hits the box closer than maxDistance
+	static bool RayHitsBox(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance);
+
+public:
+	// Build the hierarchy from scratch
+	void Build(const std::vector<AABB>& bounds);
+	// Update the node bounds after items moved. The number of items must not change
+	void Refit(const std::vector<AABB>& bounds);
+	// True if the hierarchy has been built
+	bool Built() const;
+	// Number of nodes in the hierarchy
+	unsigned int NodeCount() const;
+	// Number of subtrees that together hold every item once
+	unsigned int SubtreeCount() const;
+	// Root node of a subtree
+	int Subtree(unsigned int subtree) const;
+	// Call visit(item, inside) for every item below root in a node at least partly inside the frustum. inside is true if the node was completely inside. A null frustum visits every item as inside
+	template <typename Visit>
+	void CullFrustum(const Frustum* frustum, int root, Visit visit) const;
+	// Find the closest item hit by the ray. hitTest(item, origin, direction, distance) does the exact test
+	template <typename HitTest>
+	int Raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, HitTest hitTest) const;
+	// True if the ray hits any item closer than maxDistance. Cheaper than Raycast for shadow rays
+	template <typename HitTest>
+	bool AnyHit(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HitTest hitTest) const;
+};
+
+// Build the hierarchy from scratch
+void Bvh::Build(const std::vector<AABB>& bounds) {
+	nodes.clear();
+	subtrees.clear();
+	itemBounds = bounds;
+	itemOrder.resize(bounds.size());
+	centroids.resize(bounds.size());
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		itemOrder[i] = i;
+		centroids[i] = bounds[i].Center();
+	}
+	if (bounds.empty()) {
+		return;
+	}
+	// A binary tree with at least one item per leaf has fewer than twice as many nodes as items
+	nodes.reserve(bounds.size() * 2);
+	BuildNode(0, (int)bounds.size(), 0);
+}
+
+// Build the node for a range of the item order and return its index
+int Bvh::BuildNode(int first, int count, int depth) {
+	int index = (int)nodes.size();
+	nodes.push_back(BvhNode());
+
+	AABB bounds;
+	AABB centroidBounds;
+	for (int i = first; i < first + count; i++) {
+		bounds.Expand(itemBounds[itemOrder[i]]);
+		centroidBounds.Expand(centroids[itemOrder[i]]);
+	}
+	nodes[index].bounds = bounds;
+
+	// Find the cheapest split by binning the item centers along each axis
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestBin = 0;
+	for (int axis = 0; axis < 3 && count > 1; axis++) {
+		float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+		float binScale = NUM_BINS / extent;
+		// Centers too close together to bin, where the scale would overflow, are treated like centers in one place
+		if (extent <= 0.0f || !std::isfinite(binScale)) {
+			continue;
+		}
+		int binCounts[NUM_BINS] = {};
+		AABB binBounds[NUM_BINS];
+		for (int i = first; i < first + count; i++) {
+			int bin = std::max(0, std::min(NUM_BINS - 1, (int)((centroids[itemOrder[i]][axis] - centroidBounds.min[axis]) * binScale)));
+			binCounts[bin]++;
+			binBounds[bin].Expand(itemBounds[itemOrder[i]]);
+		}
+		// Sweep from the right to get the cost of everything right of each split
+		float rightCost[NUM_BINS];
+		AABB rightBounds;
+		int rightCount = 0;
+		for (int bin = NUM_BINS - 1; bin > 0; bin--) {
+			rightBounds.Expand(binBounds[bin]);
+			rightCount += binCounts[bin];
+			rightCost[bin] = rightCount * SurfaceArea(rightBounds);
+		}
+		// Sweep from the left and combine
+		AABB leftBounds;
+		int leftCount = 0;
+		for (int bin = 0; bin < NUM_BINS - 1; bin++) {
+			leftBounds.Expand(binBounds[bin]);
+			leftCount += binCounts[bin];
+			if (leftCount == 0 || leftCount == count) {
+				continue;
+			}
+			float cost = leftCount * SurfaceArea(leftBounds) + rightCost[bin + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = bin;
+			}
+		}
+	}
+
+	// Make a leaf when splitting would not be cheaper than testing every item, or when a deeper tree would overflow the traversal stack
+	float leafCost = count * SurfaceArea(bounds);
+	if (count == 1 || depth >= MAX_DEPTH || (count <= MAX_LEAF_ITEMS && (bestAxis < 0 || bestCost >= leafCost))) {
+		nodes[index].rightOrFirst = first;
+		nodes[index].count = count;
+		if (depth <= SUBTREE_DEPTH) {
+			subtrees.push_back(index);
+		}
+		return index;
+	}
+	if (depth == SUBTREE_DEPTH) {
+		subtrees.push_back(index);
+	}
+
+	int middle;
+	if (bestAxis >= 0) {
+		// Move items in bins left of the split to the front of the range
+		float minimum = centroidBounds.min[bestAxis];
+		float binScale = NUM_BINS / (centroidBounds.max[bestAxis] - minimum);
+		int* split = std::partition(&itemOrder[first], &itemOrder[first] + count, [&](int item) {
+			return std::max(0, std::min(NUM_BINS - 1, (int)((centroids[item][bestAxis] - minimum) * binScale))) <= bestBin;
+		});
+		middle = (int)(split - &itemOrder[0]);
+	}
+	else {
+		// Every center is in the same place, so split the range in half
+		middle = first + count / 2;
+	}
+
+	BuildNode(first, middle - first, depth + 1);
+	int right = BuildNode(middle, first + count - middle, depth + 1);
+	nodes[index].rightOrFirst = right;
+	nodes[index].count = 0;
+	return index;
+}
+
+// Update the node bounds after items moved
+void Bvh::Refit(const std::vector<AABB>& bounds) {
+	itemBounds = bounds;
+	// Children are always stored after their parent, so walking backwards visits children first
+	for (int i = (int)nodes.size() - 1; i >= 0; i--) {
+		BvhNode& node = nodes[i];
+		node.bounds = AABB();
+		if (node.count > 0) {
+			for (int item = node.rightOrFirst; item < node.rightOrFirst + node.count; item++) {
+				node.bounds.Expand(itemBounds[itemOrder[item]]);
+			}
+		}
+		else {
+			node.bounds.Expand(nodes[i + 1].bounds);
+			node.bounds.Expand(nodes[node.rightOrFirst].bounds);
+		}
+	}
+}
+
+// True if the hierarchy has been built
+bool Bvh::Built() const {
+	return !nodes.empty();
+}
+
+// Number of nodes in the hierarchy
+unsigned int Bvh::NodeCount() const {
+	return (unsigned int)nodes.size();
+}
+
+// Number of subtrees that together hold every item once
+unsigned int Bvh::SubtreeCount() const {
+	return (unsigned int)subtrees.size();
+}
+
+// Root node of a subtree
+int Bvh::Subtree(unsigned int subtree) const {
+	return subtrees[subtree];
+}
+
+// Call visit(item, inside) for every item below root in a node at least partly inside the frustum
+template <typename Visit>
+void Bvh::CullFrustum(const Frustum* frustum, int root, Visit visit) const {
+	// Each entry is a node index and whether its parent was completely inside the frustum
+	int stack[STACK_SIZE];
+	bool insideStack[STACK_SIZE];
+	int top = 0;
+	stack[top] = root;
+	insideStack[top++] = frustum == nullptr;
+	while (top > 0) {
+		top--;
+		const BvhNode& node = nodes[stack[top]];
+		bool inside = insideStack[top];
+		int nodeIndex = stack[top];
+		// Children of a node completely inside the frustum do not need testing
+		if (!inside) {
+			FrustumResult result = frustum->Classify(node.bounds);
+			if (result == OUTSIDE) {
+				continue;
+			}
+			inside = result == INSIDE;
+		}
+		if (node.count > 0) {
+			for (int i = node.rightOrFirst; i < node.rightOrFirst + node.count; i++) {
+				visit(itemOrder[i], inside);
+			}
+		}
+		else {
+			stack[top] = node.rightOrFirst;
+			insideStack[top++] = inside;
+			stack[top] = nodeIndex + 1;
+			insideStack[top++] = inside;
+		}
+	}
+}
+
+// Find the closest item hit by the ray
+template <typename HitTest>
+int Bvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, HitTest hitTest) const {
+	int closestItem = -1;
+	distance = FLT_MAX;
+	if (nodes.empty()) {
+		return closestItem;
+	}
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	int stack[STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		int nodeIndex = stack[--top];
+		const BvhNode& node = nodes[nodeIndex];
+		if (!RayHitsBox(node.bounds, origin, inverseDirection, distance)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (int i = node.rightOrFirst; i < node.rightOrFirst + node.count; i++) {
+				int item = itemOrder[i];
+				float itemDistance;
+				if (RayHitsBox(itemBounds[item], origin, inverseDirection, distance) && hitTest(item, origin, direction, itemDistance) && itemDistance < distance) {
+					distance = itemDistance;
+					closestItem = item;
+				}
+			}
+		}
+		else {
+			stack[top++] = node.rightOrFirst;
+			stack[top++] = nodeIndex + 1;
+		}
+	}
+	return closestItem;
+}
+
+// True if the ray hits any item closer than maxDistance
+template <typename HitTest>
+bool Bvh::AnyHit(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HitTest hitTest) const {
+	if (nodes.empty()) {
+		return false;
+	}
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	int stack[STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		int nodeIndex = stack[--top];
+		const BvhNode& node = nodes[nodeIndex];
+		if (!RayHitsBox(node.bounds, origin, inverseDirection, maxDistance)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (int i = node.rightOrFirst; i < node.rightOrFirst + node.count; i++) {
+				float itemDistance;
+				if (hitTest(itemOrder[i], origin, direction, itemDistance) && itemDistance < maxDistance) {
+					return true;
+				}
+			}
+		}
+		else {
+			stack[top++] = node.rightOrFirst;
+			stack[top++] = nodeIndex + 1;
+		}
+	}
+	return false;
+}
+
+// Area of a box's surface
+float Bvh::SurfaceArea(const AABB& box) {
+	if (box.Empty()) {
+		return 0.0f;
+	}
+	glm::vec3 size = box.max - box.min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// Slab test. True if the ray enters the box before maxDistance
+bool Bvh::RayHitsBox(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) {
+	float tMin = 0.0f;
+	float tMax = maxDistance;
+	for (int axis = 0; axis < 3; axis++) {
+		float t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+		float t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+		tMin = std::max(tMin, std::min(t1, t2));
+		tMax = std::min(tMax, std::max(t1, t2));
+	}
+	return tMin <= tMax;
+}
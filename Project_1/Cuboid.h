@@ -82,6 +82,9 @@ void Cuboid::GenCuboid() {
 	vec3 front(0.0f, 0.0f, 1.0f);
 	vec3 back(0.0f, 0.0f, -1.0f);
 
+	// Room for the 24 vertices up front, so nothing grows one insert at a time
+	vertices.reserve(vertices.size() + 24 * 8);
+
 	vertices.insert(vertices.end(), { originX, originY, originZ, up.x, up.y, up.z, 0.0f, 1.0f * tiles_frontBack});						// Back left top
 	vertices.insert(vertices.end(), { originX + m_width, originY, originZ, up.x, up.y, up.z, 1.0f, 1.0f * tiles_frontBack });			// Back right top
 	vertices.insert(vertices.end(), { originX + m_width, originY, originZ + m_length, up.x, up.y, up.z, 1.0f, 0.0f });					// Front right top
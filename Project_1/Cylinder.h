@@ -23,16 +23,20 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <gl/glew.h>
 
+#include "Arena.h"
+
 #include <vector>
 
+/* Switchable determinator for types of cylinders to create.
+* NONE is a cylinder without top or bottom.
+* BOTH is a cylinder with both top and bottom.
+* BOTTOM is a cylinder with a bottom but no top.
+* TOP is a cylinder with a top but no bottom.
+* Declared outside the namespace below so scene descriptions can hold one
+*/
+enum CylinderType { BOTH, BOTTOM, TOP, NONE };
+
 namespace {
-	/* Switchable determinator for types of cylinders to create.
-	* NONE is a cylinder without top or bottom.
-	* BOTH is a cylinder with both top and bottom.
-	* BOTTOM is a cylinder with a bottom but no top.
-	* TOP is a cylinder with a top but no bottom.
-	*/
-	enum CylinderType { BOTH, BOTTOM, TOP, NONE };
 	using std::vector;
 	using glm::vec3;
 }
@@ -52,9 +56,10 @@ private:
 	CylinderType m_type;					// Type of cylinder
 	vector<GLfloat> vertices;				// Storage for the vertices
 	vector<GLushort> indices;				// Storage for the indices
-	vector<glm::vec2> circleXZ;				// Storage for x and z coordinate for slices around the cylinder
-	vector<GLfloat> topCircle;				// Circle on top of cylinder
-	vector<GLfloat> bottomCircle;			// Circle on bottom of cylinder
+	ArenaScope scratch;						// Gives the temporary storage back to the thread's scratch arena
+	ArenaVector<glm::vec2> circleXZ;		// Storage for x and z coordinate for slices around the cylinder
+	ArenaVector<GLfloat> topCircle;			// Circle on top of cylinder
+	ArenaVector<GLfloat> bottomCircle;		// Circle on bottom of cylinder
 
 public:
 	// Parameterized constructor for a cylidner
@@ -68,8 +73,9 @@ public:
 	vector<GLushort> GetIndices();			// Storage for the indices
 };
 
-// Parameterized constructor for a cylidner
-Cylinder::Cylinder(float height, float radius, float x, float y, float z, CylinderType type) {
+// Parameterized constructor for a cylidner. The temporary storage is taken from the scratch arena of the thread building the cylinder
+Cylinder::Cylinder(float height, float radius, float x, float y, float z, CylinderType type) : scratch(Arena::Scratch()),
+	circleXZ(ArenaAllocator<glm::vec2>(Arena::Scratch())), topCircle(ArenaAllocator<GLfloat>(Arena::Scratch())), bottomCircle(ArenaAllocator<GLfloat>(Arena::Scratch())) {
 	// Store input values in fields
 	m_height = height;
 	m_radius = radius;
@@ -86,12 +92,23 @@ void Cylinder::GenCylinder() {
 	GLfloat tempZ;										// Temporary Z value
 	GLfloat tempCos;									// Temporary Cos value
 	GLfloat tempSin;									// Temporary Sin value
-	vector<GLfloat> sines;
-	vector<GLfloat> cosines;
+	ArenaVector<GLfloat> sines(ArenaAllocator<GLfloat>(Arena::Scratch()));
+	ArenaVector<GLfloat> cosines(ArenaAllocator<GLfloat>(Arena::Scratch()));
 	glm::vec3 tempNormal;
 	glm::vec2 tempCircleXZ;
 	glm::vec3 up(0.0f, 1.0f, 0.0f);
 	glm::vec3 down(0.0f, -1.0f, 0.0f);
+
+	// Room for every slice and both caps up front, so nothing grows one push at a time
+	unsigned int ring = m_numSlices + 1;
+	sines.reserve(ring);
+	cosines.reserve(ring);
+	circleXZ.reserve(ring);
+	bottomCircle.reserve((ring + 1) * 8);
+	topCircle.reserve((ring + 1) * 8);
+	vertices.reserve((ring * 2 + (ring + 1) * 2) * 8);
+	indices.reserve(m_numSlices * 12);
+
 	// Loop for the number of slices requested
 	for (int i = 0; i < m_numSlices; i++) {
 		// Slice x = originX + radius * cosine (2*PI*Angle)
@@ -0,0 +1,291 @@
+#pragma once
+/* EntityWorld.h : This file contains the code necessary to store the
+ *      placed meshes and lights of the scene as entities. An entity is
+ *		only a number. What it is made of is decided by the components
+ *		it has: a transform, the mesh it draws, its material, its
+ *		bounds, and its light if it is one.
+ *
+ *				Each kind of component is kept packed in its own array,
+ *				in the order the components were added, with a table from
+ *				entity to slot for lookups. The per-frame work in
+ *				Project_1.cpp walks these arrays from front to back
+ *				instead of chasing meshes spread across the scene, so it
+ *				stays cheap as the number of objects grows.
+ *
+ *				Visibility is one byte per entity, written by culling and
+ *				read when the draw list is built.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// An entity is its index in the world
+typedef uint32_t Entity;
+
+// Where an entity is
+struct TransformComponent {
+	glm::mat4 model = glm::mat4(1.0f);		// Model matrix, copied from the scene graph when the node moves
+	int node = -1;							// Scene graph node that places the entity
+};
+
+// Buffers an entity is drawn with. The buffers belong to its mesh or to a shape in the geometry cache
+struct MeshComponent {
+	GLuint vao = 0;							// Vertex array of the welded vertices
+	GLuint indexCount = 0;
+	GLintptr indexOffset = 0;				// Byte offset of the first index in the vertex array's index buffer
+	GLuint lightmapVao = 0;					// Vertex array with lightmap UVs, 0 until a lightmap is baked
+	GLuint lightmapVertexCount = 0;
+	glm::vec4 lightmapScaleOffset = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);	// Maps the mesh's lightmap UVs into the atlas
+	int instanceGroup = -1;					// Group that draws this entity together with other copies of its shape, -1 if drawn alone
+};
+
+// How an entity is shaded
+struct MaterialComponent {
+	unsigned int material = 0;				// Shader features
+	GLuint texture = 0;
+	bool castsShadow = true;				// Drawn into the shadow maps
+};
+
+// Where an entity's vertices are
+struct BoundsComponent {
+	AABB local;								// Bounds of the vertices before the model matrix is applied
+	AABB world;								// Bounds after the model matrix is applied
+	BoundingSphere sphere;					// Sphere around the world bounds for a quick rejection test
+};
+
+// A light in the scene. Its mesh is drawn in the light's color
+struct LightComponent {
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::vec3 color = glm::vec3(1.0f);		// Color the light shines with now
+	glm::vec3 sceneColor = glm::vec3(1.0f);	// Color from the scene file, restored by F1 and F2
+	float intensity = 0.0f;					// Strength of the specular highlight
+	glm::vec3 target = glm::vec3(0.0f);		// Point the light's shadow map is aimed at, for lights with a spot shadow map
+};
+
+// An entity waiting to be drawn and the key it is sorted by
+struct DrawItem {
+	uint64_t key;
+	Entity entity;
+
+	// Order items by key so draws sharing a program and texture are next to each other
+	bool operator<(const DrawItem& other) const;
+};
+
+/* This class keeps one kind of component packed in an array with a lookup from entity to slot
+*/
+template <class T>
+class ComponentArray {
+private:
+	std::vector<T> components;				// Packed components
+	std::vector<Entity> entities;			// Entity each component belongs to
+	std::vector<int> slots;					// Slot of each entity's component, -1 if it has none
+
+public:
+	// Give an entity a component, replacing the one it had. Returns the stored component
+	T& Add(Entity entity, const T& component);
+	// True if the entity has a component of this kind
+	bool Has(Entity entity) const;
+	// Component of an entity that has one
+	T& Get(Entity entity);
+	const T& Get(Entity entity) const;
+	// Number of components
+	unsigned int Size() const;
+	// Component in a slot, for walking the array in order
+	T& At(unsigned int slot);
+	const T& At(unsigned int slot) const;
+	// Entity of the component in a slot
+	Entity EntityAt(unsigned int slot) const;
+	// Remove every component
+	void Clear();
+};
+
+/* This class hands out entities and holds their components
+*/
+class EntityWorld {
+private:
+	Entity count;							// Entities created since the last Clear
+	ComponentArray<TransformComponent> transforms;
+	ComponentArray<MeshComponent> meshes;
+	ComponentArray<MaterialComponent> materials;
+	ComponentArray<BoundsComponent> bounds;
+	ComponentArray<LightComponent> lights;
+	std::vector<uint8_t> visible;			// 1 if the entity passed culling this frame
+
+public:
+	// Constructor
+	EntityWorld();
+	// Make a new entity with no components
+	Entity Create();
+	// Remove every entity and component
+	void Clear();
+	// Number of entities
+	unsigned int Count() const;
+
+	// Component arrays
+	ComponentArray<TransformComponent>& Transforms();
+	ComponentArray<MeshComponent>& Meshes();
+	ComponentArray<MaterialComponent>& Materials();
+	ComponentArray<BoundsComponent>& Bounds();
+	ComponentArray<LightComponent>& Lights();
+
+	// Visibility decided by culling
+	bool Visible(Entity entity) const;
+	void SetVisible(Entity entity, bool value);
+	void SetAllVisible(bool value);
+
+	// Draw key of an entity that is not drawn. SortKey never returns it
+	static const uint64_t HIDDEN_KEY = UINT64_MAX;
+	// Sort key that puts lightmapped draws together, then draws with the same material, texture, and vertex array
+	static uint64_t SortKey(bool lightmapped, unsigned int material, GLuint texture, GLuint vao);
+};
+
+// Order items by key
+bool DrawItem::operator<(const DrawItem& other) const {
+	return key < other.key;
+}
+
+// Give an entity a component
+template <class T>
+T& ComponentArray<T>::Add(Entity entity, const T& component) {
+	if (entity >= slots.size()) {
+		slots.resize(entity + 1, -1);
+	}
+	if (slots[entity] >= 0) {
+		components[slots[entity]] = component;
+		return components[slots[entity]];
+	}
+	slots[entity] = components.size();
+	components.push_back(component);
+	entities.push_back(entity);
+	return components.back();
+}
+
+// True if the entity has a component of this kind
+template <class T>
+bool ComponentArray<T>::Has(Entity entity) const {
+	return entity < slots.size() && slots[entity] >= 0;
+}
+
+// Component of an entity
+template <class T>
+T& ComponentArray<T>::Get(Entity entity) {
+	return components[slots[entity]];
+}
+
+// Component of an entity
+template <class T>
+const T& ComponentArray<T>::Get(Entity entity) const {
+	return components[slots[entity]];
+}
+
+// Number of components
+template <class T>
+unsigned int ComponentArray<T>::Size() const {
+	return components.size();
+}
+
+// Component in a slot
+template <class T>
+T& ComponentArray<T>::At(unsigned int slot) {
+	return components[slot];
+}
+
+// Component in a slot
+template <class T>
+const T& ComponentArray<T>::At(unsigned int slot) const {
+	return components[slot];
+}
+
+// Entity of the component in a slot
+template <class T>
+Entity ComponentArray<T>::EntityAt(unsigned int slot) const {
+	return entities[slot];
+}
+
+// Remove every component
+template <class T>
+void ComponentArray<T>::Clear() {
+	components.clear();
+	entities.clear();
+	slots.clear();
+}
+
+// Constructor
+EntityWorld::EntityWorld() {
+	count = 0;
+}
+
+// Make a new entity
+Entity EntityWorld::Create() {
+	visible.push_back(1);
+	return count++;
+}
+
+// Remove every entity and component
+void EntityWorld::Clear() {
+	count = 0;
+	transforms.Clear();
+	meshes.Clear();
+	materials.Clear();
+	bounds.Clear();
+	lights.Clear();
+	visible.clear();
+}
+
+// Number of entities
+unsigned int EntityWorld::Count() const {
+	return count;
+}
+
+// Component arrays
+ComponentArray<TransformComponent>& EntityWorld::Transforms() {
+	return transforms;
+}
+
+ComponentArray<MeshComponent>& EntityWorld::Meshes() {
+	return meshes;
+}
+
+ComponentArray<MaterialComponent>& EntityWorld::Materials() {
+	return materials;
+}
+
+ComponentArray<BoundsComponent>& EntityWorld::Bounds() {
+	return bounds;
+}
+
+ComponentArray<LightComponent>& EntityWorld::Lights() {
+	return lights;
+}
+
+// Visibility decided by culling
+bool EntityWorld::Visible(Entity entity) const {
+	return visible[entity] != 0;
+}
+
+void EntityWorld::SetVisible(Entity entity, bool value) {
+	visible[entity] = value ? 1 : 0;
+}
+
+void EntityWorld::SetAllVisible(bool value) {
+	std::fill(visible.begin(), visible.end(), value ? 1 : 0);
+}
+
+// Sort key for a draw
+uint64_t EntityWorld::SortKey(bool lightmapped, unsigned int material, GLuint texture, GLuint vao) {
+	// Program changes cost the most, so the material is above the texture and the vertex array is last.
+	// Bit 62 is never set, which keeps every key below HIDDEN_KEY
+	return ((uint64_t)(lightmapped ? 0 : 1) << 63) | ((uint64_t)(material & 0x3FFF) << 48) | ((uint64_t)(texture & 0xFFFF) << 32) | vao;
+}
@@ -0,0 +1,170 @@
+#pragma once
+/* FramePacer.h : This file contains the code necessary to hold the
+ *      frame rate to a target and to give the rest of the program a
+ *		steady frame time. Without a limit the scene redraws an
+ *		unchanged room as fast as the GPU allows, which wastes power.
+ *
+ *				Waiting sleeps in short steps while there is comfortably
+ *				more time left than a sleep tends to take, then spins for
+ *				the rest. How long a sleep really takes is measured as the
+ *				program runs, so the spin stays short on systems with fine
+ *				timers and grows on systems with coarse ones.
+ *
+ *				Frame times are clamped and averaged over the last few
+ *				frames so one slow frame does not make the camera jump.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+/* This class limits the frame rate and smooths the time between frames
+*/
+class FramePacer {
+private:
+	typedef std::chrono::steady_clock Clock;
+	static const int SMOOTHING_FRAMES = 8;		// Frame times averaged for the smoothed delta
+	const double MAX_DELTA = 0.1;				// Longest frame time passed on, so a stall does not move the camera far
+	const double SLEEP_STEP = 0.001;			// Length of each sleep while waiting
+
+	double targetFrameTime;						// Seconds per frame, 0 for no limit
+	Clock::time_point nextFrame;				// When the next frame may start
+	Clock::time_point lastTick;					// Start of the previous frame
+	bool started;								// True once the first frame has started
+	double deltas[SMOOTHING_FRAMES];			// Recent frame times
+	int deltaCount;								// Frame times recorded so far, up to SMOOTHING_FRAMES
+	int nextDelta;								// Slot the next frame time is written to
+	double rawDelta;							// Time between the last two frames before smoothing
+
+	// Running mean and variance of how long a sleep of SLEEP_STEP really takes
+	double sleepEstimate;						// Mean plus one standard deviation, the time kept back for spinning
+	double sleepMean;
+	double sleepM2;
+	long long sleepCount;
+
+	// Sleep once and update the estimate of how long sleeps take
+	void MeasuredSleep();
+
+public:
+	// Constructor
+	FramePacer();
+	// Limit the frame rate. 0 removes the limit
+	void SetTargetFps(double fps);
+	// Frame rate limit, 0 if there is none
+	double TargetFps() const;
+	// Mark the start of a frame. Returns the smoothed time since the previous frame in seconds
+	float Tick();
+	// Time between the last two frames before clamping and smoothing
+	double RawDelta() const;
+	// Forget the frame time history after the loop has stopped drawing, so the next frame starts with no delta
+	void Restart();
+	// Block until the next frame is due
+	void Wait();
+};
+
+// Constructor
+FramePacer::FramePacer() {
+	targetFrameTime = 0.0;
+	started = false;
+	deltaCount = 0;
+	nextDelta = 0;
+	rawDelta = 0.0;
+	for (int i = 0; i < SMOOTHING_FRAMES; i++) {
+		deltas[i] = 0.0;
+	}
+	sleepEstimate = SLEEP_STEP * 2.0;
+	sleepMean = SLEEP_STEP * 2.0;
+	sleepM2 = 0.0;
+	sleepCount = 1;
+}
+
+// Limit the frame rate
+void FramePacer::SetTargetFps(double fps) {
+	double frameTime = fps > 0.0 ? 1.0 / fps : 0.0;
+	if (frameTime == targetFrameTime) {
+		return;
+	}
+	targetFrameTime = frameTime;
+	// Start counting from now so a change of limit does not leave an old deadline behind
+	nextFrame = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(targetFrameTime));
+}
+
+// Frame rate limit, 0 if there is none
+double FramePacer::TargetFps() const {
+	return targetFrameTime > 0.0 ? 1.0 / targetFrameTime : 0.0;
+}
+
+// Mark the start of a frame
+float FramePacer::Tick() {
+	Clock::time_point now = Clock::now();
+	if (!started) {
+		started = true;
+		lastTick = now;
+		return 0.0f;
+	}
+	rawDelta = std::chrono::duration<double>(now - lastTick).count();
+	lastTick = now;
+
+	deltas[nextDelta] = rawDelta < MAX_DELTA ? rawDelta : MAX_DELTA;
+	nextDelta = (nextDelta + 1) % SMOOTHING_FRAMES;
+	if (deltaCount < SMOOTHING_FRAMES) {
+		deltaCount++;
+	}
+	double sum = 0.0;
+	for (int i = 0; i < deltaCount; i++) {
+		sum += deltas[i];
+	}
+	return (float)(sum / deltaCount);
+}
+
+// Time between the last two frames before clamping and smoothing
+double FramePacer::RawDelta() const {
+	return rawDelta;
+}
+
+// Forget the frame time history after the loop has stopped drawing
+void FramePacer::Restart() {
+	started = false;
+	deltaCount = 0;
+	nextDelta = 0;
+}
+
+// Sleep once and update the estimate of how long sleeps take
+void FramePacer::MeasuredSleep() {
+	Clock::time_point before = Clock::now();
+	std::this_thread::sleep_for(std::chrono::duration<double>(SLEEP_STEP));
+	double slept = std::chrono::duration<double>(Clock::now() - before).count();
+
+	// Welford's method keeps the mean and variance without storing samples
+	sleepCount++;
+	double difference = slept - sleepMean;
+	sleepMean += difference / sleepCount;
+	sleepM2 += difference * (slept - sleepMean);
+	sleepEstimate = sleepMean + std::sqrt(sleepM2 / (sleepCount - 1));
+}
+
+// Block until the next frame is due
+void FramePacer::Wait() {
+	if (targetFrameTime <= 0.0) {
+		return;
+	}
+	// Sleep while a sleep is very likely to finish before the deadline
+	while (std::chrono::duration<double>(nextFrame - Clock::now()).count() > sleepEstimate) {
+		MeasuredSleep();
+	}
+	// Spin for what is left
+	while (Clock::now() < nextFrame) {
+		std::this_thread::yield();
+	}
+	// Frames are due at fixed steps. After a slow frame the schedule restarts instead of rushing to catch up
+	Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(targetFrameTime));
+	nextFrame += step;
+	Clock::time_point now = Clock::now();
+	if (nextFrame < now) {
+		nextFrame = now + step;
+	}
+}
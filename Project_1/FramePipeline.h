@@ -0,0 +1,142 @@
+#pragma once
+/* FramePipeline.h : This file contains the code necessary to pass
+ *      frames between the simulation thread and the render thread
+ *		without either one waiting on the other.
+ *
+ *				A triple buffer holds three copies of a value. The writer
+ *				fills one, the reader works from another, and the third is
+ *				the latest finished copy. Publishing swaps the writer's copy
+ *				with the latest one and taking swaps the reader's copy with
+ *				it, each with one atomic exchange, so neither side ever
+ *				blocks. If the writer publishes twice before the reader
+ *				takes, the older copy is simply replaced. A writer that
+ *				needs every copy read checks Pending and sleeps on a wake
+ *				signal the reader sends after each take, rather than
+ *				spinning on Pending while the reader works.
+ *
+ *				Wake signals let either thread sleep until the other one
+ *				has done its part: the reader while there is nothing new
+ *				to draw, the writer while its last copy is still pending.
+ *				They only carry the wake up, never the frame itself.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/* This class hands the latest copy of a value from one writer thread to one reader thread without locks
+*/
+template <class T>
+class TripleBuffer {
+private:
+	static const unsigned int SLOT_MASK = 3;	// Bits of the shared index that name a slot
+	static const unsigned int NEW_BIT = 4;		// Set in the shared index when its slot was published and not taken yet
+
+	T slots[3];
+	std::atomic<unsigned int> shared;			// Slot holding the latest published copy, plus NEW_BIT
+	unsigned int writeSlot;						// Slot only the writer touches
+	unsigned int readSlot;						// Slot only the reader touches
+
+public:
+	// Constructor
+	TripleBuffer();
+	// Copy the writer fills before publishing it
+	T& WriteSlot();
+	// Make the filled copy the latest one
+	void Publish();
+	// Take the latest copy if one was published since the last take. Returns false if there is nothing new
+	bool Acquire();
+	// True if a published copy has not been taken yet
+	bool Pending() const;
+	// Copy the reader took last
+	const T& ReadSlot() const;
+};
+
+/* This class wakes a sleeping thread, remembering a wake up sent before the thread started waiting
+*/
+class WakeSignal {
+private:
+	std::mutex lock;
+	std::condition_variable condition;
+	bool signalled;
+
+public:
+	// Constructor
+	WakeSignal();
+	// Wake the waiting thread
+	void Notify();
+	// Sleep until notified or until the timeout passes. Returns true if notified
+	bool Wait(double seconds);
+};
+
+// Constructor
+template <class T>
+TripleBuffer<T>::TripleBuffer() {
+	writeSlot = 0;
+	shared = 1;
+	readSlot = 2;
+}
+
+// Copy the writer fills
+template <class T>
+T& TripleBuffer<T>::WriteSlot() {
+	return slots[writeSlot];
+}
+
+// Make the filled copy the latest one
+template <class T>
+void TripleBuffer<T>::Publish() {
+	// Release makes the writes to the slot visible to the reader that takes it
+	writeSlot = shared.exchange(writeSlot | NEW_BIT, std::memory_order_acq_rel) & SLOT_MASK;
+}
+
+// Take the latest copy if there is a new one
+template <class T>
+bool TripleBuffer<T>::Acquire() {
+	// Only the reader clears NEW_BIT, so once it is seen the exchange below always gets a new copy
+	if ((shared.load(std::memory_order_acquire) & NEW_BIT) == 0) {
+		return false;
+	}
+	readSlot = shared.exchange(readSlot, std::memory_order_acq_rel) & SLOT_MASK;
+	return true;
+}
+
+// True if a published copy has not been taken yet
+template <class T>
+bool TripleBuffer<T>::Pending() const {
+	return (shared.load(std::memory_order_acquire) & NEW_BIT) != 0;
+}
+
+// Copy the reader took last
+template <class T>
+const T& TripleBuffer<T>::ReadSlot() const {
+	return slots[readSlot];
+}
+
+// Constructor
+WakeSignal::WakeSignal() {
+	signalled = false;
+}
+
+// Wake the waiting thread
+void WakeSignal::Notify() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		signalled = true;
+	}
+	condition.notify_one();
+}
+
+// Sleep until notified or until the timeout passes
+bool WakeSignal::Wait(double seconds) {
+	std::unique_lock<std::mutex> guard(lock);
+	condition.wait_for(guard, std::chrono::duration<double>(seconds), [this]() { return signalled; });
+	bool woken = signalled;
+	signalled = false;
+	return woken;
+}
@@ -0,0 +1,87 @@
+#pragma once
+/* FrameUniforms.h : This file contains the code necessary to share the
+ *      camera and lighting values of a frame with every shader program
+ *		through one uniform buffer. The values are written once per
+ *		frame instead of once for every program that uses them.
+ *
+ *				Each frame's copy is allocated from the frame ring buffer,
+ *				which keeps it from overwriting a copy the GPU has not
+ *				finished reading.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+#include "RingBuffer.h"
+
+#include <glm/glm.hpp>
+
+#include <cstring>
+
+// Values in the FrameData uniform block declared in shaders/frame_data.glsl. Laid out by the std140 rules, so every vec3 is padded to 16 bytes
+struct FrameUniformData {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 light2ViewProjection;		// Fill light's shadow map view projection
+	glm::vec3 viewPosition;
+	float specularIntensity1;			// Intensity of the key light
+	glm::vec3 lightPos;
+	float specularIntensity2;			// Intensity of the fill light
+	glm::vec3 lightColor;
+	float lightFarPlane;				// Far plane of the key light's shadow cube
+	glm::vec3 light2Pos;
+	float padding0;
+	glm::vec3 light2Color;
+	float padding1;
+	glm::vec3 objectColor;
+	float padding2;
+	glm::vec2 uvScale;
+	glm::vec2 padding3;
+};
+static_assert(sizeof(FrameUniformData) == 304, "FrameUniformData must match the std140 layout of FrameData");
+
+/* This class writes the FrameData block into the frame's ring buffer allocation and binds it
+*/
+class FrameUniforms {
+private:
+	GLsizeiptr alignment;					// Uniform buffer offset alignment of the driver
+
+public:
+	static const GLuint BINDING = 0;		// Binding point of the FrameData block, set in the shaders
+
+	// Constructor
+	FrameUniforms();
+	// Read the offset alignment. Needs a current context
+	void Create();
+	// Write this frame's values into the ring and bind them to the FrameData binding point. Returns false if the ring is full
+	bool Update(RingBuffer& ring, const FrameUniformData& data);
+};
+
+// Constructor
+FrameUniforms::FrameUniforms() {
+	alignment = 256;
+}
+
+// Read the offset alignment
+void FrameUniforms::Create() {
+	GLint value = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+	if (value > 0) {
+		alignment = value;
+	}
+}
+
+// Write this frame's values into the ring and bind them to the FrameData binding point
+bool FrameUniforms::Update(RingBuffer& ring, const FrameUniformData& data) {
+	RingAllocation allocation = ring.Allocate(sizeof(data), alignment);
+	if (!allocation.data) {
+		return false;
+	}
+	memcpy(allocation.data, &data, sizeof(data));
+	ring.Commit(allocation);
+	glBindBufferRange(GL_UNIFORM_BUFFER, BINDING, ring.Buffer(), allocation.offset, allocation.size);
+	return true;
+}
@@ -0,0 +1,293 @@
+#pragma once
+/* Frustum.h : This file contains the code necessary to cull objects
+ *      that are outside of the camera's view. Bounding boxes and
+ *		bounding spheres are tested against the six planes of the
+ *		view frustum, four planes at a time using SSE when available.
+ *
+ *				The frustum is extracted from projection * view, so
+ *				planes are in world space and meshes are tested with
+ *				their world space bounds.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include <cfloat>
+
+// SSE is available on every x86/x64 target the project is built for
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+// Axis aligned bounding box
+struct AABB {
+	glm::vec3 min = glm::vec3(FLT_MAX);		// Smallest x, y, and z
+	glm::vec3 max = glm::vec3(-FLT_MAX);	// Largest x, y, and z
+
+	// Grow the box to contain a point
+	void Expand(const glm::vec3& point);
+	// Grow the box to contain another box
+	void Expand(const AABB& box);
+	// True if nothing has been added to the box
+	bool Empty() const;
+	// Center of the box
+	glm::vec3 Center() const;
+	// Half the size of the box along each axis
+	glm::vec3 Extents() const;
+	// Box containing this box after it is transformed by a matrix
+	AABB Transform(const glm::mat4& matrix) const;
+};
+
+// Result of testing bounds against the frustum
+enum FrustumResult { OUTSIDE, INTERSECTS, INSIDE };
+
+// Bounding sphere
+struct BoundingSphere {
+	glm::vec3 center = glm::vec3(0.0f);		// Center of the sphere
+	float radius = 0.0f;					// Radius of the sphere
+};
+
+/* This class holds the six planes of a view frustum and tests bounds against them
+*/
+class Frustum {
+private:
+	static const int NUM_PLANES = 6;		// Left, right, bottom, top, near, far
+	// Planes are stored as structure of arrays padded to eight so two groups of four are tested at once
+	alignas(16) float planeX[8];			// X component of each plane normal
+	alignas(16) float planeY[8];			// Y component of each plane normal
+	alignas(16) float planeZ[8];			// Z component of each plane normal
+	alignas(16) float planeD[8];			// Distance of each plane from the origin
+
+public:
+	// Default constructor accepts everything
+	Frustum();
+	// Extract the planes from a combined projection * view matrix
+	void Update(const glm::mat4& viewProjection);
+	// True if the sphere is at least partly inside the frustum
+	bool Intersects(const BoundingSphere& sphere) const;
+	// True if the box is at least partly inside the frustum
+	bool Intersects(const AABB& box) const;
+	// Determine if the box is outside, partly inside, or completely inside the frustum
+	FrustumResult Classify(const AABB& box) const;
+};
+
+// Grow the box to contain a point
+void AABB::Expand(const glm::vec3& point) {
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+// Grow the box to contain another box
+void AABB::Expand(const AABB& box) {
+	if (box.Empty()) {
+		return;
+	}
+	min = glm::min(min, box.min);
+	max = glm::max(max, box.max);
+}
+
+// True if nothing has been added to the box
+bool AABB::Empty() const {
+	return min.x > max.x;
+}
+
+// Center of the box
+glm::vec3 AABB::Center() const {
+	return (min + max) * 0.5f;
+}
+
+// Half the size of the box along each axis
+glm::vec3 AABB::Extents() const {
+	return (max - min) * 0.5f;
+}
+
+// Transform the center and project the extents onto the new axes (Arvo's method)
+AABB AABB::Transform(const glm::mat4& matrix) const {
+	AABB result;
+	if (Empty()) {
+		return result;
+	}
+	glm::vec3 center = glm::vec3(matrix * glm::vec4(Center(), 1.0f));
+	glm::vec3 extents = Extents();
+	glm::vec3 newExtents(0.0f);
+	for (int row = 0; row < 3; row++) {
+		for (int col = 0; col < 3; col++) {
+			newExtents[row] += std::fabs(matrix[col][row]) * extents[col];
+		}
+	}
+	result.min = center - newExtents;
+	result.max = center + newExtents;
+	return result;
+}
+
+// Default constructor. Planes with a huge distance never reject anything
+Frustum::Frustum() {
+	for (int i = 0; i < 8; i++) {
+		planeX[i] = 0.0f;
+		planeY[i] = 0.0f;
+		planeZ[i] = 0.0f;
+		planeD[i] = FLT_MAX;
+	}
+}
+
+// Extract the planes using the Gribb/Hartmann method
+void Frustum::Update(const glm::mat4& viewProjection) {
+	// GLM is column major so a row is made from the same element of each column
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++) {
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	}
+	glm::vec4 planes[NUM_PLANES] = {
+		rows[3] + rows[0],		// Left
+		rows[3] - rows[0],		// Right
+		rows[3] + rows[1],		// Bottom
+		rows[3] - rows[1],		// Top
+		rows[3] + rows[2],		// Near
+		rows[3] - rows[2]		// Far
+	};
+	for (int i = 0; i < NUM_PLANES; i++) {
+		float length = glm::length(glm::vec3(planes[i]));
+		planeX[i] = planes[i].x / length;
+		planeY[i] = planes[i].y / length;
+		planeZ[i] = planes[i].z / length;
+		planeD[i] = planes[i].w / length;
+	}
+	// Padding planes never reject anything
+	for (int i = NUM_PLANES; i < 8; i++) {
+		planeX[i] = 0.0f;
+		planeY[i] = 0.0f;
+		planeZ[i] = 0.0f;
+		planeD[i] = FLT_MAX;
+	}
+}
+
+// True if the sphere is at least partly inside the frustum
+bool Frustum::Intersects(const BoundingSphere& sphere) const {
+#ifdef FRUSTUM_USE_SSE
+	const __m128 cx = _mm_set1_ps(sphere.center.x);
+	const __m128 cy = _mm_set1_ps(sphere.center.y);
+	const __m128 cz = _mm_set1_ps(sphere.center.z);
+	const __m128 negRadius = _mm_set1_ps(-sphere.radius);
+	for (int i = 0; i < 8; i += 4) {
+		// distance = nx * cx + ny * cy + nz * cz + d for four planes
+		__m128 distance = _mm_add_ps(_mm_mul_ps(_mm_load_ps(&planeX[i]), cx), _mm_load_ps(&planeD[i]));
+		distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(&planeY[i]), cy));
+		distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(&planeZ[i]), cz));
+		// Outside if the sphere is completely behind any plane
+		if (_mm_movemask_ps(_mm_cmplt_ps(distance, negRadius)) != 0) {
+			return false;
+		}
+	}
+	return true;
+#else
+	for (int i = 0; i < NUM_PLANES; i++) {
+		float distance = planeX[i] * sphere.center.x + planeY[i] * sphere.center.y + planeZ[i] * sphere.center.z + planeD[i];
+		if (distance < -sphere.radius) {
+			return false;
+		}
+	}
+	return true;
+#endif
+}
+
+// True if the box is at least partly inside the frustum
+bool Frustum::Intersects(const AABB& box) const {
+	if (box.Empty()) {
+		return false;
+	}
+#ifdef FRUSTUM_USE_SSE
+	const __m128 minX = _mm_set1_ps(box.min.x);
+	const __m128 minY = _mm_set1_ps(box.min.y);
+	const __m128 minZ = _mm_set1_ps(box.min.z);
+	const __m128 maxX = _mm_set1_ps(box.max.x);
+	const __m128 maxY = _mm_set1_ps(box.max.y);
+	const __m128 maxZ = _mm_set1_ps(box.max.z);
+	const __m128 zero = _mm_setzero_ps();
+	for (int i = 0; i < 8; i += 4) {
+		__m128 nx = _mm_load_ps(&planeX[i]);
+		__m128 ny = _mm_load_ps(&planeY[i]);
+		__m128 nz = _mm_load_ps(&planeZ[i]);
+		// The corner furthest along each plane normal gives the largest distance
+		__m128 distance = _mm_add_ps(_mm_max_ps(_mm_mul_ps(nx, minX), _mm_mul_ps(nx, maxX)), _mm_load_ps(&planeD[i]));
+		distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(ny, minY), _mm_mul_ps(ny, maxY)));
+		distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(nz, minZ), _mm_mul_ps(nz, maxZ)));
+		// Outside if even the furthest corner is behind any plane
+		if (_mm_movemask_ps(_mm_cmplt_ps(distance, zero)) != 0) {
+			return false;
+		}
+	}
+	return true;
+#else
+	for (int i = 0; i < NUM_PLANES; i++) {
+		float distance = planeD[i];
+		distance += planeX[i] >= 0.0f ? planeX[i] * box.max.x : planeX[i] * box.min.x;
+		distance += planeY[i] >= 0.0f ? planeY[i] * box.max.y : planeY[i] * box.min.y;
+		distance += planeZ[i] >= 0.0f ? planeZ[i] * box.max.z : planeZ[i] * box.min.z;
+		if (distance < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+#endif
+}
+
+// Determine if the box is outside, partly inside, or completely inside the frustum
+FrustumResult Frustum::Classify(const AABB& box) const {
+	if (box.Empty()) {
+		return OUTSIDE;
+	}
+	bool intersects = false;
+#ifdef FRUSTUM_USE_SSE
+	const __m128 minX = _mm_set1_ps(box.min.x);
+	const __m128 minY = _mm_set1_ps(box.min.y);
+	const __m128 minZ = _mm_set1_ps(box.min.z);
+	const __m128 maxX = _mm_set1_ps(box.max.x);
+	const __m128 maxY = _mm_set1_ps(box.max.y);
+	const __m128 maxZ = _mm_set1_ps(box.max.z);
+	const __m128 zero = _mm_setzero_ps();
+	for (int i = 0; i < 8; i += 4) {
+		__m128 nx = _mm_load_ps(&planeX[i]);
+		__m128 ny = _mm_load_ps(&planeY[i]);
+		__m128 nz = _mm_load_ps(&planeZ[i]);
+		__m128 d = _mm_load_ps(&planeD[i]);
+		// Furthest corner along the normal decides if the box is outside
+		__m128 farDistance = _mm_add_ps(_mm_max_ps(_mm_mul_ps(nx, minX), _mm_mul_ps(nx, maxX)), d);
+		farDistance = _mm_add_ps(farDistance, _mm_max_ps(_mm_mul_ps(ny, minY), _mm_mul_ps(ny, maxY)));
+		farDistance = _mm_add_ps(farDistance, _mm_max_ps(_mm_mul_ps(nz, minZ), _mm_mul_ps(nz, maxZ)));
+		if (_mm_movemask_ps(_mm_cmplt_ps(farDistance, zero)) != 0) {
+			return OUTSIDE;
+		}
+		// Nearest corner along the normal decides if the box crosses the plane
+		__m128 nearDistance = _mm_add_ps(_mm_min_ps(_mm_mul_ps(nx, minX), _mm_mul_ps(nx, maxX)), d);
+		nearDistance = _mm_add_ps(nearDistance, _mm_min_ps(_mm_mul_ps(ny, minY), _mm_mul_ps(ny, maxY)));
+		nearDistance = _mm_add_ps(nearDistance, _mm_min_ps(_mm_mul_ps(nz, minZ), _mm_mul_ps(nz, maxZ)));
+		if (_mm_movemask_ps(_mm_cmplt_ps(nearDistance, zero)) != 0) {
+			intersects = true;
+		}
+	}
+#else
+	for (int i = 0; i < NUM_PLANES; i++) {
+		float farDistance = planeD[i];
+		float nearDistance = planeD[i];
+		farDistance += planeX[i] >= 0.0f ? planeX[i] * box.max.x : planeX[i] * box.min.x;
+		farDistance += planeY[i] >= 0.0f ? planeY[i] * box.max.y : planeY[i] * box.min.y;
+		farDistance += planeZ[i] >= 0.0f ? planeZ[i] * box.max.z : planeZ[i] * box.min.z;
+		nearDistance += planeX[i] >= 0.0f ? planeX[i] * box.min.x : planeX[i] * box.max.x;
+		nearDistance += planeY[i] >= 0.0f ? planeY[i] * box.min.y : planeY[i] * box.max.y;
+		nearDistance += planeZ[i] >= 0.0f ? planeZ[i] * box.min.z : planeZ[i] * box.max.z;
+		if (farDistance < 0.0f) {
+			return OUTSIDE;
+		}
+		if (nearDistance < 0.0f) {
+			intersects = true;
+		}
+	}
+#endif
+	return intersects ? INTERSECTS : INSIDE;
+}
@@ -0,0 +1,202 @@
+#pragma once
+/* GeometryBatch.h : This file contains the code necessary to upload
+ *      the generated vertices of a whole scene at once. Every mesh
+ *		used to get its own vertex and index buffer, each filled with
+ *		its own glBufferData call.
+ *
+ *				Meshes are added once their vertices are generated, which
+ *				gives each one a range in the batch before anything is
+ *				copied. Upload allocates one staging block the size of
+ *				every range, copies the meshes into it on the job
+ *				system's threads, and sends it to the GPU as one vertex
+ *				buffer and one index buffer. Each mesh then gets a vertex
+ *				array whose attributes start at its first vertex, so its
+ *				indices stay relative to its own vertices and only the
+ *				draw call needs the offset of its first index.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+#include "JobSystem.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Where one mesh sits in a batch's buffers
+struct BatchRange {
+	GLintptr vertexOffset;		// Byte offset of the mesh's first vertex in the vertex buffer
+	GLintptr indexOffset;		// Byte offset of the mesh's first index in the index buffer
+};
+
+/* This class packs the vertices and indices of many meshes into one vertex buffer and one index buffer
+*/
+class GeometryBatch {
+private:
+	// A mesh added to the batch. The vectors must stay where they are until Upload copies them
+	struct Entry {
+		const std::vector<GLfloat>* vertices;
+		const std::vector<GLushort>* indices;
+		BatchRange range;
+	};
+
+	std::vector<Entry> entries;			// Meshes in the order they were added
+	GLsizeiptr vertexBytes;				// Size of the vertex buffer
+	GLsizeiptr indexBytes;				// Size of the index buffer
+	GLuint buffers[2];					// Vertex and index buffers, 0 until uploaded
+
+	// Upload the meshes one at a time into buffers of the full size, for when the staging block cannot be allocated
+	void UploadEach();
+
+public:
+	// Constructor
+	GeometryBatch();
+	// Add a mesh's vertices and indices and return its index. Its range is known right away, before anything is copied
+	unsigned int Add(const std::vector<GLfloat>& vertices, const std::vector<GLushort>& indices);
+	// Where a mesh sits in the buffers
+	const BatchRange& Range(unsigned int entry) const;
+	// Copy every mesh into one staging block on the job system and upload it as one vertex buffer and one index buffer. Needs a current context
+	void Upload(JobSystem& jobs);
+	// Vertex array reading the batch's buffers with the attributes of the given mesh (position, normal, texture coordinate)
+	GLuint CreateVertexArray(unsigned int entry) const;
+	// Shared vertex buffer
+	GLuint VertexBuffer() const;
+	// Shared index buffer
+	GLuint IndexBuffer() const;
+	// Delete the buffers. Vertex arrays made by CreateVertexArray belong to their meshes
+	void Destroy();
+};
+
+// Constructor
+GeometryBatch::GeometryBatch() {
+	vertexBytes = 0;
+	indexBytes = 0;
+	buffers[0] = 0;
+	buffers[1] = 0;
+}
+
+// Add a mesh's vertices and indices
+unsigned int GeometryBatch::Add(const std::vector<GLfloat>& vertices, const std::vector<GLushort>& indices) {
+	Entry entry;
+	entry.vertices = &vertices;
+	entry.indices = &indices;
+	entry.range.vertexOffset = vertexBytes;
+	entry.range.indexOffset = indexBytes;
+	vertexBytes += vertices.size() * sizeof(GLfloat);
+	indexBytes += indices.size() * sizeof(GLushort);
+	entries.push_back(entry);
+	return entries.size() - 1;
+}
+
+// Where a mesh sits in the buffers
+const BatchRange& GeometryBatch::Range(unsigned int entry) const {
+	return entries.at(entry).range;
+}
+
+// Copy every mesh into one staging block and upload it
+void GeometryBatch::Upload(JobSystem& jobs) {
+	if (entries.empty()) {
+		return;
+	}
+
+	// Vertices first, then indices. The vertex part is a whole number of floats, so the indices stay aligned
+	char* staging = (char*)malloc(vertexBytes + indexBytes);
+	if (!staging) {
+		UploadEach();
+		return;
+	}
+	char* indexStaging = staging + vertexBytes;
+	auto copy = [this, staging, indexStaging](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; i++) {
+			const Entry& entry = entries[i];
+			if (!entry.vertices->empty()) {
+				memcpy(staging + entry.range.vertexOffset, entry.vertices->data(), entry.vertices->size() * sizeof(GLfloat));
+			}
+			if (!entry.indices->empty()) {
+				memcpy(indexStaging + entry.range.indexOffset, entry.indices->data(), entry.indices->size() * sizeof(GLushort));
+			}
+		}
+	};
+	jobs.ParallelFor(entries.size(), 16, copy);
+
+	// The element buffer binding is part of the vertex array state, so none may be bound while it is filled
+	glBindVertexArray(0);
+	glGenBuffers(2, buffers);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, staging, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexStaging, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	free(staging);
+
+	// The meshes keep their own vertices for picking and baking, so the pointers are not needed anymore
+	for (unsigned int i = 0; i < entries.size(); i++) {
+		entries[i].vertices = NULL;
+		entries[i].indices = NULL;
+	}
+}
+
+// Upload the meshes one at a time into buffers of the full size
+void GeometryBatch::UploadEach() {
+	glBindVertexArray(0);
+	glGenBuffers(2, buffers);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, NULL, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, NULL, GL_STATIC_DRAW);
+	for (unsigned int i = 0; i < entries.size(); i++) {
+		Entry& entry = entries[i];
+		glBufferSubData(GL_ARRAY_BUFFER, entry.range.vertexOffset, entry.vertices->size() * sizeof(GLfloat), entry.vertices->data());
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, entry.range.indexOffset, entry.indices->size() * sizeof(GLushort), entry.indices->data());
+		entry.vertices = NULL;
+		entry.indices = NULL;
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+// Vertex array reading the batch's buffers with the attributes of the given mesh
+GLuint GeometryBatch::CreateVertexArray(unsigned int entry) const {
+	GLintptr first = Range(entry).vertexOffset;
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+
+	// Same layout as every other mesh, starting at the mesh's first vertex
+	GLint stride = sizeof(float) * 8;
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)first);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(first + sizeof(float) * 3));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(first + sizeof(float) * 6));
+	glEnableVertexAttribArray(2);
+	glBindVertexArray(0);
+	return vao;
+}
+
+// Shared vertex buffer
+GLuint GeometryBatch::VertexBuffer() const {
+	return buffers[0];
+}
+
+// Shared index buffer
+GLuint GeometryBatch::IndexBuffer() const {
+	return buffers[1];
+}
+
+// Delete the buffers
+void GeometryBatch::Destroy() {
+	if (buffers[0]) {
+		glDeleteBuffers(2, buffers);
+		buffers[0] = 0;
+		buffers[1] = 0;
+	}
+	entries.clear();
+	vertexBytes = 0;
+	indexBytes = 0;
+}
@@ -0,0 +1,330 @@
+#pragma once
+/* GeometryCache.h : This file contains the code necessary to share
+ *      the vertex buffers of identical primitive shapes. Sphere, Cuboid,
+ *		and Cylinder bake their origin into the vertex positions, so the
+ *		same shape placed in two spots used to get two sets of buffers.
+ *
+ *				Shapes are built here at the origin and looked up by their
+ *				type, dimensions, tessellation, and texture tiling. Every
+ *				mesh using a shape gets the same buffers, and its origin
+ *				becomes a translation applied with its model matrix.
+ *				Shapes are counted and deleted when the last mesh using
+ *				them is released.
+ *
+ *				A scene's shapes can be built together up front. Their
+ *				vertices are generated on the job system's threads and
+ *				added to the scene's geometry batch, so they are uploaded
+ *				together with the rest of the scene. Their buffers then
+ *				belong to the batch, and releasing them only deletes
+ *				their vertex arrays.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+#include "Cuboid.h"
+#include "Cylinder.h"
+#include "Sphere.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "GeometryBatch.h"
+
+#include <map>
+#include <vector>
+
+// Kinds of primitive the cache can build
+enum ShapeType { SHAPE_SPHERE, SHAPE_CUBOID, SHAPE_CYLINDER };
+
+// Everything that decides the vertices of a primitive apart from its origin
+struct ShapeKey {
+	ShapeType type;
+	float size[3];				// Radius for spheres, length, width, and height for cuboids, height and radius for cylinders
+	int detail[2];				// Rings and sectors for spheres, cap type for cylinders
+	float tiles[3];				// Side, front and back, and top and bottom texture tiling for cuboids
+
+	// Key for a sphere
+	static ShapeKey SphereKey(float radius, int rings, int sectors);
+	// Key for a cuboid. Tiling other than 1 regenerates the cuboid with SetTiles the way the coffee table always has
+	static ShapeKey CuboidKey(float length, float width, float height, float sides = 1.0f, float frontBack = 1.0f, float topBottom = 1.0f);
+	// Key for a cylinder
+	static ShapeKey CylinderKey(float height, float radius, CylinderType type);
+	// Order keys so they can be looked up in a map
+	bool operator<(const ShapeKey& other) const;
+};
+
+// Vertices and buffers of one shape built at the origin
+struct SharedShape {
+	std::vector<GLfloat> vertices;	// Eight floats per vertex (x, y, z, nx, ny, nz, u, v)
+	std::vector<GLushort> indices;
+	GLuint vao;						// Vertex array with attributes 0 to 2 set up
+	GLuint vbos[2];					// Vertex and index buffers
+	GLintptr vertexOffset;			// Byte offset of the first vertex in the vertex buffer
+	GLintptr indexOffset;			// Byte offset of the first index in the index buffer
+	bool batched;					// True if the buffers belong to a geometry batch, which deletes them
+	GLuint nIndices;
+	AABB bounds;					// Bounds of the vertices
+	unsigned int references;		// Meshes using the shape
+};
+
+/* This class builds each distinct primitive shape once and hands out its buffers
+*/
+class GeometryCache {
+private:
+	std::map<ShapeKey, SharedShape> shapes;		// Shapes in use
+	unsigned int requests;						// Calls to Acquire
+	unsigned int builds;						// Shapes built because no mesh was using them yet
+	std::vector<std::pair<SharedShape*, unsigned int> > prebuilt;	// Shapes added to a batch by Prebuild, waiting for their vertex arrays
+
+	// Generate the vertices of a shape
+	static void Build(const ShapeKey& key, SharedShape& shape);
+	// Upload a shape's vertices and indices and set up its vertex array
+	static void Upload(SharedShape& shape);
+
+public:
+	// Constructor
+	GeometryCache();
+	// Generate every listed shape not in the cache yet in parallel and add them to a batch. Acquire finds them built once FinishPrebuild has run
+	void Prebuild(const std::vector<ShapeKey>& keys, JobSystem& jobs, GeometryBatch& batch);
+	// Give the prebuilt shapes their vertex arrays once the batch is uploaded
+	void FinishPrebuild(const GeometryBatch& batch);
+	// Shape for a key, building it the first time. The reference stays valid until the shape is released for the last time
+	const SharedShape& Acquire(const ShapeKey& key);
+	// Shape for a key, using vertices that were generated earlier, such as ones read from a scene bake, the first time
+	const SharedShape& Acquire(const ShapeKey& key, const GLfloat* vertices, unsigned int vertexFloats, const GLushort* indices, unsigned int indexCount, const AABB& bounds);
+	// Stop using a shape, deleting its vertex array, and its buffers unless a batch owns them, if no mesh uses it anymore
+	void Release(const ShapeKey& key);
+	// Delete every shape
+	void Destroy();
+	// Number of distinct shapes in use
+	unsigned int Shapes() const;
+	// Calls to Acquire so far
+	unsigned int Requests() const;
+	// Shapes generated so far. Shapes given their vertices are not counted
+	unsigned int Builds() const;
+};
+
+// Key for a sphere
+ShapeKey ShapeKey::SphereKey(float radius, int rings, int sectors) {
+	ShapeKey key = { SHAPE_SPHERE, { radius, 0.0f, 0.0f }, { rings, sectors }, { 1.0f, 1.0f, 1.0f } };
+	return key;
+}
+
+// Key for a cuboid
+ShapeKey ShapeKey::CuboidKey(float length, float width, float height, float sides, float frontBack, float topBottom) {
+	ShapeKey key = { SHAPE_CUBOID, { length, width, height }, { 0, 0 }, { sides, frontBack, topBottom } };
+	return key;
+}
+
+// Key for a cylinder
+ShapeKey ShapeKey::CylinderKey(float height, float radius, CylinderType type) {
+	ShapeKey key = { SHAPE_CYLINDER, { height, radius, 0.0f }, { (int)type, 0 }, { 1.0f, 1.0f, 1.0f } };
+	return key;
+}
+
+// Order keys so they can be looked up in a map
+bool ShapeKey::operator<(const ShapeKey& other) const {
+	if (type != other.type) {
+		return type < other.type;
+	}
+	for (int i = 0; i < 3; i++) {
+		if (size[i] != other.size[i]) {
+			return size[i] < other.size[i];
+		}
+	}
+	for (int i = 0; i < 2; i++) {
+		if (detail[i] != other.detail[i]) {
+			return detail[i] < other.detail[i];
+		}
+	}
+	for (int i = 0; i < 3; i++) {
+		if (tiles[i] != other.tiles[i]) {
+			return tiles[i] < other.tiles[i];
+		}
+	}
+	return false;
+}
+
+// Constructor
+GeometryCache::GeometryCache() {
+	requests = 0;
+	builds = 0;
+}
+
+// Generate the vertices of a shape
+void GeometryCache::Build(const ShapeKey& key, SharedShape& shape) {
+	switch (key.type) {
+	case SHAPE_SPHERE: {
+		Sphere sphere(key.size[0], key.detail[0], key.detail[1], 0.0f, 0.0f, 0.0f);
+		shape.vertices = sphere.GetVertices();
+		shape.indices = sphere.GetIndices();
+		break;
+	}
+	case SHAPE_CUBOID: {
+		Cuboid cuboid(key.size[0], key.size[1], key.size[2], 0.0f, 0.0f, 0.0f, 1);
+		if (key.tiles[0] != 1.0f || key.tiles[1] != 1.0f || key.tiles[2] != 1.0f) {
+			cuboid.SetTiles(key.tiles[0], key.tiles[1], key.tiles[2]);
+			cuboid.GenCuboid();
+		}
+		shape.vertices = cuboid.GetVertices();
+		shape.indices = cuboid.GetIndices();
+		break;
+	}
+	case SHAPE_CYLINDER: {
+		Cylinder cylinder(key.size[0], key.size[1], 0.0f, 0.0f, 0.0f, (CylinderType)key.detail[0]);
+		shape.vertices = cylinder.GetVertices();
+		shape.indices = cylinder.GetIndices();
+		break;
+	}
+	}
+	shape.bounds = AABB();
+	for (unsigned int i = 0; i + 2 < shape.vertices.size(); i += 8) {
+		shape.bounds.Expand(glm::vec3(shape.vertices[i], shape.vertices[i + 1], shape.vertices[i + 2]));
+	}
+}
+
+// Upload a shape's vertices and indices and set up its vertex array
+void GeometryCache::Upload(SharedShape& shape) {
+	shape.nIndices = shape.indices.size();
+	shape.vertexOffset = 0;
+	shape.indexOffset = 0;
+	shape.batched = false;
+	glGenVertexArrays(1, &shape.vao);
+	glBindVertexArray(shape.vao);
+	glGenBuffers(2, shape.vbos);
+	glBindBuffer(GL_ARRAY_BUFFER, shape.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, shape.vertices.size() * sizeof(GLfloat), shape.vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shape.vbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, shape.indices.size() * sizeof(GLushort), shape.indices.data(), GL_STATIC_DRAW);
+
+	// Same layout as every other mesh: position, normal, texture coordinate
+	GLint stride = sizeof(float) * 8;
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, 0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 3));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 6));
+	glEnableVertexAttribArray(2);
+	glBindVertexArray(0);
+}
+
+// Generate every listed shape not in the cache yet and add them to a batch
+void GeometryCache::Prebuild(const std::vector<ShapeKey>& keys, JobSystem& jobs, GeometryBatch& batch) {
+	// Add an entry for each new shape first. Map entries never move, so the jobs can fill them in place
+	std::vector<const ShapeKey*> pendingKeys;
+	std::vector<SharedShape*> pending;
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		if (shapes.find(keys[i]) != shapes.end()) {
+			continue;
+		}
+		std::map<ShapeKey, SharedShape>::iterator added = shapes.insert(std::make_pair(keys[i], SharedShape())).first;
+		added->second.references = 0;
+		pendingKeys.push_back(&added->first);
+		pending.push_back(&added->second);
+	}
+
+	// Each shape is a job of its own, since one sphere is already plenty of work
+	auto generate = [&pendingKeys, &pending](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; i++) {
+			Build(*pendingKeys[i], *pending[i]);
+		}
+	};
+	jobs.ParallelFor(pending.size(), 1, generate);
+
+	// The batch uploads them later, together with the rest of the scene
+	for (unsigned int i = 0; i < pending.size(); i++) {
+		prebuilt.push_back(std::make_pair(pending[i], batch.Add(pending[i]->vertices, pending[i]->indices)));
+		builds++;
+	}
+}
+
+// Give the prebuilt shapes their vertex arrays
+void GeometryCache::FinishPrebuild(const GeometryBatch& batch) {
+	for (unsigned int i = 0; i < prebuilt.size(); i++) {
+		SharedShape& shape = *prebuilt[i].first;
+		const BatchRange& range = batch.Range(prebuilt[i].second);
+		shape.nIndices = shape.indices.size();
+		shape.vao = batch.CreateVertexArray(prebuilt[i].second);
+		shape.vbos[0] = batch.VertexBuffer();
+		shape.vbos[1] = batch.IndexBuffer();
+		shape.vertexOffset = range.vertexOffset;
+		shape.indexOffset = range.indexOffset;
+		shape.batched = true;
+	}
+	prebuilt.clear();
+}
+
+// Shape for a key, building it the first time
+const SharedShape& GeometryCache::Acquire(const ShapeKey& key) {
+	requests++;
+	std::map<ShapeKey, SharedShape>::iterator found = shapes.find(key);
+	if (found != shapes.end()) {
+		found->second.references++;
+		return found->second;
+	}
+	SharedShape& shape = shapes[key];
+	Build(key, shape);
+	Upload(shape);
+	shape.references = 1;
+	builds++;
+	return shape;
+}
+
+// Shape for a key, using vertices that were generated earlier the first time
+const SharedShape& GeometryCache::Acquire(const ShapeKey& key, const GLfloat* vertices, unsigned int vertexFloats, const GLushort* indices, unsigned int indexCount, const AABB& bounds) {
+	requests++;
+	std::map<ShapeKey, SharedShape>::iterator found = shapes.find(key);
+	if (found != shapes.end()) {
+		found->second.references++;
+		return found->second;
+	}
+	SharedShape& shape = shapes[key];
+	shape.vertices.assign(vertices, vertices + vertexFloats);
+	shape.indices.assign(indices, indices + indexCount);
+	shape.bounds = bounds;
+	Upload(shape);
+	shape.references = 1;
+	return shape;
+}
+
+// Stop using a shape
+void GeometryCache::Release(const ShapeKey& key) {
+	std::map<ShapeKey, SharedShape>::iterator found = shapes.find(key);
+	if (found == shapes.end() || --found->second.references > 0) {
+		return;
+	}
+	glDeleteVertexArrays(1, &found->second.vao);
+	if (!found->second.batched) {
+		glDeleteBuffers(2, found->second.vbos);
+	}
+	shapes.erase(found);
+}
+
+// Delete every shape
+void GeometryCache::Destroy() {
+	for (std::map<ShapeKey, SharedShape>::iterator it = shapes.begin(); it != shapes.end(); ++it) {
+		glDeleteVertexArrays(1, &it->second.vao);
+		if (!it->second.batched) {
+			glDeleteBuffers(2, it->second.vbos);
+		}
+	}
+	shapes.clear();
+	prebuilt.clear();
+}
+
+// Number of distinct shapes in use
+unsigned int GeometryCache::Shapes() const {
+	return shapes.size();
+}
+
+// Calls to Acquire so far
+unsigned int GeometryCache::Requests() const {
+	return requests;
+}
+
+// Shapes built so far
+unsigned int GeometryCache::Builds() const {
+	return builds;
+}
@@ -0,0 +1,288 @@
+#pragma once
+/* JobSystem.h : This file contains the code necessary to split frame
+ *      preparation across every core. A loop over entities is cut into
+ *		chunks, each chunk becomes a job, and worker threads run the jobs
+ *		while the thread that started the loop helps until all of them
+ *		are done.
+ *
+ *				Every thread has its own queue. A thread adds jobs to the
+ *				back of its queue and takes from the back, so it keeps
+ *				working on the data it just touched. A thread whose queue
+ *				is empty steals from the front of another thread's queue,
+ *				which spreads the work without a shared queue every thread
+ *				fights over.
+ *
+ *				Queues are fixed size rings and jobs are plain structs that
+ *				point at the loop body, so starting a loop allocates no
+ *				memory. Workers sleep on a condition variable when there is
+ *				nothing to steal. A job's allocations are counted against
+ *				the subsystem of the thread that started its loop.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include "AllocationTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* This class runs chunks of parallel loops on a set of worker threads that steal work from each other
+*/
+class JobSystem {
+private:
+	static const unsigned int QUEUE_SIZE = 1024;	// Jobs a queue holds. Chunks that do not fit run right away on the thread adding them
+
+	// One chunk of a loop
+	struct Job {
+		void (*function)(void* body, unsigned int begin, unsigned int end);	// Calls the loop body
+		void* body;								// Loop body
+		unsigned int begin;						// Range of the loop this job covers
+		unsigned int end;
+		std::atomic<unsigned int>* remaining;	// Chunks of the loop not finished yet
+		AllocationTag tag;						// Subsystem of the thread that started the loop
+	};
+
+	// Jobs waiting on one thread. The owner works at the back and thieves take from the front
+	struct Queue {
+		std::mutex lock;
+		Job jobs[QUEUE_SIZE];
+		unsigned int front;						// Index of the oldest job
+		unsigned int back;						// One past the newest job
+	};
+
+	std::vector<std::thread> workers;
+	std::unique_ptr<Queue[]> queues;			// Queue 0 belongs to the threads that start loops, then one per worker
+	unsigned int queueCount;
+	std::atomic<bool> running;					// Cleared to stop the workers
+	std::atomic<int> queued;					// Jobs in every queue
+	std::atomic<unsigned int> steals;			// Jobs taken from another thread's queue
+	std::mutex sleepLock;						// Held while workers decide to sleep
+	std::condition_variable wake;				// Signalled when jobs are added
+	static thread_local unsigned int threadIndex;	// Queue of the current thread
+
+	// Add a job to the back of a queue. Returns false if the queue is full
+	bool Push(unsigned int queue, const Job& job);
+	// Take the newest job from a queue
+	bool Pop(unsigned int queue, Job& job);
+	// Take the oldest job from another thread's queue
+	bool Steal(unsigned int queue, Job& job);
+	// Take a job from a thread's own queue, or steal one
+	bool Find(unsigned int queue, Job& job);
+	// Run a job and count it as done
+	static void Run(const Job& job);
+	// Wake sleeping workers after jobs were added
+	void Wake();
+	// Everything a worker thread does
+	void Work(unsigned int index);
+	// Call a loop body of a known type
+	template <class Body>
+	static void Call(void* body, unsigned int begin, unsigned int end);
+
+	// Copying would share the worker threads
+	JobSystem(const JobSystem&);
+	JobSystem& operator=(const JobSystem&);
+
+public:
+	// Constructor
+	JobSystem();
+	// Stop the workers
+	~JobSystem();
+	// Start worker threads. 0 starts one fewer than the number of cores, since the thread starting loops works too
+	void Start(unsigned int threadCount = 0);
+	// Finish and join the workers
+	void Stop();
+	// Threads that run jobs, counting the one starting loops
+	unsigned int ThreadCount() const;
+	// Jobs taken from another thread's queue since the start
+	unsigned int Steals() const;
+	// Call body(begin, end) for chunks of up to grain items covering 0 to count, in parallel, and return once every chunk is done
+	template <class Body>
+	void ParallelFor(unsigned int count, unsigned int grain, Body& body);
+};
+
+thread_local unsigned int JobSystem::threadIndex = 0;
+
+// Constructor
+JobSystem::JobSystem() {
+	queueCount = 0;
+	running = false;
+	queued = 0;
+	steals = 0;
+}
+
+// Stop the workers
+JobSystem::~JobSystem() {
+	Stop();
+}
+
+// Start worker threads
+void JobSystem::Start(unsigned int threadCount) {
+	Stop();
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	}
+	queueCount = threadCount + 1;
+	queues.reset(new Queue[queueCount]);
+	for (unsigned int i = 0; i < queueCount; i++) {
+		queues[i].front = 0;
+		queues[i].back = 0;
+	}
+	running = true;
+	for (unsigned int i = 1; i < queueCount; i++) {
+		workers.push_back(std::thread(&JobSystem::Work, this, i));
+	}
+}
+
+// Finish and join the workers
+void JobSystem::Stop() {
+	{
+		std::lock_guard<std::mutex> lock(sleepLock);
+		running = false;
+	}
+	wake.notify_all();
+	for (unsigned int i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+	workers.clear();
+}
+
+// Threads that run jobs
+unsigned int JobSystem::ThreadCount() const {
+	return workers.size() + 1;
+}
+
+// Jobs taken from another thread's queue
+unsigned int JobSystem::Steals() const {
+	return steals;
+}
+
+// Add a job to the back of a queue
+bool JobSystem::Push(unsigned int queue, const Job& job) {
+	Queue& target = queues[queue];
+	std::lock_guard<std::mutex> lock(target.lock);
+	if (target.back - target.front == QUEUE_SIZE) {
+		return false;
+	}
+	target.jobs[target.back % QUEUE_SIZE] = job;
+	target.back++;
+	queued++;
+	return true;
+}
+
+// Take the newest job from a queue
+bool JobSystem::Pop(unsigned int queue, Job& job) {
+	Queue& source = queues[queue];
+	std::lock_guard<std::mutex> lock(source.lock);
+	if (source.back == source.front) {
+		return false;
+	}
+	source.back--;
+	job = source.jobs[source.back % QUEUE_SIZE];
+	queued--;
+	return true;
+}
+
+// Take the oldest job from another thread's queue
+bool JobSystem::Steal(unsigned int queue, Job& job) {
+	Queue& source = queues[queue];
+	std::lock_guard<std::mutex> lock(source.lock);
+	if (source.back == source.front) {
+		return false;
+	}
+	job = source.jobs[source.front % QUEUE_SIZE];
+	source.front++;
+	queued--;
+	steals++;
+	return true;
+}
+
+// Take a job from a thread's own queue, or steal one
+bool JobSystem::Find(unsigned int queue, Job& job) {
+	if (Pop(queue, job)) {
+		return true;
+	}
+	// Try the other queues starting with the next one, so thieves spread out instead of all hitting queue 0
+	for (unsigned int i = 1; i < queueCount; i++) {
+		if (Steal((queue + i) % queueCount, job)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Run a job and count it as done
+void JobSystem::Run(const Job& job) {
+	AllocationScope scope(job.tag);
+	job.function(job.body, job.begin, job.end);
+	job.remaining->fetch_sub(1, std::memory_order_release);
+}
+
+// Wake sleeping workers
+void JobSystem::Wake() {
+	// Taking the lock makes sure a worker that just saw no jobs is waiting before it is notified
+	{
+		std::lock_guard<std::mutex> lock(sleepLock);
+	}
+	wake.notify_all();
+}
+
+// Everything a worker thread does
+void JobSystem::Work(unsigned int index) {
+	threadIndex = index;
+	while (running) {
+		Job job;
+		if (Find(index, job)) {
+			Run(job);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepLock);
+		wake.wait(lock, [this]() { return !running || queued > 0; });
+	}
+}
+
+// Call a loop body of a known type
+template <class Body>
+void JobSystem::Call(void* body, unsigned int begin, unsigned int end) {
+	(*(Body*)body)(begin, end);
+}
+
+// Run a loop in parallel chunks
+template <class Body>
+void JobSystem::ParallelFor(unsigned int count, unsigned int grain, Body& body) {
+	grain = std::max(1u, grain);
+	// A single chunk, or no workers to share it with, is run right here
+	if (count <= grain || workers.empty()) {
+		if (count > 0) {
+			body(0, count);
+		}
+		return;
+	}
+
+	std::atomic<unsigned int> remaining((count + grain - 1) / grain);
+	unsigned int self = threadIndex;
+	for (unsigned int begin = 0; begin < count; begin += grain) {
+		Job job = { &JobSystem::Call<Body>, &body, begin, std::min(begin + grain, count), &remaining, AllocationTracker::Tag() };
+		if (!Push(self, job)) {
+			Run(job);
+		}
+	}
+	Wake();
+
+	// Help until every chunk is done. Chunks stolen by workers may still be running after this queue is empty
+	while (remaining.load(std::memory_order_acquire) > 0) {
+		Job job;
+		if (Find(self, job)) {
+			Run(job);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,502 @@
+#pragma once
+/* Lightmap.h : This file contains the code necessary to bake the
+ *      diffuse lighting of static meshes into a lightmap atlas on the
+ *		CPU. Every texel is lit directly by both lights, with shadow
+ *		rays, plus one bounce of indirect light gathered with cosine
+ *		weighted rays.
+ *
+ *				Each triangle gets its own square cell in its mesh's chart,
+ *				which gives every mesh a second set of UVs without needing
+ *				an unwrapper. The triangles are unwelded so each corner can
+ *				carry its own lightmap UV. Charts are packed into one atlas
+ *				and a scale and offset per mesh maps chart UVs into it.
+ *
+ *				The red channel holds the key light and the green channel
+ *				the fill light, without their colors, so the lights can still
+ *				change color at runtime without baking again.
+ *
+ *				Baking runs on a background thread that hands the cells to
+ *				the job system a few at a time, so frame jobs never queue
+ *				behind the whole bake. Charts that do not fit the largest
+ *				atlas are marked as not placed and keep their plain material.
+ *				Results are uploaded to OpenGL by the render thread once
+ *				Finished() returns true.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Bvh.h"
+#include "JobSystem.h"
+
+// A mesh handed to the baker. Vertices are 8 floats each (x, y, z, nx, ny, nz, u, v)
+struct LightmapInput {
+	std::vector<GLfloat> vertices;		// Object space vertices
+	std::vector<GLushort> indices;		// Triangle indices
+	glm::mat4 model;					// Model matrix placing the mesh in the scene
+	bool baked;							// True if the mesh gets a chart, false if it only blocks light
+	bool occluder;						// True if the mesh blocks light
+};
+
+// The baked result for one mesh
+struct LightmapChart {
+	std::vector<GLfloat> vertices;		// Unwelded vertices, 10 floats each (x, y, z, nx, ny, nz, u, v, lightmap u, lightmap v)
+	glm::vec4 scaleOffset;				// Maps chart UVs into the atlas: atlas = chart * xy + zw
+	int width;							// Size of the chart in texels
+	int height;
+	int atlasX;							// Position of the chart in the atlas
+	int atlasY;
+	bool placed;						// True if the chart fit in the atlas and was baked
+};
+
+/* This class bakes lightmaps for a list of meshes on a background thread
+*/
+class LightmapBaker {
+private:
+	const float TEXELS_PER_UNIT = 8.0f;		// Lightmap resolution in texels per world unit
+	static const int MIN_CELL = 4;			// Smallest triangle cell in texels, including padding
+	static const int MAX_CELL = 128;		// Largest triangle cell in texels, including padding
+	static const int CELL_PADDING = 1;		// Texels left around each triangle so filtering does not bleed
+	static const int MAX_ATLAS = 4096;		// Largest atlas width and height
+	static const int BOUNCE_SAMPLES = 16;	// Indirect rays per texel
+	static const int CELLS_PER_THREAD = 2;	// Cells handed to each job thread at a time
+	const float ALBEDO = 0.5f;				// Reflectance used for bounced light
+	const float RAY_OFFSET = 0.002f;		// Distance rays start away from the surface
+
+	// A triangle in world space used for tracing rays
+	struct Triangle {
+		glm::vec3 corner;					// First corner
+		glm::vec3 edge1;					// Second corner minus the first
+		glm::vec3 edge2;					// Third corner minus the first
+		glm::vec3 normal;					// Face normal
+	};
+
+	// A triangle waiting to be baked
+	struct BakeCell {
+		int chart;							// Chart the cell belongs to
+		int x;								// Position of the cell in the atlas
+		int y;
+		int size;							// Width and height of the cell in texels
+		glm::vec3 positions[3];				// World space corners
+		glm::vec3 normals[3];				// World space corner normals
+	};
+
+	std::vector<LightmapInput> inputs;		// Meshes being baked
+	std::vector<LightmapChart> charts;		// One chart per input, not placed for inputs that are not baked
+	std::vector<Triangle> triangles;		// Every occluder triangle in world space
+	std::vector<BakeCell> cells;			// Every triangle that gets texels
+	Bvh triangleBvh;						// Hierarchy over the occluder triangles
+	std::vector<float> atlas;				// Two floats per texel
+	int atlasWidth;
+	int atlasHeight;
+	glm::vec3 lightPositions[2];			// Key and fill light positions
+	JobSystem* jobs;						// Threads the cells are baked on
+	std::thread worker;						// Background thread running the bake
+	std::atomic<bool> finished;				// Set when the bake is done
+	std::atomic<bool> cancelled;			// Set to stop a bake early, for example when the program closes
+
+	// Everything the background thread does
+	void Bake();
+	// Lay out the cells, charts, and atlas
+	void Layout();
+	// Light every texel of one cell
+	void BakeCellTexels(const BakeCell& cell);
+	// Direct light from both lights reaching a point
+	glm::vec2 DirectLight(const glm::vec3& position, const glm::vec3& normal) const;
+	// Closest occluder triangle hit by a ray
+	int TraceClosest(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+	// Exact ray test against one triangle
+	bool RayHitsTriangle(int triangle, const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+public:
+	// Constructor
+	LightmapBaker();
+	// Stop and wait for any running bake
+	~LightmapBaker();
+	// Start baking in the background on a job system. The inputs are copied so the caller may change its meshes
+	void Start(JobSystem& jobSystem, const std::vector<LightmapInput>& meshes, const glm::vec3& light1, const glm::vec3& light2);
+	// Stop and wait for any running bake. Call before stopping the job system
+	void Stop();
+	// True once the background bake is done
+	bool Finished() const;
+	// Create the atlas texture. Only call once Finished() is true
+	GLuint CreateTexture() const;
+	// Baked result for each input, in the same order
+	const std::vector<LightmapChart>& Charts() const;
+	// Light positions the lightmap was baked with
+	const glm::vec3& LightPosition(int light) const;
+};
+
+// Constructor
+LightmapBaker::LightmapBaker() : finished(false), cancelled(false) {
+	jobs = nullptr;
+	atlasWidth = 0;
+	atlasHeight = 0;
+}
+
+// Stop and wait for any running bake
+LightmapBaker::~LightmapBaker() {
+	Stop();
+}
+
+// Start baking in the background
+void LightmapBaker::Start(JobSystem& jobSystem, const std::vector<LightmapInput>& meshes, const glm::vec3& light1, const glm::vec3& light2) {
+	if (worker.joinable()) {
+		worker.join();
+	}
+	jobs = &jobSystem;
+	inputs = meshes;
+	lightPositions[0] = light1;
+	lightPositions[1] = light2;
+	finished = false;
+	cancelled = false;
+	worker = std::thread(&LightmapBaker::Bake, this);
+}
+
+// Stop and wait for any running bake
+void LightmapBaker::Stop() {
+	cancelled = true;
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+// True once the background bake is done
+bool LightmapBaker::Finished() const {
+	return finished;
+}
+
+// Everything the background thread does
+void LightmapBaker::Bake() {
+	// Gather the occluders in world space and build a hierarchy over them
+	triangles.clear();
+	std::vector<AABB> triangleBounds;
+	for (unsigned int i = 0; i < inputs.size(); i++) {
+		const LightmapInput& input = inputs[i];
+		if (!input.occluder) {
+			continue;
+		}
+		for (unsigned int index = 0; index + 2 < input.indices.size(); index += 3) {
+			glm::vec3 corners[3];
+			for (int corner = 0; corner < 3; corner++) {
+				unsigned int vertex = input.indices[index + corner];
+				corners[corner] = glm::vec3(input.model * glm::vec4(input.vertices[vertex * 8], input.vertices[vertex * 8 + 1], input.vertices[vertex * 8 + 2], 1.0f));
+			}
+			Triangle triangle;
+			triangle.corner = corners[0];
+			triangle.edge1 = corners[1] - corners[0];
+			triangle.edge2 = corners[2] - corners[0];
+			glm::vec3 normal = glm::cross(triangle.edge1, triangle.edge2);
+			if (glm::length(normal) <= 0.0f) {
+				continue;
+			}
+			triangle.normal = glm::normalize(normal);
+			triangles.push_back(triangle);
+			AABB bounds;
+			bounds.Expand(corners[0]);
+			bounds.Expand(corners[1]);
+			bounds.Expand(corners[2]);
+			triangleBounds.push_back(bounds);
+		}
+	}
+	triangleBvh.Build(triangleBounds);
+
+	Layout();
+
+	// Bake a few cells per job thread at a time, so a frame's jobs wait for at most one cell
+	unsigned int batch = jobs->ThreadCount() * CELLS_PER_THREAD;
+	for (unsigned int first = 0; first < cells.size() && !cancelled; first += batch) {
+		auto bakeCells = [this, first](unsigned int begin, unsigned int end) {
+			for (unsigned int cell = first + begin; cell < first + end && !cancelled; cell++) {
+				BakeCellTexels(cells[cell]);
+			}
+		};
+		jobs->ParallelFor(std::min(batch, (unsigned int)cells.size() - first), 1, bakeCells);
+	}
+	finished = true;
+}
+
+// Lay out the cells, charts, and atlas
+void LightmapBaker::Layout() {
+	charts.assign(inputs.size(), LightmapChart());
+	cells.clear();
+
+	// Size each triangle's cell from its world space area, then shelf pack the cells into each chart
+	std::vector<std::vector<BakeCell>> chartCells(inputs.size());
+	for (unsigned int i = 0; i < inputs.size(); i++) {
+		const LightmapInput& input = inputs[i];
+		LightmapChart& chart = charts[i];
+		chart.width = 0;
+		chart.height = 0;
+		chart.atlasX = 0;
+		chart.atlasY = 0;
+		chart.placed = false;
+		if (!input.baked) {
+			continue;
+		}
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(input.model)));
+		// Wide enough for roughly square charts
+		float totalArea = 0.0f;
+		std::vector<BakeCell> meshCells;
+		for (unsigned int index = 0; index + 2 < input.indices.size(); index += 3) {
+			BakeCell cell;
+			cell.chart = i;
+			for (int corner = 0; corner < 3; corner++) {
+				unsigned int vertex = input.indices[index + corner];
+				const GLfloat* v = &input.vertices[vertex * 8];
+				cell.positions[corner] = glm::vec3(input.model * glm::vec4(v[0], v[1], v[2], 1.0f));
+				cell.normals[corner] = glm::normalize(normalMatrix * glm::vec3(v[3], v[4], v[5]));
+			}
+			float area = 0.5f * glm::length(glm::cross(cell.positions[1] - cell.positions[0], cell.positions[2] - cell.positions[0]));
+			// The triangle covers half of its cell
+			int size = (int)std::ceil(std::sqrt(2.0f * area) * TEXELS_PER_UNIT) + CELL_PADDING * 2;
+			cell.size = std::min(MAX_CELL, std::max(MIN_CELL, size));
+			totalArea += (float)(cell.size * cell.size);
+			// Remember the triangle's corners for the unwelded vertices
+			cell.x = index;
+			meshCells.push_back(cell);
+		}
+		int shelfWidth = std::max(MIN_CELL, (int)std::ceil(std::sqrt(totalArea)));
+		int x = 0;
+		int y = 0;
+		int shelfHeight = 0;
+		for (unsigned int c = 0; c < meshCells.size(); c++) {
+			BakeCell& cell = meshCells[c];
+			if (x + cell.size > shelfWidth && x > 0) {
+				x = 0;
+				y += shelfHeight;
+				shelfHeight = 0;
+			}
+			int triangleIndex = cell.x;
+			cell.x = x;
+			cell.y = y;
+			x += cell.size;
+			shelfHeight = std::max(shelfHeight, cell.size);
+			chart.width = std::max(chart.width, x);
+
+			// Unwelded vertices. Lightmap UVs are in chart texels for now and normalized below
+			float corners[3][2] = {
+				{ (float)(cell.x + CELL_PADDING), (float)(cell.y + CELL_PADDING) },
+				{ (float)(cell.x + cell.size - CELL_PADDING), (float)(cell.y + CELL_PADDING) },
+				{ (float)(cell.x + CELL_PADDING), (float)(cell.y + cell.size - CELL_PADDING) }
+			};
+			for (int corner = 0; corner < 3; corner++) {
+				const GLfloat* v = &input.vertices[input.indices[triangleIndex + corner] * 8];
+				chart.vertices.insert(chart.vertices.end(), { v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], corners[corner][0], corners[corner][1] });
+			}
+		}
+		chart.height = y + shelfHeight;
+		chartCells[i] = meshCells;
+	}
+
+	// Shelf pack the charts into the smallest square atlas they fit in, tallest first. Charts that do not fit the largest one are skipped
+	std::vector<int> order;
+	for (unsigned int i = 0; i < charts.size(); i++) {
+		if (charts[i].width > 0) {
+			order.push_back(i);
+		}
+	}
+	std::sort(order.begin(), order.end(), [this](int a, int b) { return charts[a].height > charts[b].height; });
+	for (atlasWidth = 256; atlasWidth <= MAX_ATLAS; atlasWidth *= 2) {
+		int x = 0;
+		int y = 0;
+		int shelfHeight = 0;
+		bool fits = true;
+		bool largest = atlasWidth == MAX_ATLAS;
+		for (unsigned int o = 0; o < order.size() && (fits || largest); o++) {
+			LightmapChart& chart = charts[order[o]];
+			int chartX = x;
+			int chartY = y;
+			int chartShelf = shelfHeight;
+			if (chartX + chart.width > atlasWidth) {
+				chartX = 0;
+				chartY += shelfHeight;
+				chartShelf = 0;
+			}
+			chart.placed = chart.width <= atlasWidth && chartY + chart.height <= atlasWidth;
+			if (!chart.placed) {
+				fits = false;
+				continue;
+			}
+			chart.atlasX = chartX;
+			chart.atlasY = chartY;
+			x = chartX + chart.width;
+			y = chartY;
+			shelfHeight = std::max(chartShelf, chart.height);
+		}
+		if (fits || largest) {
+			break;
+		}
+	}
+	atlasHeight = atlasWidth;
+	atlas.assign(atlasWidth * atlasHeight * 2, 0.0f);
+
+	// Normalize chart UVs and move the cells into atlas space
+	for (unsigned int i = 0; i < charts.size(); i++) {
+		LightmapChart& chart = charts[i];
+		if (!chart.placed) {
+			continue;
+		}
+		for (unsigned int v = 0; v < chart.vertices.size(); v += 10) {
+			chart.vertices[v + 8] /= chart.width;
+			chart.vertices[v + 9] /= chart.height;
+		}
+		chart.scaleOffset = glm::vec4((float)chart.width / atlasWidth, (float)chart.height / atlasHeight,
+			(float)chart.atlasX / atlasWidth, (float)chart.atlasY / atlasHeight);
+		for (unsigned int c = 0; c < chartCells[i].size(); c++) {
+			BakeCell cell = chartCells[i][c];
+			cell.x += chart.atlasX;
+			cell.y += chart.atlasY;
+			cells.push_back(cell);
+		}
+	}
+}
+
+// Light every texel of one cell
+void LightmapBaker::BakeCellTexels(const BakeCell& cell) {
+	// Seeded by the cell's place in the atlas, so the result does not depend on which thread bakes it
+	std::mt19937 random(1234u + cell.y * atlasWidth + cell.x);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	float span = (float)(cell.size - CELL_PADDING * 2);
+	for (int ty = 0; ty < cell.size; ty++) {
+		for (int tx = 0; tx < cell.size; tx++) {
+			// Position of the texel center on the triangle. Texels just outside are clamped onto it to fill the padding
+			float u = (tx + 0.5f - CELL_PADDING) / span;
+			float v = (ty + 0.5f - CELL_PADDING) / span;
+			if (u + v > 1.0f + 2.0f / span) {
+				continue;
+			}
+			u = std::max(0.0f, u);
+			v = std::max(0.0f, v);
+			if (u + v > 1.0f) {
+				float excess = (u + v - 1.0f) * 0.5f;
+				u -= excess;
+				v -= excess;
+			}
+			float w = 1.0f - u - v;
+			glm::vec3 position = cell.positions[0] * w + cell.positions[1] * u + cell.positions[2] * v;
+			glm::vec3 normal = glm::normalize(cell.normals[0] * w + cell.normals[1] * u + cell.normals[2] * v);
+			glm::vec3 origin = position + normal * RAY_OFFSET;
+
+			glm::vec2 light = DirectLight(origin, normal);
+
+			// One bounce. Cosine weighted directions cancel the cosine term, leaving albedo times the average irradiance at the hits
+			glm::vec3 tangent = glm::normalize(std::fabs(normal.x) > 0.9f ? glm::cross(normal, glm::vec3(0.0f, 1.0f, 0.0f)) : glm::cross(normal, glm::vec3(1.0f, 0.0f, 0.0f)));
+			glm::vec3 bitangent = glm::cross(normal, tangent);
+			glm::vec2 bounced(0.0f);
+			for (int sample = 0; sample < BOUNCE_SAMPLES; sample++) {
+				float r1 = uniform(random);
+				float r2 = uniform(random);
+				float radius = std::sqrt(r1);
+				float angle = 6.28318530718f * r2;
+				glm::vec3 direction = tangent * (radius * std::cos(angle)) + bitangent * (radius * std::sin(angle)) + normal * std::sqrt(std::max(0.0f, 1.0f - r1));
+				float distance;
+				int hit = TraceClosest(origin, direction, distance);
+				if (hit < 0) {
+					continue;
+				}
+				glm::vec3 hitNormal = triangles[hit].normal;
+				if (glm::dot(hitNormal, direction) > 0.0f) {
+					hitNormal = -hitNormal;
+				}
+				glm::vec2 hitLight = DirectLight(origin + direction * distance + hitNormal * RAY_OFFSET, hitNormal);
+				bounced.x += hitLight.x;
+				bounced.y += hitLight.y;
+			}
+			light.x += ALBEDO * bounced.x / BOUNCE_SAMPLES;
+			light.y += ALBEDO * bounced.y / BOUNCE_SAMPLES;
+
+			int texel = ((cell.y + ty) * atlasWidth + cell.x + tx) * 2;
+			atlas[texel] = light.x;
+			atlas[texel + 1] = light.y;
+		}
+	}
+}
+
+// Direct light from both lights reaching a point, matching the diffuse term of the Phong shader
+glm::vec2 LightmapBaker::DirectLight(const glm::vec3& position, const glm::vec3& normal) const {
+	glm::vec2 result(0.0f);
+	for (int light = 0; light < 2; light++) {
+		glm::vec3 toLight = lightPositions[light] - position;
+		float distance = glm::length(toLight);
+		glm::vec3 direction = toLight / distance;
+		float impact = glm::dot(normal, direction);
+		if (impact <= 0.0f) {
+			continue;
+		}
+		bool blocked = triangleBvh.AnyHit(position, direction, distance, [this](int item, const glm::vec3& o, const glm::vec3& d, float& t) {
+			return RayHitsTriangle(item, o, d, t);
+		});
+		if (!blocked) {
+			result[light] = impact;
+		}
+	}
+	return result;
+}
+
+// Closest occluder triangle hit by a ray
+int LightmapBaker::TraceClosest(const glm::vec3& origin, const glm::vec3& direction, float& distance) const {
+	return triangleBvh.Raycast(origin, direction, distance, [this](int item, const glm::vec3& o, const glm::vec3& d, float& t) {
+		return RayHitsTriangle(item, o, d, t);
+	});
+}
+
+// Moller-Trumbore ray triangle intersection
+bool LightmapBaker::RayHitsTriangle(int index, const glm::vec3& origin, const glm::vec3& direction, float& distance) const {
+	const Triangle& triangle = triangles[index];
+	glm::vec3 p = glm::cross(direction, triangle.edge2);
+	float determinant = glm::dot(triangle.edge1, p);
+	if (std::fabs(determinant) < 1e-9f) {
+		return false;
+	}
+	float inverseDeterminant = 1.0f / determinant;
+	glm::vec3 toOrigin = origin - triangle.corner;
+	float u = glm::dot(toOrigin, p) * inverseDeterminant;
+	if (u < 0.0f || u > 1.0f) {
+		return false;
+	}
+	glm::vec3 q = glm::cross(toOrigin, triangle.edge1);
+	float v = glm::dot(direction, q) * inverseDeterminant;
+	if (v < 0.0f || u + v > 1.0f) {
+		return false;
+	}
+	distance = glm::dot(triangle.edge2, q) * inverseDeterminant;
+	return distance > 0.0f;
+}
+
+// Create the atlas texture
+GLuint LightmapBaker::CreateTexture() const {
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, atlasWidth, atlasHeight, 0, GL_RG, GL_FLOAT, atlas.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+// Baked result for each input, in the same order
+const std::vector<LightmapChart>& LightmapBaker::Charts() const {
+	return charts;
+}
+
+// Light positions the lightmap was baked with
+const glm::vec3& LightmapBaker::LightPosition(int light) const {
+	return lightPositions[light];
+}
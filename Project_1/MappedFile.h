@@ -0,0 +1,163 @@
+#pragma once
+/* MappedFile.h : This file contains the code necessary to map a file
+ *      into memory for reading. The operating system pages the file in
+ *		as it is touched, so a large file can be used straight from the
+ *		page cache without being read into a buffer first.
+ *
+ *				Uses mmap on Linux and macOS and a file mapping on Windows.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* This class maps a whole file read only and unmaps it when closed
+*/
+class MappedFile {
+private:
+	const char* data;				// Start of the mapped file, NULL when nothing is mapped
+	size_t size;					// Bytes in the file
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#else
+	int descriptor;
+#endif
+
+	// Copying would unmap the file twice
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+public:
+	// Constructor
+	MappedFile();
+	// Unmap the file
+	~MappedFile();
+	// Map a file. Returns false if it cannot be opened or is empty
+	bool Open(const std::string& path);
+	// Unmap the file
+	void Close();
+	// Start of the file in memory, NULL if nothing is mapped
+	const char* Data() const;
+	// Bytes in the file
+	size_t Size() const;
+};
+
+// Constructor
+MappedFile::MappedFile() {
+	data = NULL;
+	size = 0;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#else
+	descriptor = -1;
+#endif
+}
+
+// Unmap the file
+MappedFile::~MappedFile() {
+	Close();
+}
+
+// Map a file
+bool MappedFile::Open(const std::string& path) {
+	Close();
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		Close();
+		return false;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) {
+		Close();
+		return false;
+	}
+	data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		Close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+#else
+	descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		return false;
+	}
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+		Close();
+		return false;
+	}
+	void* mapped = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (mapped == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	data = (const char*)mapped;
+	size = status.st_size;
+	// The whole file is read from front to back right away
+	madvise(mapped, size, MADV_SEQUENTIAL);
+#endif
+	return true;
+}
+
+// Unmap the file
+void MappedFile::Close() {
+#ifdef _WIN32
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mapping) {
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (data) {
+		munmap((void*)data, size);
+	}
+	if (descriptor >= 0) {
+		close(descriptor);
+		descriptor = -1;
+	}
+#endif
+	data = NULL;
+	size = 0;
+}
+
+// Start of the file in memory
+const char* MappedFile::Data() const {
+	return data;
+}
+
+// Bytes in the file
+size_t MappedFile::Size() const {
+	return size;
+}
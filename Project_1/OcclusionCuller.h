@@ -0,0 +1,290 @@
+#pragma once
+/* OcclusionCuller.h : This file contains the code necessary to skip
+ *      objects that are hidden behind other objects. The depth buffer
+ *		of a previous frame is read back asynchronously, reduced into a
+ *		hierarchical Z (Hi-Z) pyramid on the CPU, and object bounds are
+ *		tested against it before they are drawn.
+ *
+ *				Each pyramid texel holds the farthest depth of the texels
+ *				it covers, so an object is only hidden if its nearest point
+ *				is behind everything drawn in its screen rectangle.
+ *
+ *				Two pixel pack buffers are used so the readback from one
+ *				frame is collected in a later frame without stalling.
+ *				Objects are tested with the view projection matrix of the
+ *				frame the depth came from, so an object that comes into view
+ *				while the camera moves appears one frame late.
+ *
+ *				The pyramid's storage only grows. Once it has been sized
+ *				for the window, building a pyramid allocates nothing.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Frustum.h"
+
+/* This class holds the depth readback buffers and the Hi-Z pyramid built from them
+*/
+class OcclusionCuller {
+private:
+	static const int NUM_READBACKS = 2;			// Readbacks in flight
+	static const int FIRST_LEVEL_REDUCTION = 4;	// Size of the block of screen pixels reduced into one level 0 texel
+	GLuint pbos[NUM_READBACKS];					// Pixel pack buffers the depth is read into
+	GLsync fences[NUM_READBACKS];				// Signaled when each readback has finished
+	glm::mat4 readbackViewProjections[NUM_READBACKS];	// View projection matrix used to draw each readback
+	int readbackWidths[NUM_READBACKS];			// Size of each readback
+	int readbackHeights[NUM_READBACKS];
+	int nextReadback;							// Buffer the next readback is written to
+	std::vector<std::vector<float>> levels;		// Hi-Z pyramid, level 0 is the largest. Kept between readbacks and only grown
+	std::vector<int> levelWidths;				// Width of each level in texels
+	std::vector<int> levelHeights;				// Height of each level in texels
+	int levelCount;								// Levels of the current pyramid, 0 if there is none
+	glm::mat4 pyramidViewProjection;			// View projection matrix of the frame the pyramid was built from
+
+	// Reduce a depth readback into the pyramid
+	void BuildPyramid(const float* depth, int width, int height);
+	// Farthest depth in a rectangle of a level
+	float MaxDepth(int level, int x0, int y0, int x1, int y1) const;
+
+public:
+	// Constructor. Buffers are created in Create once a context exists
+	OcclusionCuller();
+	// Create the readback buffers
+	void Create();
+	// Free the readback buffers
+	void Destroy();
+	// Make room for the pyramid of a readback this size, so building it later allocates nothing
+	void Reserve(int width, int height);
+	// Collect a finished readback and start a new one from the current depth buffer
+	void CaptureDepth(const glm::mat4& viewProjection, int width, int height);
+	// Throw away the pyramid, for example when occlusion culling is turned back on
+	void Invalidate();
+	// True if there is a pyramid to test against
+	bool Ready() const;
+	// True if the box is completely hidden behind previously drawn depth
+	bool IsOccluded(const AABB& box) const;
+};
+
+// Constructor
+OcclusionCuller::OcclusionCuller() {
+	for (int i = 0; i < NUM_READBACKS; i++) {
+		pbos[i] = 0;
+		fences[i] = 0;
+		readbackWidths[i] = 0;
+		readbackHeights[i] = 0;
+	}
+	nextReadback = 0;
+	levelCount = 0;
+}
+
+// Create the readback buffers
+void OcclusionCuller::Create() {
+	glGenBuffers(NUM_READBACKS, pbos);
+}
+
+// Free the readback buffers
+void OcclusionCuller::Destroy() {
+	for (int i = 0; i < NUM_READBACKS; i++) {
+		if (fences[i]) {
+			glDeleteSync(fences[i]);
+			fences[i] = 0;
+		}
+	}
+	glDeleteBuffers(NUM_READBACKS, pbos);
+	levels.clear();
+	levelWidths.clear();
+	levelHeights.clear();
+	levelCount = 0;
+}
+
+// Make room for the pyramid of a readback this size
+void OcclusionCuller::Reserve(int width, int height) {
+	int levelWidth = (width + FIRST_LEVEL_REDUCTION - 1) / FIRST_LEVEL_REDUCTION;
+	int levelHeight = (height + FIRST_LEVEL_REDUCTION - 1) / FIRST_LEVEL_REDUCTION;
+	for (unsigned int level = 0; ; level++) {
+		if (level == levels.size()) {
+			levels.push_back(std::vector<float>());
+			levelWidths.push_back(0);
+			levelHeights.push_back(0);
+		}
+		if (levels[level].size() < (size_t)levelWidth * levelHeight) {
+			levels[level].resize((size_t)levelWidth * levelHeight);
+		}
+		if (levelWidth <= 1 && levelHeight <= 1) {
+			break;
+		}
+		levelWidth = std::max(1, (levelWidth + 1) / 2);
+		levelHeight = std::max(1, (levelHeight + 1) / 2);
+	}
+}
+
+// Collect a finished readback and start a new one from the current depth buffer
+void OcclusionCuller::CaptureDepth(const glm::mat4& viewProjection, int width, int height) {
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+
+	// The buffer about to be reused holds the oldest readback. Build the pyramid from it if it is finished
+	int current = nextReadback;
+	if (fences[current]) {
+		GLenum status = glClientWaitSync(fences[current], 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[current]);
+			GLsizeiptr size = (GLsizeiptr)readbackWidths[current] * readbackHeights[current] * sizeof(float);
+			const float* depth = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+			if (depth) {
+				BuildPyramid(depth, readbackWidths[current], readbackHeights[current]);
+				pyramidViewProjection = readbackViewProjections[current];
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+		}
+		else {
+			// Still in flight. Keep the old pyramid and try again next frame rather than wait
+			nextReadback = (nextReadback + 1) % NUM_READBACKS;
+			return;
+		}
+		glDeleteSync(fences[current]);
+		fences[current] = 0;
+	}
+
+	// Start reading the depth buffer into the freed buffer
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[current]);
+	if (readbackWidths[current] != width || readbackHeights[current] != height) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * sizeof(float), NULL, GL_STREAM_READ);
+		readbackWidths[current] = width;
+		readbackHeights[current] = height;
+	}
+	glReadPixels(0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readbackViewProjections[current] = viewProjection;
+	nextReadback = (nextReadback + 1) % NUM_READBACKS;
+}
+
+// Reduce a depth readback into the pyramid
+void OcclusionCuller::BuildPyramid(const float* depth, int width, int height) {
+	// Level 0 takes the farthest depth of each block of screen pixels
+	// Only allocates the first time a readback is this big
+	Reserve(width, height);
+
+	int levelWidth = (width + FIRST_LEVEL_REDUCTION - 1) / FIRST_LEVEL_REDUCTION;
+	int levelHeight = (height + FIRST_LEVEL_REDUCTION - 1) / FIRST_LEVEL_REDUCTION;
+	levelWidths[0] = levelWidth;
+	levelHeights[0] = levelHeight;
+	levelCount = 1;
+	std::fill(levels[0].begin(), levels[0].begin() + levelWidth * levelHeight, 0.0f);
+	for (int y = 0; y < height; y++) {
+		float* row = &levels[0][(y / FIRST_LEVEL_REDUCTION) * levelWidth];
+		const float* source = &depth[y * width];
+		for (int x = 0; x < width; x++) {
+			float& texel = row[x / FIRST_LEVEL_REDUCTION];
+			texel = std::max(texel, source[x]);
+		}
+	}
+
+	// Every other level takes the farthest depth of each 2x2 block of the level before it
+	while (levelWidth > 1 || levelHeight > 1) {
+		int previousWidth = levelWidth;
+		int previousHeight = levelHeight;
+		const std::vector<float>& previous = levels[levelCount - 1];
+		levelWidth = std::max(1, (levelWidth + 1) / 2);
+		levelHeight = std::max(1, (levelHeight + 1) / 2);
+		std::vector<float>& level = levels[levelCount];
+		for (int y = 0; y < levelHeight; y++) {
+			int y0 = y * 2;
+			int y1 = std::min(y0 + 1, previousHeight - 1);
+			for (int x = 0; x < levelWidth; x++) {
+				int x0 = x * 2;
+				int x1 = std::min(x0 + 1, previousWidth - 1);
+				level[y * levelWidth + x] = std::max(std::max(previous[y0 * previousWidth + x0], previous[y0 * previousWidth + x1]),
+					std::max(previous[y1 * previousWidth + x0], previous[y1 * previousWidth + x1]));
+			}
+		}
+		levelWidths[levelCount] = levelWidth;
+		levelHeights[levelCount] = levelHeight;
+		levelCount++;
+	}
+}
+
+// Farthest depth in a rectangle of a level
+float OcclusionCuller::MaxDepth(int level, int x0, int y0, int x1, int y1) const {
+	const std::vector<float>& texels = levels[level];
+	int width = levelWidths[level];
+	float result = 0.0f;
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			result = std::max(result, texels[y * width + x]);
+		}
+	}
+	return result;
+}
+
+// Throw away the pyramid
+void OcclusionCuller::Invalidate() {
+	// The storage is kept for the next pyramid
+	levelCount = 0;
+}
+
+// True if there is a pyramid to test against
+bool OcclusionCuller::Ready() const {
+	return levelCount > 0;
+}
+
+// True if the box is completely hidden behind previously drawn depth
+bool OcclusionCuller::IsOccluded(const AABB& box) const {
+	if (levelCount == 0 || box.Empty()) {
+		return false;
+	}
+
+	// Project the corners to find the screen rectangle and nearest depth of the box
+	glm::vec2 screenMin(FLT_MAX);
+	glm::vec2 screenMax(-FLT_MAX);
+	float nearestDepth = FLT_MAX;
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec4 position((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z, 1.0f);
+		glm::vec4 clip = pyramidViewProjection * position;
+		// A corner behind the camera means the box surrounds the viewer, so treat it as visible
+		if (clip.w <= 1e-5f) {
+			return false;
+		}
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		screenMin.x = std::min(screenMin.x, ndc.x);
+		screenMin.y = std::min(screenMin.y, ndc.y);
+		screenMax.x = std::max(screenMax.x, ndc.x);
+		screenMax.y = std::max(screenMax.y, ndc.y);
+		nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+	}
+	if (nearestDepth <= 0.0f) {
+		return false;
+	}
+
+	// Convert to level 0 texels and clamp to the screen
+	int width = levelWidths[0];
+	int height = levelHeights[0];
+	float left = (glm::clamp(screenMin.x, -1.0f, 1.0f) * 0.5f + 0.5f) * width;
+	float right = (glm::clamp(screenMax.x, -1.0f, 1.0f) * 0.5f + 0.5f) * width;
+	float bottom = (glm::clamp(screenMin.y, -1.0f, 1.0f) * 0.5f + 0.5f) * height;
+	float top = (glm::clamp(screenMax.y, -1.0f, 1.0f) * 0.5f + 0.5f) * height;
+
+	// Pick the level where the rectangle covers at most a few texels
+	float size = std::max(right - left, top - bottom);
+	int level = size > 2.0f ? (int)std::ceil(std::log2(size / 2.0f)) : 0;
+	level = std::min(level, levelCount - 1);
+
+	int x0 = std::min((int)left >> level, levelWidths[level] - 1);
+	int x1 = std::min((int)right >> level, levelWidths[level] - 1);
+	int y0 = std::min((int)bottom >> level, levelHeights[level] - 1);
+	int y1 = std::min((int)top >> level, levelHeights[level] - 1);
+	return nearestDepth > MaxDepth(level, x0, y0, x1, y1);
+}
@@ -0,0 +1,559 @@
+#pragma once
+/* Profiler.h : This file contains the code necessary to time the
+ *      passes of a frame on the CPU and the GPU and to show the times
+ *		on top of the scene.
+ *
+ *				Every section of a frame is timed on the CPU with the
+ *				steady clock. Sections that submit GL work are also timed
+ *				on the GPU with a GL_TIME_ELAPSED query. Only one such
+ *				query can run at a time, so GPU timed sections must not
+ *				overlap. There are two sets of queries and each frame uses
+ *				the other set, so a result is read a frame or more after
+ *				it was issued and only once the driver says it is ready.
+ *				A section whose last query has not finished is not timed
+ *				on the GPU that frame, so reading the times never stalls.
+ *
+ *				The overlay draws a table of the averaged times with a
+ *				bar for each, using a 5x7 pixel font built into the file.
+ *				Its vertices are written into the frame's streaming
+ *				buffer, so drawing it allocates nothing. The raw times
+ *				of every frame can also be written to a CSV file.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+#include "RingBuffer.h"
+
+/* This class times the sections of each frame on the CPU and, without stalling, on the GPU
+*/
+class FrameProfiler {
+private:
+	typedef std::chrono::steady_clock Clock;
+	static const unsigned int MAX_SECTIONS = 16;
+	static const unsigned int NUM_FRAMES = 2;		// Sets of queries. A frame's results are read while the other set is in use
+	const double SMOOTHING = 0.05;					// Weight of the newest frame in the averaged times
+
+	// Times of one section
+	struct Section {
+		const char* name;
+		bool gpu;						// Timed on the GPU as well as the CPU
+		Clock::time_point start;		// When the section began this frame
+		double cpuMs;					// CPU time this frame
+		double gpuMs;					// GPU time of the newest frame whose query has finished
+		double averageCpuMs;
+		double averageGpuMs;
+		bool timing;					// True while a query of this section is running
+	};
+
+	Section sections[MAX_SECTIONS];
+	unsigned int sectionCount;
+	GLuint queries[NUM_FRAMES][MAX_SECTIONS];
+	bool pending[NUM_FRAMES][MAX_SECTIONS];		// True if a query was issued and its result not read yet
+	unsigned int frame;							// Query set used by the current frame
+	unsigned long long frameNumber;				// Frames timed since the start
+	FILE* dump;									// File the times of every frame are written to, null if none
+
+	// Read the results of the query set the next frame reuses, skipping any that are not ready
+	void CollectQueries();
+
+public:
+	// Constructor. Queries are created in Create once a context exists
+	FrameProfiler();
+	// Create the queries
+	void Create();
+	// Free the queries and close the dump file
+	void Destroy();
+	// Name a section. gpu also times it with a query
+	void SetSection(unsigned int section, const char* name, bool gpu);
+	// Write the times of every frame to a CSV file from now on. Returns false if the file cannot be opened
+	bool OpenDump(const char* path);
+	// Start timing a frame
+	void BeginFrame();
+	// Finish the frame, averaging its times and writing them to the dump file
+	void EndFrame();
+	// Start and stop timing a section
+	void Begin(unsigned int section);
+	void End(unsigned int section);
+
+	// Number of sections
+	unsigned int Count() const;
+	// Name of a section
+	const char* Name(unsigned int section) const;
+	// True if the section is timed on the GPU
+	bool TimedOnGpu(unsigned int section) const;
+	// Times of a section averaged over recent frames, in milliseconds
+	double AverageCpuMs(unsigned int section) const;
+	double AverageGpuMs(unsigned int section) const;
+};
+
+/* This class times a section while it is alive
+*/
+class ProfileScope {
+private:
+	FrameProfiler& profiler;
+	unsigned int section;
+
+	// Copying would end the section twice
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+
+public:
+	// Start timing the section
+	ProfileScope(FrameProfiler& profiler, unsigned int section);
+	// Stop timing it
+	~ProfileScope();
+};
+
+/* This class draws a profiler's times over the scene
+*/
+class ProfilerOverlay {
+private:
+	static const int GLYPH_WIDTH = 5;			// Size of a glyph in font pixels
+	static const int GLYPH_HEIGHT = 7;
+	static const int GLYPH_COUNT = 43;			// Characters in the font, the last of which is a solid block for bars and the panel
+	static const int ATLAS_WIDTH = GLYPH_COUNT * (GLYPH_WIDTH + 1);	// Glyphs side by side with a column of space between them
+	static const int PIXEL_SCALE = 2;			// Screen pixels per font pixel
+	static const int CHARACTER_ADVANCE = (GLYPH_WIDTH + 1) * PIXEL_SCALE;
+	static const int LINE_HEIGHT = (GLYPH_HEIGHT + 3) * PIXEL_SCALE;
+	static const int MARGIN = 8;				// Space around the panel and between it and the text
+	static const int LINE_CHARACTERS = 26;		// Characters in a line of the table
+	static const int BAR_WIDTH = 160;			// Width of a bar at BAR_MS
+	const double BAR_MS = 16.7;					// Time a full bar stands for, one frame at 60 FPS
+	static const char GLYPH_CHARACTERS[GLYPH_COUNT];		// Character each glyph draws
+	static const unsigned char GLYPH_ROWS[GLYPH_COUNT][GLYPH_HEIGHT];	// Rows of each glyph from the top, one bit per pixel with the leftmost pixel in bit 4
+
+	// Corner of a quad
+	struct Vertex {
+		float x, y;						// Position in pixels from the top left of the window
+		float u, v;						// Texture coordinates in the glyph atlas
+		unsigned char color[4];
+	};
+
+	GLuint texture;						// Glyph atlas
+	GLuint vao;
+	Vertex* vertices;					// Where the current draw writes its quads
+	unsigned int vertexCount;
+	unsigned int vertexCapacity;
+
+	// Add a rectangle showing part of the atlas
+	void Quad(float x, float y, float width, float height, float u0, float v0, float u1, float v1, const unsigned char color[4]);
+	// Add a solid rectangle
+	void Box(float x, float y, float width, float height, const unsigned char color[4]);
+	// Add a line of text. Characters missing from the font are drawn as spaces
+	void Text(float x, float y, const char* text, const unsigned char color[4]);
+	// Glyph of a character, -1 if the font does not have it
+	static int Glyph(char character);
+
+public:
+	// Constructor. The atlas and vertex array are made in Create once a context exists
+	ProfilerOverlay();
+	// Build the glyph atlas and the vertex array
+	void Create();
+	// Free them
+	void Destroy();
+	// Draw the profiler's times in the top left corner with the given program. Nothing is drawn if the ring is full
+	void Draw(const FrameProfiler& profiler, GLuint program, RingBuffer& ring, int width, int height);
+};
+
+// Constructor
+FrameProfiler::FrameProfiler() {
+	sectionCount = 0;
+	frame = 0;
+	frameNumber = 0;
+	dump = NULL;
+	for (unsigned int i = 0; i < MAX_SECTIONS; i++) {
+		sections[i] = Section();
+		sections[i].name = "";
+		for (unsigned int f = 0; f < NUM_FRAMES; f++) {
+			queries[f][i] = 0;
+			pending[f][i] = false;
+		}
+	}
+}
+
+// Create the queries
+void FrameProfiler::Create() {
+	glGenQueries(NUM_FRAMES * MAX_SECTIONS, &queries[0][0]);
+}
+
+// Free the queries and close the dump file
+void FrameProfiler::Destroy() {
+	glDeleteQueries(NUM_FRAMES * MAX_SECTIONS, &queries[0][0]);
+	for (unsigned int f = 0; f < NUM_FRAMES; f++) {
+		for (unsigned int i = 0; i < MAX_SECTIONS; i++) {
+			queries[f][i] = 0;
+			pending[f][i] = false;
+		}
+	}
+	if (dump) {
+		fclose(dump);
+		dump = NULL;
+	}
+}
+
+// Name a section
+void FrameProfiler::SetSection(unsigned int section, const char* name, bool gpu) {
+	if (section >= MAX_SECTIONS) {
+		return;
+	}
+	sections[section].name = name;
+	sections[section].gpu = gpu;
+	sectionCount = std::max(sectionCount, section + 1);
+}
+
+// Write the times of every frame to a CSV file
+bool FrameProfiler::OpenDump(const char* path) {
+	dump = fopen(path, "w");
+	if (!dump) {
+		return false;
+	}
+	// GPU columns hold the newest finished query, which is from a frame or two before the row's frame
+	fprintf(dump, "frame");
+	for (unsigned int i = 0; i < sectionCount; i++) {
+		fprintf(dump, ",%s cpu ms", sections[i].name);
+		if (sections[i].gpu) {
+			fprintf(dump, ",%s gpu ms", sections[i].name);
+		}
+	}
+	fprintf(dump, "\n");
+	return true;
+}
+
+// Read the results of the query set the next frame reuses
+void FrameProfiler::CollectQueries() {
+	for (unsigned int i = 0; i < sectionCount; i++) {
+		if (!pending[frame][i]) {
+			continue;
+		}
+		GLint available = 0;
+		glGetQueryObjectiv(queries[frame][i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			// Still running. The section is left off the GPU this frame instead of waiting
+			continue;
+		}
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(queries[frame][i], GL_QUERY_RESULT, &nanoseconds);
+		pending[frame][i] = false;
+		Section& section = sections[i];
+		section.gpuMs = nanoseconds / 1000000.0;
+		section.averageGpuMs += (section.gpuMs - section.averageGpuMs) * SMOOTHING;
+	}
+}
+
+// Start timing a frame
+void FrameProfiler::BeginFrame() {
+	frame = (frame + 1) % NUM_FRAMES;
+	CollectQueries();
+	for (unsigned int i = 0; i < sectionCount; i++) {
+		sections[i].cpuMs = 0.0;
+	}
+}
+
+// Finish the frame
+void FrameProfiler::EndFrame() {
+	for (unsigned int i = 0; i < sectionCount; i++) {
+		Section& section = sections[i];
+		section.averageCpuMs += (section.cpuMs - section.averageCpuMs) * SMOOTHING;
+	}
+	if (dump) {
+		fprintf(dump, "%llu", frameNumber);
+		for (unsigned int i = 0; i < sectionCount; i++) {
+			fprintf(dump, ",%.3f", sections[i].cpuMs);
+			if (sections[i].gpu) {
+				fprintf(dump, ",%.3f", sections[i].gpuMs);
+			}
+		}
+		fprintf(dump, "\n");
+	}
+	frameNumber++;
+}
+
+// Start timing a section
+void FrameProfiler::Begin(unsigned int section) {
+	Section& timed = sections[section];
+	timed.start = Clock::now();
+	// The set's query for this section may still be waiting on an older frame, and reusing it would stall
+	if (timed.gpu && !pending[frame][section] && queries[frame][section]) {
+		glBeginQuery(GL_TIME_ELAPSED, queries[frame][section]);
+		timed.timing = true;
+	}
+}
+
+// Stop timing a section
+void FrameProfiler::End(unsigned int section) {
+	Section& timed = sections[section];
+	if (timed.timing) {
+		glEndQuery(GL_TIME_ELAPSED);
+		pending[frame][section] = true;
+		timed.timing = false;
+	}
+	timed.cpuMs += std::chrono::duration<double, std::milli>(Clock::now() - timed.start).count();
+}
+
+// Number of sections
+unsigned int FrameProfiler::Count() const {
+	return sectionCount;
+}
+
+// Name of a section
+const char* FrameProfiler::Name(unsigned int section) const {
+	return sections[section].name;
+}
+
+// True if the section is timed on the GPU
+bool FrameProfiler::TimedOnGpu(unsigned int section) const {
+	return sections[section].gpu;
+}
+
+// Times of a section averaged over recent frames
+double FrameProfiler::AverageCpuMs(unsigned int section) const {
+	return sections[section].averageCpuMs;
+}
+
+double FrameProfiler::AverageGpuMs(unsigned int section) const {
+	return sections[section].averageGpuMs;
+}
+
+// Start timing the section
+ProfileScope::ProfileScope(FrameProfiler& profiler, unsigned int section) : profiler(profiler) {
+	this->section = section;
+	profiler.Begin(section);
+}
+
+// Stop timing it
+ProfileScope::~ProfileScope() {
+	profiler.End(section);
+}
+
+const char ProfilerOverlay::GLYPH_CHARACTERS[GLYPH_COUNT] = {
+	'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', ':', '-', '/', '%', ' ', '\0'
+};
+
+const unsigned char ProfilerOverlay::GLYPH_ROWS[GLYPH_COUNT][GLYPH_HEIGHT] = {
+	{ 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },	// A
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },	// B
+	{ 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },	// C
+	{ 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },	// D
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },	// E
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },	// F
+	{ 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },	// G
+	{ 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },	// H
+	{ 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },	// I
+	{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },	// J
+	{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },	// K
+	{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },	// L
+	{ 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },	// M
+	{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },	// N
+	{ 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },	// O
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },	// P
+	{ 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },	// Q
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },	// R
+	{ 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },	// S
+	{ 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },	// T
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },	// U
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },	// V
+	{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },	// W
+	{ 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },	// X
+	{ 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 },	// Y
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },	// Z
+	{ 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },	// 0
+	{ 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },	// 1
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },	// 2
+	{ 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },	// 3
+	{ 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },	// 4
+	{ 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },	// 5
+	{ 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },	// 6
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },	// 7
+	{ 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },	// 8
+	{ 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },	// 9
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },	// .
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },	// :
+	{ 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },	// -
+	{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },	// /
+	{ 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },	// %
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// Space
+	{ 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F }	// Solid block
+};
+
+// Constructor
+ProfilerOverlay::ProfilerOverlay() {
+	texture = 0;
+	vao = 0;
+	vertices = NULL;
+	vertexCount = 0;
+	vertexCapacity = 0;
+}
+
+// Build the glyph atlas and the vertex array
+void ProfilerOverlay::Create() {
+	unsigned char atlas[GLYPH_HEIGHT][ATLAS_WIDTH] = {};
+	for (int glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+		for (int row = 0; row < GLYPH_HEIGHT; row++) {
+			for (int column = 0; column < GLYPH_WIDTH; column++) {
+				if (GLYPH_ROWS[glyph][row] & (0x10 >> column)) {
+					atlas[row][glyph * (GLYPH_WIDTH + 1) + column] = 255;
+				}
+			}
+		}
+	}
+	// The first row uploaded is the top of the glyphs, at v = 0
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, GLYPH_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, atlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// The vertex buffer is bound from the streaming buffer on every draw
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glEnableVertexAttribArray(0);
+	glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, x));
+	glVertexAttribBinding(0, 0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, u));
+	glVertexAttribBinding(1, 0);
+	glEnableVertexAttribArray(2);
+	glVertexAttribFormat(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, color));
+	glVertexAttribBinding(2, 0);
+	glBindVertexArray(0);
+}
+
+// Free the atlas and the vertex array
+void ProfilerOverlay::Destroy() {
+	glDeleteTextures(1, &texture);
+	glDeleteVertexArrays(1, &vao);
+	texture = 0;
+	vao = 0;
+}
+
+// Glyph of a character
+int ProfilerOverlay::Glyph(char character) {
+	const char* found = (const char*)memchr(GLYPH_CHARACTERS, toupper((unsigned char)character), GLYPH_COUNT - 1);
+	return found ? (int)(found - GLYPH_CHARACTERS) : -1;
+}
+
+// Add a rectangle showing part of the atlas
+void ProfilerOverlay::Quad(float x, float y, float width, float height, float u0, float v0, float u1, float v1, const unsigned char color[4]) {
+	if (vertexCount + 6 > vertexCapacity) {
+		return;
+	}
+	const Vertex corners[4] = {
+		{ x, y, u0, v0, { color[0], color[1], color[2], color[3] } },
+		{ x + width, y, u1, v0, { color[0], color[1], color[2], color[3] } },
+		{ x + width, y + height, u1, v1, { color[0], color[1], color[2], color[3] } },
+		{ x, y + height, u0, v1, { color[0], color[1], color[2], color[3] } }
+	};
+	static const int order[6] = { 0, 1, 2, 0, 2, 3 };
+	for (int i = 0; i < 6; i++) {
+		vertices[vertexCount++] = corners[order[i]];
+	}
+}
+
+// Add a solid rectangle
+void ProfilerOverlay::Box(float x, float y, float width, float height, const unsigned char color[4]) {
+	// Every corner samples the middle of the solid block glyph
+	float u = ((GLYPH_COUNT - 1) * (GLYPH_WIDTH + 1) + GLYPH_WIDTH * 0.5f) / ATLAS_WIDTH;
+	Quad(x, y, width, height, u, 0.5f, u, 0.5f, color);
+}
+
+// Add a line of text
+void ProfilerOverlay::Text(float x, float y, const char* text, const unsigned char color[4]) {
+	for (; *text; text++, x += CHARACTER_ADVANCE) {
+		int glyph = Glyph(*text);
+		if (glyph < 0 || GLYPH_CHARACTERS[glyph] == ' ') {
+			continue;
+		}
+		float u0 = (float)(glyph * (GLYPH_WIDTH + 1)) / ATLAS_WIDTH;
+		float u1 = (float)(glyph * (GLYPH_WIDTH + 1) + GLYPH_WIDTH) / ATLAS_WIDTH;
+		Quad(x, y, (float)(GLYPH_WIDTH * PIXEL_SCALE), (float)(GLYPH_HEIGHT * PIXEL_SCALE), u0, 0.0f, u1, 1.0f, color);
+	}
+}
+
+// Draw the profiler's times in the top left corner
+void ProfilerOverlay::Draw(const FrameProfiler& profiler, GLuint program, RingBuffer& ring, int width, int height) {
+	static const unsigned char panelColor[4] = { 0, 0, 0, 170 };
+	static const unsigned char textColor[4] = { 230, 230, 230, 255 };
+	static const unsigned char cpuColor[4] = { 90, 200, 110, 255 };
+	static const unsigned char gpuColor[4] = { 240, 150, 60, 255 };
+	if (!program || !vao || width <= 0 || height <= 0) {
+		return;
+	}
+
+	// A header, a line per section, and a GPU total, each with its text and up to two bars, plus the panel
+	unsigned int lines = profiler.Count() + 2;
+	unsigned int maxQuads = 1 + lines * (LINE_CHARACTERS + 2);
+	RingAllocation allocation = ring.Allocate(maxQuads * 6 * sizeof(Vertex), sizeof(float));
+	if (!allocation.data) {
+		return;
+	}
+	vertices = (Vertex*)allocation.data;
+	vertexCount = 0;
+	vertexCapacity = maxQuads * 6;
+
+	float textX = (float)(MARGIN * 2);
+	float barX = textX + LINE_CHARACTERS * CHARACTER_ADVANCE + MARGIN;
+	float panelWidth = barX + BAR_WIDTH;
+	Box((float)MARGIN, (float)MARGIN, panelWidth, (float)(lines * LINE_HEIGHT + MARGIN * 2), panelColor);
+
+	// Each line is written into a buffer on the stack, so formatting allocates nothing
+	char line[64];
+	float y = (float)(MARGIN * 2);
+	Text(textX, y, "PASS       CPU MS  GPU MS", textColor);
+	y += LINE_HEIGHT;
+	double gpuTotal = 0.0;
+	for (unsigned int i = 0; i < profiler.Count(); i++) {
+		double cpuMs = profiler.AverageCpuMs(i);
+		if (profiler.TimedOnGpu(i)) {
+			double gpuMs = profiler.AverageGpuMs(i);
+			gpuTotal += gpuMs;
+			snprintf(line, sizeof(line), "%-10.10s %6.2f  %6.2f", profiler.Name(i), cpuMs, gpuMs);
+			Box(barX, y + LINE_HEIGHT / 2, (float)(std::min(gpuMs / BAR_MS, 1.0) * BAR_WIDTH), (float)(PIXEL_SCALE * 3), gpuColor);
+		}
+		else {
+			snprintf(line, sizeof(line), "%-10.10s %6.2f       -", profiler.Name(i), cpuMs);
+		}
+		Box(barX, y, (float)(std::min(cpuMs / BAR_MS, 1.0) * BAR_WIDTH), (float)(PIXEL_SCALE * 3), cpuColor);
+		Text(textX, y, line, textColor);
+		y += LINE_HEIGHT;
+	}
+	snprintf(line, sizeof(line), "GPU TOTAL          %6.2f", gpuTotal);
+	Text(textX, y, line, textColor);
+	Box(barX, y + LINE_HEIGHT / 2, (float)(std::min(gpuTotal / BAR_MS, 1.0) * BAR_WIDTH), (float)(PIXEL_SCALE * 3), gpuColor);
+
+	// Drawn over everything, blended, and without touching the depth buffer the occlusion readback uses
+	glUseProgram(program);
+	glUniform2f(glGetUniformLocation(program, "screenSize"), (float)width, (float)height);
+	glUniform1i(glGetUniformLocation(program, "glyphs"), 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	ring.Commit(allocation);
+	glBindVertexArray(vao);
+	glBindVertexBuffer(0, ring.Buffer(), allocation.offset, sizeof(Vertex));
+	glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+	glBindVertexArray(0);
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+	vertices = NULL;
+}
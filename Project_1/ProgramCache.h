@@ -0,0 +1,191 @@
+#pragma once
+/* ProgramCache.h : This file contains the code necessary to save
+ *      linked shader programs to disk and load them on later runs,
+ *		which skips GLSL compilation at startup.
+ *
+ *				Each program is stored in its own file named after a hash
+ *				of its sources and of the driver's vendor, renderer, and
+ *				version strings. A driver update or a source change gives
+ *				a new name, and a binary the driver rejects anyway is
+ *				simply compiled again and overwritten.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+/* This class loads and stores program binaries in a cache directory
+*/
+class ProgramCache {
+private:
+	static const uint32_t FILE_MAGIC = 0x50434231;	// "PCB1", marks a cache file written by this class
+	std::string directory;				// Folder the binaries are kept in
+	std::string driver;					// Vendor, renderer, and version strings of the current context
+	bool checked;						// True once the driver has been asked whether it supports binaries
+	bool supported;						// True if the driver has at least one program binary format
+	unsigned int hits;					// Programs loaded from the cache
+	unsigned int misses;				// Programs that had to be compiled
+
+	// File a program with these sources is stored in
+	std::string FileName(const char* vertexSource, const char* fragmentSource) const;
+	// Ask the driver about binary support and read its strings. Needs a current context
+	void CheckDriver();
+	// 64-bit FNV-1a hash, continuing from a previous hash
+	static uint64_t Hash(const char* text, uint64_t hash);
+
+public:
+	// Constructor
+	explicit ProgramCache(const char* directory);
+	// Load a program for these sources into program. Returns false if there is no usable binary
+	bool Load(const char* vertexSource, const char* fragmentSource, GLuint program);
+	// Save a linked program for these sources. It must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	void Save(const char* vertexSource, const char* fragmentSource, GLuint program);
+	// True if programs should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	bool Enabled();
+	// Programs loaded from the cache
+	unsigned int Hits() const;
+	// Programs that had to be compiled
+	unsigned int Misses() const;
+};
+
+// Constructor
+ProgramCache::ProgramCache(const char* directory) : directory(directory) {
+	checked = false;
+	supported = false;
+	hits = 0;
+	misses = 0;
+}
+
+// 64-bit FNV-1a hash, continuing from a previous hash
+uint64_t ProgramCache::Hash(const char* text, uint64_t hash) {
+	for (const unsigned char* c = (const unsigned char*)text; *c; c++) {
+		hash ^= *c;
+		hash *= 1099511628211ull;
+	}
+	// Separate the strings so "ab" + "c" and "a" + "bc" hash differently
+	hash ^= 0xff;
+	hash *= 1099511628211ull;
+	return hash;
+}
+
+// Ask the driver about binary support and read its strings
+void ProgramCache::CheckDriver() {
+	if (checked) {
+		return;
+	}
+	checked = true;
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	supported = formats > 0;
+	const GLubyte* vendor = glGetString(GL_VENDOR);
+	const GLubyte* renderer = glGetString(GL_RENDERER);
+	const GLubyte* version = glGetString(GL_VERSION);
+	driver = std::string(vendor ? (const char*)vendor : "") + "|" + (renderer ? (const char*)renderer : "") + "|" + (version ? (const char*)version : "");
+	if (supported) {
+#ifdef _WIN32
+		_mkdir(directory.c_str());
+#else
+		mkdir(directory.c_str(), 0755);
+#endif
+	}
+}
+
+// True if programs should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+bool ProgramCache::Enabled() {
+	CheckDriver();
+	return supported;
+}
+
+// File a program with these sources is stored in
+std::string ProgramCache::FileName(const char* vertexSource, const char* fragmentSource) const {
+	uint64_t hash = 14695981039346656037ull;
+	hash = Hash(driver.c_str(), hash);
+	hash = Hash(vertexSource, hash);
+	hash = Hash(fragmentSource, hash);
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+	return directory + "/" + name;
+}
+
+// Load a program for these sources into program
+bool ProgramCache::Load(const char* vertexSource, const char* fragmentSource, GLuint program) {
+	if (!Enabled()) {
+		misses++;
+		return false;
+	}
+	bool loaded = false;
+	FILE* file = fopen(FileName(vertexSource, fragmentSource).c_str(), "rb");
+	if (file) {
+		uint32_t magic = 0;
+		GLenum format = 0;
+		uint32_t length = 0;
+		if (fread(&magic, sizeof(magic), 1, file) == 1 && magic == FILE_MAGIC
+			&& fread(&format, sizeof(format), 1, file) == 1 && fread(&length, sizeof(length), 1, file) == 1 && length > 0) {
+			std::vector<char> binary(length);
+			if (fread(binary.data(), 1, length, file) == length) {
+				// The driver may still refuse the binary, for example after an update that kept its strings
+				glProgramBinary(program, format, binary.data(), length);
+				GLint status = GL_FALSE;
+				glGetProgramiv(program, GL_LINK_STATUS, &status);
+				loaded = status == GL_TRUE;
+			}
+		}
+		fclose(file);
+	}
+	if (loaded) {
+		hits++;
+	}
+	else {
+		misses++;
+	}
+	return loaded;
+}
+
+// Save a linked program for these sources
+void ProgramCache::Save(const char* vertexSource, const char* fragmentSource, GLuint program) {
+	if (!Enabled()) {
+		return;
+	}
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, NULL, &format, binary.data());
+	FILE* file = fopen(FileName(vertexSource, fragmentSource).c_str(), "wb");
+	if (!file) {
+		return;
+	}
+	uint32_t magic = FILE_MAGIC;
+	uint32_t size = (uint32_t)length;
+	fwrite(&magic, sizeof(magic), 1, file);
+	fwrite(&format, sizeof(format), 1, file);
+	fwrite(&size, sizeof(size), 1, file);
+	fwrite(binary.data(), 1, length, file);
+	fclose(file);
+}
+
+// Programs loaded from the cache
+unsigned int ProgramCache::Hits() const {
+	return hits;
+}
+
+// Programs that had to be compiled
+unsigned int ProgramCache::Misses() const {
+	return misses;
+}
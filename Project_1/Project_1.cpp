@@ -14,10 +14,35 @@
 #include <glfw\glfw3.h>
 #include <vector>
 #include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
 #include "cylinder.h"
 #include "Cuboid.h"
 #include "camera.h"
 #include "Sphere.h"
+#include "Bvh.h"
+#include "OcclusionCuller.h"
+#include "ShadowMaps.h"
+#include "Lightmap.h"
+#include "ShaderVariants.h"
+#include "ProgramCache.h"
+#include "ShaderStages.h"
+#include "ShaderWatcher.h"
+#include "RingBuffer.h"
+#include "FrameUniforms.h"
+#include "GeometryBatch.h"
+#include "GeometryCache.h"
+#include "FramePacer.h"
+#include "SceneFile.h"
+#include "SceneBake.h"
+#include "SceneGraph.h"
+#include "EntityWorld.h"
+#include "JobSystem.h"
+#include "FramePipeline.h"
+#include "Arena.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -34,10 +59,6 @@ namespace {
     // Constants for dimensions of the window
     const int WINDOW_WIDTH = 800;
     const int WINDOW_HEIGHT = 600;
-    const int FLOOR_LENGTH = 2;
-    const int FLOOR_WIDTH = 3;
-    const float WALL_LENGTH = 0.4f;
-    const int WALL_WIDTH = 3;
     const float PI = 3.14159265359f;		// PI rounded
 
     // Type of shader resource
@@ -50,8 +71,30 @@ namespace {
     using std::vector;
 
     // Time keeping
-    float deltaTime = 0.0f;     // Time between this frame and the one before it
-    float lastFrame = 0.0f;     // Time of last frame
+    float deltaTime = 0.0f;     // Smoothed time between this frame and the one before it
+
+    // Frame pacing
+    int swapInterval = 1;               // Vertical blanks per buffer swap, 0 turns vsync off. Set with --vsync
+    double frameRateLimit = 0.0;        // Frames per second while the scene is in use, 0 for no limit. Set with --fps
+    const double IDLE_DELAY = 2.0;      // Seconds without input before the frame rate drops
+    const double IDLE_FRAME_RATE = 10.0;    // Frames per second while idle, enough to pick up a finished lightmap or shader edit
+    double lastActivity = 0.0;          // Time of the last input
+
+    // Render on demand. The scene only changes through input, shader edits, and the lightmap bake,
+    // so frames are only drawn after one of those and the loop sleeps in between
+    bool renderOnDemand = true;         // Turn off with --continuous or R
+    const int REDRAW_FRAMES = 2;        // Frames drawn after a change. The second lets occlusion culling use depth from the new view
+    const double WAIT_TIMEOUT = 0.25;   // Longest sleep between checks of the lightmap bake and the shader files
+    std::atomic<int> redrawFrames(REDRAW_FRAMES);   // Frames still to draw before the loop sleeps again. The render thread sets it after a shader reload
+
+    // Scene file the room is read from. Set with --scene
+    string sceneFileName = "scenes/living_room.scene";
+
+    // Frame preparation is split into jobs of this many entities and run on every core
+    const unsigned int JOB_GRAIN = 256;
+    // Scene parts with their own buffers are generated in jobs of this many parts while the scene is built
+    const unsigned int BUILD_GRAIN = 8;
+    unsigned int jobThreads = 0;        // Threads running jobs, 0 for one per core. Set with --threads
 
     // Mouse control variables
     float lastX = WINDOW_WIDTH / 2.0f;
@@ -60,17 +103,34 @@ namespace {
     // Camera position information
     Camera camera(glm::vec3(0.0f, 5.0f, 5.0f));
 
-    // Object and light data
+    // Object data and the light values used until the scene file replaces them
     glm::vec3 gObjectColor(1.0f, 0.2f, 0.0f);           // Object color for shader
-    glm::vec3 gLight1Color(1.0f, 1.0f, 0.941f);         // Key light color
-    glm::vec3 gLight2Color(1.0f, 1.0f, 0.778f);         // Fill light color
-    glm::vec3 gLight1Position(-5.1f, 6.5f, -8.3f);      // Key light position
+    const glm::vec3 KEY_LIGHT_COLOR(1.0f, 1.0f, 0.941f);        // Key light color
+    const glm::vec3 FILL_LIGHT_COLOR(1.0f, 1.0f, 0.778f);       // Fill light color
+    const glm::vec3 KEY_LIGHT_POSITION(-5.1f, 6.5f, -8.3f);     // Key light position
     glm::vec3 gLight1Scale(0.3f);                       // Key light scale
-    glm::vec3 gLight2Position(15.0f, 12.0f, 0.0f);      // Fill light position
+    const glm::vec3 FILL_LIGHT_POSITION(15.0f, 12.0f, 0.0f);    // Fill light position
     glm::vec3 gLight2Scale(1.0f);                       // Fill light scale
-    GLfloat gLight1Intensity = 0.1f;                    // Intensity of lamp light
-    GLfloat gLight2Intensity = 0.2f;                   // Intensity of fluorescent light
+    const GLfloat KEY_LIGHT_INTENSITY = 0.1f;           // Intensity of lamp light
+    const GLfloat FILL_LIGHT_INTENSITY = 0.2f;          // Intensity of fluorescent light
     glm::vec2 gUVScale(1.0f, 1.0f);                     // Scale for texture coordinates
+    const glm::vec3 FILL_LIGHT_TARGET(0.0f, 0.0f, -4.0f);       // Point the fill light's shadow map is aimed at
+
+    // Texture units for the shadow maps. Mesh textures use unit 0
+    const GLuint SHADOW_CUBE_UNIT = 1;
+    const GLuint SHADOW_MAP_UNIT = 2;
+
+    // Texture unit for the baked lightmap atlas
+    const GLuint LIGHTMAP_UNIT = 3;
+
+    // Number of lights the object shader variants are compiled for
+    const unsigned int SCENE_LIGHT_COUNT = 2;
+
+    // Features of the object shader variant drawn in place of one that fails to build
+    const unsigned int OBJECT_FALLBACK_FEATURES = SHADER_TEXTURED | SHADER_SPECULAR | SHADER_SHADOWS;
+
+    // Vertex buffer binding the per-instance model matrices are read from. Bindings 0 to 2 hold the vertex attributes
+    const GLuint INSTANCE_BINDING = 3;
 
     // Projection set to perspective or not
     bool perspective = true;
@@ -82,12 +142,32 @@ namespace {
     float orthoMinMultiplier = -10;
     float orthoMaxMultiplier = 10;
 
-};
+    // Skip meshes outside of the view frustum
+    bool frustumCulling = true;
 
-/*Shader program Macro*/
-#ifndef GLSL
-#define GLSL(Version, Source) "#version " #Version " core \n" #Source
-#endif
+    // Skip meshes hidden behind other meshes
+    bool occlusionCulling = false;
+
+    // Use baked lighting for static meshes when the lightmap matches the scene
+    bool bakedLighting = true;
+
+    // Show the CPU and GPU time of each pass over the scene
+    bool showProfiler = false;
+    string profileDumpFile;             // CSV file the times of every frame are written to, empty for none. Set with --profile-dump
+
+    // Counters for the current frame, reported in the window title
+    struct FrameStats {
+        GLuint drawn = 0;           // Meshes drawn
+        GLuint drawCalls = 0;       // Draw calls issued for them. Copies of a shared shape are drawn with one call
+        GLuint culled = 0;          // Meshes skipped because they are outside the view frustum
+        GLuint occluded = 0;        // Meshes skipped because they are hidden behind other meshes
+    };
+    FrameStats frameStats;          // Written by the render thread
+    float statsTime = 0.0f;         // Time the statistics were last reported
+    GLuint statsFrames = 0;         // Frames the render thread had drawn when the statistics were last reported
+    uint64_t statsAllocations = 0;  // Heap allocations of per-frame code when the statistics were last reported
+
+};
 
 
 // Structure to store mesh data
@@ -97,8 +177,46 @@ struct GLMesh {
     GLuint vao;                 // Vertex Array Object
     GLuint vbos[2];             // Vertex Buffer Objects
     GLuint nIndices;            // Number of indices
+    GLintptr vertexOffset = 0;  // Byte offset of the first vertex in vbos[0]
+    GLintptr indexOffset = 0;   // Byte offset of the first index in vbos[1]
+    bool batched = false;       // True if the buffers belong to the scene's geometry batch, which deletes them
     GLuint texture;             // Texture for mesh
-    glm::mat4 model;                 // Model matrix for object
+    AABB localBounds;           // Bounds of the vertices before the model matrix is applied
+    bool castsShadow = true;    // Drawn into the shadow maps
+    GLuint lightmapVao = 0;     // Vertex array with lightmap UVs, 0 until a lightmap is baked
+    GLuint lightmapVbo = 0;     // Unwelded vertices with lightmap UVs
+    unsigned int material = SHADER_TEXTURED | SHADER_SPECULAR | SHADER_SHADOWS;    // Shader features the mesh needs
+    bool cachedShape = false;   // True if the buffers belong to a shape in the geometry cache
+    ShapeKey shapeKey;          // Cached shape the mesh uses
+    int instanceGroup = -1;     // Group that draws this mesh together with other copies of its shape, -1 if drawn alone
+    glm::mat4 offset = glm::mat4(1.0f);     // Moves a cached shape to where this part sits, applied before the model matrix
+    glm::mat4 placement = glm::mat4(1.0f);  // Model matrix given by the scene file
+};
+
+// One cached shape shared by several identical parts. Visible parts are drawn together with one instanced draw call
+struct InstanceGroup {
+    GLMesh shape;               // The cached shape at the origin
+    GLuint instanceVao;         // Vertex array that also reads a model matrix per instance
+    unsigned int material;      // Shader features of the parts
+    GLuint texture;             // Texture of the parts
+    unsigned int parts = 0;     // Parts drawn with the group
+    glm::mat4* models = nullptr;    // Model matrices of the parts to draw this frame, in the frame arena
+    unsigned int modelCount = 0;
+};
+
+// Object read from the scene file
+struct SceneModel {
+    string name;                // Name used when the object is picked
+    glm::mat4 transform = glm::mat4(1.0f);  // Model matrix of the object. Its parts are placed relative to it
+    int node = -1;              // Scene graph node of the object, parent of its parts' nodes
+    vector<GLMesh> parts;       // One mesh per shape
+};
+
+// Entry in the list of every placed mesh. Index in the list is the mesh's entity and its item index in the BVH
+struct SceneObject {
+    GLMesh* mesh;               // Mesh that was placed
+    string name;                // Object the mesh is part of
+    unsigned int part;          // Index of the mesh within the object
 };
 
 // Structure to store light mesh data
@@ -118,35 +236,177 @@ struct Vertex {
     GLfloat z;
 };
 
+// Everything the render thread needs to draw one frame. The simulation thread fills a new one for every frame
+struct FramePacket {
+    glm::mat4 view;             // Camera view matrix
+    glm::mat4 projection;       // Perspective or orthographic projection
+    glm::vec3 viewPosition;     // Camera position
+    LightComponent lights[2];   // Key and fill light as they were when the frame was simulated
+    bool frustumCulling;        // Settings toggled from the keyboard
+    bool occlusionCulling;
+    bool bakedLighting;
+    bool showProfiler;
+    int swapInterval;           // Vertical blanks per buffer swap
+    int framebufferWidth;       // Size of the window's framebuffer in pixels
+    int framebufferHeight;
+};
+
+// What the render thread tells the simulation thread about the frames it drew, for the window title
+struct RenderReport {
+    FrameStats stats;           // Counters of the last frame drawn
+    unsigned int frames = 0;    // Frames drawn since the start
+    unsigned int shadowRenders = 0; // Times the shadow maps were rendered
+    unsigned int shaderVariants = 0;    // Object shader variants built
+    const char* lighting = nullptr; // Which lighting the static meshes were drawn with, null before the first frame
+};
+
 // GLFW Window
 GLFWwindow* gWindow = nullptr;
 // Mesh data
-GLMesh gSoccerBall;
-GLMesh gFloor;
-GLMesh gWallTop;
-GLMesh gWallBottom;
 GLMesh gLight1;
 GLMesh gLight2;
-
-vector<GLMesh> gCoffeeTable;
-vector<GLMesh> gTrim;
-vector<GLMesh> gEndTable;
-vector<GLMesh> gCouch;
-vector<GLMesh> gLamp;
+vector<SceneModel> gSceneModels;        // Objects of the scene file in the order they are listed
 
 // Program for shader
-GLuint gProgram1;
 GLuint gProgram2;
-// Texture storage
-GLuint gEndTableCylindersTexture;           // Texture for legs and supports
-GLuint gEndTableSurfacesTexture;            // Texture for surfaces
-GLuint gCoffeeTableTopTexture;              // Texture for top surface of coffee table
-GLuint gCoffeeTableUnder;                   // Texture for under sides of coffee table
-GLuint gTrimTexture;                        // Texture for wall trim
-GLuint gCouchTexture;                       // Texture for the couch
-GLuint gCouchCushionTexture;                // Texture for the couch cushions
-GLuint gLampTexture;                        // Texture for the lamp
-GLuint gLampShadeTexture;                   // Texture for the lamp shade
+GLuint gShadowProgram;
+GLuint gLightmapProgram;
+GLuint gHudProgram;
+// Texture storage, in the order the scene file lists the textures
+vector<GLuint> gSceneTextures;
+
+// View frustum for the current frame
+Frustum gFrustum;
+
+// Every placed mesh and a bounding volume hierarchy over them for culling and picking
+vector<SceneObject> gSceneObjects;
+Bvh gSceneBvh;
+
+// Transform hierarchy of the objects and lights, the entity each node places (-1 for object nodes), and the world bounds of every entity
+SceneGraph gSceneGraph;
+vector<int> gNodeEntities;
+vector<AABB> gSceneBounds;
+
+// Worker threads for frame preparation
+JobSystem gJobSystem;
+
+// The render thread, which owns the GL context while the main thread simulates, and the buffers passing frames between them
+std::thread gRenderThread;
+std::atomic<bool> gRenderRunning(false);
+TripleBuffer<FramePacket> gFramePackets;
+TripleBuffer<RenderReport> gRenderReports;
+WakeSignal gRenderWake;                 // Signalled when the simulation thread publishes a frame packet
+WakeSignal gFrameTaken;                 // Signalled when the render thread takes a frame packet
+
+// Components of every placed mesh and light, the entities of the key and fill lights, and the sorted list of entities to draw this frame
+EntityWorld gEntities;
+Entity gLightEntities[2];
+DrawItem* gDrawList = nullptr;          // In the frame arena
+unsigned int gDrawCount = 0;
+
+// Primitive shapes shared by every mesh with the same dimensions, and the groups that draw copies of them instanced
+GeometryCache gGeometryCache;
+vector<InstanceGroup> gInstanceGroups;
+
+// One vertex buffer and one index buffer holding every shape and part the scene file built
+GeometryBatch gSceneBatch;
+
+// Scene graph nodes of the light meshes and the light positions they were last moved to. Render thread only
+int gLightNodes[2] = { -1, -1 };
+glm::vec3 gPlacedLightPositions[2];
+
+// Held while the render thread moves entities and while the main thread picks from them
+std::mutex gPlacementLock;
+
+// Hi-Z pyramid built from previous frames' depth for occlusion culling
+OcclusionCuller gOcclusionCuller;
+
+// Cached shadow maps for both lights and a counter that changes whenever objects are placed
+ShadowMaps gShadowMaps;
+unsigned int gSceneVersion = 0;
+
+// Lightmap baked in the background and the scene version it was started for
+LightmapBaker gLightmapBaker;
+GLuint gLightmapTexture = 0;
+unsigned int gLightmapSceneVersion = 0;
+std::atomic<bool> gLightmapPending(false);  // True while a bake is running and has not been uploaded
+bool gDrawLightmapped = false;          // True while static meshes are drawn with the lightmap program
+
+// Linked program binaries saved from earlier runs
+ProgramCache gProgramCache("shader_cache");
+
+// A program whose shaders were submitted but whose results have not been checked yet
+struct PendingProgram {
+    GLuint program;
+    GLuint vertexShader;
+    GLuint fragmentShader;
+    string vertexSource;        // Kept to save the binary once the program links
+    string fragmentSource;
+};
+vector<PendingProgram> gPendingPrograms;
+
+// Compiled shader stages shared between programs, and the stages each linked program was built from
+struct ProgramStages {
+    GLuint vertexShader;
+    GLuint fragmentShader;
+};
+ShaderStages gShaderStages;
+std::map<GLuint, ProgramStages> gProgramStages;
+
+// Shader files are read from this folder at startup and reloaded when they are saved
+const char* const SHADER_DIRECTORY = "shaders";
+const char* const OBJECT_VERTEX_SHADER = "object.vert";
+const char* const OBJECT_FRAGMENT_SHADER = "object.frag";
+const char* const FRAME_DATA_SHADER = "frame_data.glsl";     // FrameData block placed in every shader, so all programs share one layout
+
+// A program built from one vertex and one fragment shader file
+struct ShaderFileProgram {
+    GLuint* program;            // Program variable to replace when either file changes
+    const char* vertexFile;
+    const char* fragmentFile;
+};
+ShaderFileProgram gShaderFilePrograms[] = {
+    { &gProgram2, "light.vert", "light.frag" },
+    { &gShadowProgram, "shadow.vert", "shadow.frag" },
+    { &gLightmapProgram, "lightmap.vert", "lightmap.frag" },
+    { &gHudProgram, "hud.vert", "hud.frag" }
+};
+std::map<string, string> gShaderSources;    // Contents of each shader file by file name
+ShaderWatcher gShaderWatcher;
+
+// Streaming buffer that uniforms, instance data, and dynamic vertices are sub-allocated from each frame
+RingBuffer gFrameRing;
+const GLsizeiptr FRAME_RING_SIZE = 256 * 1024;  // Bytes available to each frame
+
+// Client memory for the render thread's arrays that only last one frame, given back at the start of the next frame
+const size_t FRAME_ARENA_SIZE = 256 * 1024;
+Arena gFrameArena(FRAME_ARENA_SIZE);
+
+// Limits the frame rate and smooths the frame time
+FramePacer gFramePacer;
+
+// Parts of a frame the profiler times. Sections that submit GL work are timed on the GPU too and must not overlap
+enum ProfileSection {
+    PROFILE_FRAME,              // Everything before the swap
+    PROFILE_SHADOWS,
+    PROFILE_CULLING,
+    PROFILE_DRAW_LIST,
+    PROFILE_OBJECTS,
+    PROFILE_INSTANCES,
+    PROFILE_LIGHTS,
+    PROFILE_OVERLAY,
+    PROFILE_READBACK,
+    PROFILE_SWAP
+};
+FrameProfiler gProfiler;
+ProfilerOverlay gProfilerOverlay;
+
+// Camera and lighting values shared by every program through the FrameData uniform block
+FrameUniforms gFrameUniforms;
+
+// Frame state for the object programs
+vector<GLuint> gPreparedPrograms;       // Object programs whose texture units have been set this frame
+GLuint gObjectProgram = 0;              // Object program currently in use
 
 
 
@@ -155,220 +415,232 @@ bool Setup(int, char* [], GLFWwindow** window);
 void ChangeSize(GLFWwindow* window, int width, int height);
 void ProcessInput(GLFWwindow* window);
 void DestroyMesh(GLMesh& mesh);
-void Display();
-bool CreateShaderProgram(const char* VertexShaderSource, const char* fragmentShaderSource, GLuint& programId);
+void Display(const FramePacket& frame);
+bool BeginShaderProgram(const char* VertexShaderSource, const char* fragmentShaderSource, GLuint& programId);
+bool FinishShaderProgram(GLuint programId);
 void DestroyShaderProgram(GLuint programId);
 bool TestResource(GLuint input, Resource resource);
 void MousePositionCallback(GLFWwindow* window, double xpos, double ypos);
 void MouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
-void CreatePlane(GLMesh& plane, Vertex backLeft, GLfloat length, GLfloat width, GLuint texture);
+void GeneratePlane(GLMesh& plane, Vertex frontRight, GLfloat length, GLfloat width);
 void KeyCallBack(GLFWwindow* window, int key, int scancode, int action, int mods);
-void BuildObjects();
+bool LoadScene(const string& path);
+void BuildObjects(const SceneDescription& scene);
+void BuildBakedObjects(const SceneBake& bake);
+bool SaveSceneBake(const SceneDescription& scene, const string& path, uint64_t sourceStamp);
+unsigned int BakeShape(SceneBake& bake, const GLMesh& mesh, std::map<ShapeKey, unsigned int>& cachedShapes);
+void CreateBakedMesh(GLMesh& mesh, const SceneBake& bake, const BakedShape& shape, glm::vec3 origin);
+void SetSceneLight(int light, glm::vec3 position, glm::vec3 color, GLfloat intensity);
+void CreateLightEntities();
+LightComponent& SceneLight(int light);
 void PlaceObjects();
+void MoveLightMeshes(const FramePacket& frame);
 void LoadTexture(GLuint& texture, string filename, GLuint textureNum);
 void DestroyTextures();
-void CreateEndTable(vector<GLMesh>& meshArray);
-void CreateVAOS(GLMesh& mesh);
-void CreateCoffeeTable(vector<GLMesh>& meshArray);
-void CreateCouch(vector<GLMesh>& meshArray);
-void CreateLamp(vector<GLMesh>& meshArray);
-
-/* Objects Vertex Shader Source Code*/
-const GLchar* objectVertexShaderSource = GLSL(440,
-
-layout(location = 0) in vec3 position;      // VAP position 0 for vertex position data
-layout(location = 1) in vec3 normal;        // VAP position 1 for normals
-layout(location = 2) in vec2 textureCoordinate;
-
-out vec3 vertexNormal;                      // For outgoing normals to fragment shader
-out vec3 vertexFragmentPos;                 // For outgoing color / pixels to fragment shader
-out vec2 vertexTextureCoordinate;
-
-//Uniform / Global variables for the  transform matrices
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    gl_Position = projection * view * model * vec4(position, 1.0f);     // Transforms vertices into clip coordinates
-
-    vertexFragmentPos = vec3(model * vec4(position, 1.0f));             // Gets fragment / pixel position in world space only (exclude view and projection)
-
-    vertexNormal = mat3(transpose(inverse(model))) * normal;            // get normal vectors in world space only and exclude normal translation properties
-    vertexTextureCoordinate = textureCoordinate;
-}
-);
-
-
-/* Objects Fragment Shader Source Code*/
-const GLchar* objectFragmentShaderSource = GLSL(440,
-in vec3 vertexNormal;               // For incoming normals
-in vec3 vertexFragmentPos;          // For incoming fragment position
-in vec2 vertexTextureCoordinate;
-
-
-out vec4 fragmentColor;             // For outgoing cube color to the GPU
-
-// Uniform / Global variables for object color, light color, light position, and camera/view position
-uniform vec3 objectColor;
-uniform vec3 lightColor;
-uniform vec3 light2Color;
-uniform vec3 lightPos;
-uniform vec3 light2Pos;
-uniform vec3 viewPosition;
-uniform sampler2D uTexture;         // Useful when working with multiple textures
-uniform vec2 uvScale;
-uniform float specularIntensity1;   // Intensity of the key light
-uniform float specularIntensity2;   // Intensity of the fill light
-
-void main()
-{
-    /*Phong lighting model calculations to generate ambient, diffuse, and specular components
-     *Calculate for light 1
-     *Calculate Ambient lighting*/
-    float ambientStrength = 0.3f; // Set ambient or global lighting strength
-    vec3 ambient = ambientStrength * lightColor; // Generate ambient light color
-
-    //Calculate Diffuse lighting*/
-    vec3 norm = normalize(vertexNormal);                            // Normalize vectors to 1 unit
-    vec3 lightDirection = normalize(lightPos - vertexFragmentPos);  // Calculate distance (light direction) between light source and fragments/pixels on cube
-    float impact = max(dot(norm, lightDirection), 0.0);             // Calculate diffuse impact by generating dot product of normal and light
-    vec3 diffuse = impact * lightColor;                             // Generate diffuse light color
-
-    //Calculate Specular lighting*/
-    float highlightSize = 16.0f;                                // Set specular highlight size
-    vec3 viewDir = normalize(viewPosition - vertexFragmentPos); // Calculate view direction
-    vec3 reflectDir = reflect(-lightDirection, norm);           // Calculate reflection vector
-    //Calculate specular component
-    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), highlightSize);
-    vec3 specular = specularIntensity1 * specularComponent * lightColor;
-
-    /*Calculate for light 2
-     *Calculate Ambient lighting*/
-    float ambientStrength2 = 0.1f;                              // Set ambient or global lighting strength
-    vec3 ambient2 = ambientStrength2 * light2Color;             // Generate ambient light color
-
-    /*Calculate Diffuse lighting*/
-    vec3 light2Direction = normalize(light2Pos - vertexFragmentPos);    // Calculate distance (light direction) between light source and fragments/pixels on cube
-    float impact2 = max(dot(norm, light2Direction), 0.0);               // Calculate diffuse impact by generating dot product of normal and light
-    vec3 diffuse2 = impact2 * light2Color;                              // Generate diffuse light color
-
-    /*Calculate Specular lighting*/
-    float highlightSize2 = 16.0f;                           // Set specular highlight size
-    vec3 reflectDir2 = reflect(-light2Direction, norm);     // Calculate reflection vector
-    //Calculate specular component
-    float specularComponent2 = pow(max(dot(viewDir, reflectDir2), 0.0), highlightSize2);
-    vec3 specular2 = specularIntensity2 * specularComponent2 * light2Color;
-
-    // Texture holds the color to be used for all three components
-    vec4 textureColor = texture(uTexture, vertexTextureCoordinate * uvScale);
-
-    // Combine the results from both lights into one vec3
-    vec3 fillResult = (ambient + diffuse + specular);
-    vec3 keyResult = (ambient2 + diffuse2 + specular2);
-    vec3 lightingResult = fillResult + keyResult;
-
-    // Calculate phong result
-    vec3 phong = (lightingResult)*textureColor.xyz;
-
-    fragmentColor = vec4(phong, 1.0); // Send lighting results to GPU
-}
-);
-
-/* Lamp Shader Source Code*/
-const GLchar* lightVertexShaderSource = GLSL(440,
-layout(location = 0) in vec3 position;      // Vertex data from Vertex Attrib Pointer 0
-layout(location = 1) in vec3 normals;       // Color data from Vertex Attrib Pointer 1
-layout(location = 2) in vec2 aTexCoord;     // Texture coordinates
-
-//Uniform / Global variables for the  transform matrices
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    gl_Position = projection * view * model * vec4(position, 1.0f); // Transforms vertices into clip coordinates
-}
-);
-
-
-/* Fragment Shader Source Code*/
-const GLchar* lightFragmentShaderSource = GLSL(440,
-out vec4 fragmentColor;         // For outgoing lamp color (smaller cube) to the GPU
-uniform vec4 color;
-
-void main()
-{
-    fragmentColor = color;      // Set color to white (1.0f,1.0f,1.0f) with alpha 1.0
-}
-);
+void SetLocalBounds(GLMesh& mesh);
+void UploadVAOS(GLMesh& mesh);
+bool ScenePartShape(const ScenePart& part, ShapeKey& key);
+void GenerateScenePart(GLMesh& mesh, const ScenePart& part);
+void CreateScenePart(GLMesh& mesh, const ScenePart& part);
+unsigned int ScenePartMaterial(const ScenePart& part);
+void UseBatchedBuffers(GLMesh& mesh, const GeometryBatch& batch, unsigned int entry);
+void UpdateBounds(BoundsComponent& bounds, const glm::mat4& model);
+void RegisterSceneObjects();
+void AddSceneEntity(Entity entity, GLMesh& mesh, const string& name, unsigned int part, int node);
+void CullSceneObjects(const FramePacket& frame);
+void BuildDrawList();
+bool RayHitsMesh(const GLMesh& mesh, const glm::mat4& model, const glm::vec3& origin, const glm::vec3& direction, float& distance);
+void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+void DrawShadowCasters(GLint modelLoc);
+void DrawMesh(GLuint vao, GLuint indexCount, GLintptr indexOffset, const glm::mat4& model, GLint modelLoc);
+void DrawSceneObjects();
+void DrawLights(const FramePacket& frame);
+void UseCachedShape(GLMesh& mesh, const ShapeKey& key, glm::vec3 origin);
+void UseSharedShape(GLMesh& mesh, const ShapeKey& key, const SharedShape& shape, glm::vec3 origin);
+int FindInstanceGroup(const ShapeKey& key, GLuint texture, unsigned int material);
+void DrawInstanceGroups();
+void DestroyInstanceGroups();
+GLint UseObjectProgram(GLuint program);
+void PrepareObjectShaders();
+bool LoadShaderFiles();
+string ShaderSource(const string& file);
+bool SetObjectShaderSources();
+void ReloadChangedShaders();
+GLuint ObjectShader(unsigned int key);
+void ReportFrameStats();
+void ReportAllocations();
+void PublishFrame();
+void RenderLoop();
+void PublishRenderReport(const FramePacket& frame);
+void NoteActivity();
+bool Idle();
+void MarkDirty();
+void WindowRefreshCallback(GLFWwindow* window);
+void StartLightmapBake();
+void UploadLightmap();
+bool BakedLightingActive(const FramePacket& frame);
+
+// Specialized versions of the object shaders, one per combination of material features in use
+ShaderVariants gObjectShaders("440 core", BeginShaderProgram, FinishShaderProgram, DestroyShaderProgram);
 
 // Begining of program execution
 int main(int argc, char* argv[])
 {
+    // Heap allocations until the simulation loop starts are counted as startup
+    AllocationTracker::SetTag(ALLOC_STARTUP);
+
     // Set up OpenGL window
     if (!Setup(argc, argv, &gWindow))
         return EXIT_FAILURE;
 
-    // Create shader program
-    if (!CreateShaderProgram(objectVertexShaderSource, objectFragmentShaderSource, gProgram1))
+    // Check the shader programs Setup started, including the object shader variants of every material in the scene
+    if (!FinishShaderProgram(gProgram2)) {
         return EXIT_FAILURE;
-    if (!CreateShaderProgram(lightVertexShaderSource, lightFragmentShaderSource, gProgram2)) {
+    }
+    if (!FinishShaderProgram(gShadowProgram)) {
+        return EXIT_FAILURE;
+    }
+    if (!FinishShaderProgram(gLightmapProgram)) {
+        return EXIT_FAILURE;
+    }
+    if (!FinishShaderProgram(gHudProgram)) {
+        return EXIT_FAILURE;
+    }
+    if (!gObjectShaders.FinishAll()) {
         return EXIT_FAILURE;
     }
+    cout << "Shader programs: " << gProgramCache.Hits() << " loaded from cache, " << gProgramCache.Misses() << " compiled." << endl;
+    cout << "Primitive shapes: " << gGeometryCache.Builds() << " built, " << gGeometryCache.Requests() - gGeometryCache.Shapes() << " reused." << endl;
     // Set background color to dark blue
     glClearColor(0.084f, 0.110f, 0.210f, 1.0f);
 
-    // Display loop
+    // Hand the GL context to the render thread. This thread keeps input, the camera, and scene changes
+    glfwMakeContextCurrent(NULL);
+    gRenderRunning = true;
+    gRenderThread = std::thread(RenderLoop);
+
+    // Simulation loop
+    AllocationTracker::SetTag(ALLOC_SIMULATION);
     while (!glfwWindowShouldClose(gWindow)) {
 
-        // Handle input
-        ProcessInput(gWindow);
+        // Time keeping, averaged over the last few frames so the camera moves evenly
+        deltaTime = gFramePacer.Tick();
+
+        // Handle input. Reading the keys every frame must not allocate
+        {
+            ZeroAllocationScope inputAllocations(ALLOC_INPUT);
+            ProcessInput(gWindow);
+        }
+
+        // A finished bake changes the picture even though nothing else did
+        if (gLightmapPending && gLightmapBaker.Finished()) {
+            MarkDirty();
+        }
+
+        // Show what the render thread reported
+        ReportFrameStats();
+
+        // Nothing has changed since the last frame, so sleep until there is input or it is time to check again
+        if (renderOnDemand && redrawFrames == 0) {
+            glfwWaitEventsTimeout(WAIT_TIMEOUT);
+            gFramePacer.Restart();
+            continue;
+        }
+
+        // Hand this frame to the render thread, which draws it while the next one is simulated
+        PublishFrame();
+        if (redrawFrames > 0) {
+            redrawFrames--;
+        }
 
-        // Render current frame
-        Display();
+        // Hold the frame rate to the limit, or to the idle rate when nobody has touched the controls for a while
+        gFramePacer.SetTargetFps(Idle() ? IDLE_FRAME_RATE : frameRateLimit);
+        gFramePacer.Wait();
 
         // Check for new events
         glfwPollEvents();
     }
 
+    // Let the render thread finish its frame and take the GL context back
+    gRenderRunning = false;
+    gRenderWake.Notify();
+    gRenderThread.join();
+    glfwMakeContextCurrent(gWindow);
+    AllocationTracker::SetTag(ALLOC_OTHER);
+    ReportAllocations();
+
     // Free mesh memory
-    DestroyMesh(gSoccerBall);
-    DestroyMesh(gFloor);
-    DestroyMesh(gWallTop);
-    DestroyMesh(gWallBottom);
     DestroyMesh(gLight1);
     DestroyMesh(gLight2);
-
-    for (unsigned int i = 0; i < gCoffeeTable.size(); i++) {
-        DestroyMesh(gCoffeeTable.at(i));
-    }
-    for (unsigned int i = 0; i < gTrim.size(); i++) {
-        DestroyMesh(gTrim.at(i));;
-    }
-    for (unsigned int i = 0; i < gEndTable.size(); i++) {
-        DestroyMesh(gEndTable.at(i));;
-    }
-    for (unsigned int i = 0; i < gLamp.size(); i++) {
-        DestroyMesh(gLamp.at(i));;
-    }
-    for (unsigned int i = 0; i < gCouch.size(); i++) {
-        DestroyMesh(gCouch.at(i));;
+    for (unsigned int i = 0; i < gSceneModels.size(); i++) {
+        for (unsigned int j = 0; j < gSceneModels.at(i).parts.size(); j++) {
+            DestroyMesh(gSceneModels.at(i).parts.at(j));
+        }
     }
+    DestroyInstanceGroups();
+    gGeometryCache.Destroy();
+    gSceneBatch.Destroy();
+    DestroyTextures();
+
+
+    // Stop the lightmap bake, which runs on the job threads, then the frame preparation threads
+    gLightmapBaker.Stop();
+    gJobSystem.Stop();
+
+    // Free the occlusion culling readback buffers
+    gOcclusionCuller.Destroy();
+
+    // Free the shadow maps
+    gShadowMaps.Destroy();
 
+    // Free the per-frame streaming buffer
+    gFrameRing.Destroy();
+
+    // Free the profiler's queries and overlay, closing the dump file
+    gProfiler.Destroy();
+    gProfilerOverlay.Destroy();
+
+    // Free the lightmap
+    glDeleteTextures(1, &gLightmapTexture);
 
     // Free shader program memmory
+    DestroyShaderProgram(gHudProgram);
+    DestroyShaderProgram(gLightmapProgram);
+    DestroyShaderProgram(gShadowProgram);
     DestroyShaderProgram(gProgram2);
-    DestroyShaderProgram(gProgram1);
+    gObjectShaders.Destroy();
 
     // Exit program with success flag
     exit(EXIT_SUCCESS);
 
 }
 
-bool Setup(int, char* [], GLFWwindow** window) {
+bool Setup(int argc, char* argv[], GLFWwindow** window) {
+
+    // Frame pacing options: --vsync <vertical blanks per swap> and --fps <frame rate limit>. --scene <file> picks the room
+    // and --threads <count> sets how many threads prepare each frame. --profile-dump <file> writes the time of every pass of every frame
+    for (int i = 1; i + 1 < argc; i++) {
+        if (string(argv[i]) == "--vsync") {
+            swapInterval = atoi(argv[++i]);
+        }
+        else if (string(argv[i]) == "--fps") {
+            frameRateLimit = atof(argv[++i]);
+        }
+        else if (string(argv[i]) == "--scene") {
+            sceneFileName = argv[++i];
+        }
+        else if (string(argv[i]) == "--threads") {
+            jobThreads = atoi(argv[++i]);
+        }
+        else if (string(argv[i]) == "--profile-dump") {
+            profileDumpFile = argv[++i];
+        }
+    }
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--continuous") {
+            renderOnDemand = false;
+        }
+    }
 
     // Create and initialize GLFW window
     glfwInit();
@@ -393,11 +665,14 @@ bool Setup(int, char* [], GLFWwindow** window) {
 
     // Initialize GLEW
     glfwMakeContextCurrent(*window);
+    glfwSwapInterval(swapInterval);
     glfwSetFramebufferSizeCallback(*window, ChangeSize);
     glfwSetInputMode(*window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glfwSetScrollCallback(*window, MouseScrollCallback);
     glfwSetCursorPosCallback(*window, MousePositionCallback);
     glfwSetKeyCallback(*window, KeyCallBack);
+    glfwSetMouseButtonCallback(*window, MouseButtonCallback);
+    glfwSetWindowRefreshCallback(*window, WindowRefreshCallback);
     glfwSetInputMode(*window, GLFW_STICKY_KEYS, GLFW_TRUE);
 
     GLenum glewInitResult = glewInit();
@@ -411,41 +686,89 @@ bool Setup(int, char* [], GLFWwindow** window) {
     // Output OpenGL version to console
     cout << "OpenGL Version: " << glGetString(GL_VERSION) << endl;
 
+    // Let the driver compile on as many threads as it likes and start every shader now,
+    // so compiling overlaps with decoding textures and building meshes
+    if (GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    if (!LoadShaderFiles())
+        return false;
+    for (unsigned int i = 0; i < sizeof(gShaderFilePrograms) / sizeof(gShaderFilePrograms[0]); i++) {
+        const ShaderFileProgram& files = gShaderFilePrograms[i];
+        BeginShaderProgram(ShaderSource(files.vertexFile).c_str(), ShaderSource(files.fragmentFile).c_str(), *files.program);
+    }
+
     // Display controls
     cout << endl << "Controls:" << endl << "W moves the camera forward." << endl << "S moves the camera backwards." << endl << "A moves the camera left." << endl << "D moves the camera right." << endl
         << "Q moves the camera up." << endl << "E moves the camera down." << endl  << endl << "Scrolling the mouse wheel up will increase the speed of" << endl 
         <<"\tcamera turning with the mouse and movement with the keyboard." << endl  << endl << "Scrolling the mouse wheel down will decrease the speed of " << endl 
         << "\tcamera turning with the mouse and movement with the keyboard." << endl << endl << "This scene has smart home features. You can also use the following controls:"
-        << endl << "F1 toggles the lamp between its normal color and orange." << endl << "F2 toggles the fluorescent light between its normal color and green." << endl << endl
-        << "The program starts in perspective mode. P can be used to toggle between this and orthographic mode." << endl << endl;
+        << endl << "F1 toggles the lamp between its normal color and orange." << endl << "F2 toggles the fluorescent light between its normal color and green." << endl
+        << "The arrow keys move the lamp's light along the floor, and Page Up and Page Down move it up and down." << endl << endl
+        << "The program starts in perspective mode. P can be used to toggle between this and orthographic mode." << endl << endl
+        << "C toggles view frustum culling. Drawn and culled object counts are shown in the title bar." << endl
+        << "O toggles occlusion culling of objects hidden behind other objects." << endl
+        << "L toggles between baked lighting and fully dynamic lighting once the lightmap has finished baking." << endl
+        << "R toggles between drawing only when something changes and drawing continuously. Start with --continuous for the latter." << endl
+        << "V toggles vsync. Start with --vsync 0 to begin with it off and --fps <rate> to cap the frame rate." << endl
+        << "H toggles the CPU and GPU time of each pass. Start with --profile-dump <file> to write them for every frame." << endl
+        << "The frame rate drops to " << IDLE_FRAME_RATE << " FPS after " << IDLE_DELAY << " seconds without input to save power." << endl
+        << "Shaders are read from the shaders folder and reload automatically when a file is saved." << endl
+        << "The room is read from " << sceneFileName << ". Start with --scene <file> to load a different one." << endl
+        << "Clicking the left mouse button names the object in the center of the view." << endl << endl;
+
+    // Start the threads that share culling and draw list building with this one
+    gJobSystem.Start(jobThreads);
+    cout << "Preparing frames on " << gJobSystem.ThreadCount() << " threads. Start with --threads <count> to change this." << endl;
+
+    // Read the scene file, load its textures, and build its objects
+    if (!LoadScene(sceneFileName))
+        return false;
 
-    // Load textures
-    LoadTexture(gFloor.texture, "Carpet.jpg", 0);
-    LoadTexture(gWallBottom.texture, "Wall_Bottom.jpg", 1);
-    LoadTexture(gWallTop.texture, "Wall_Top.jpg", 2);
-    LoadTexture(gEndTableSurfacesTexture, "pxfuel.com.jpg", 3);
-    LoadTexture(gEndTableCylindersTexture, "pxfuel.com_1.jpg", 4);
-    LoadTexture(gCoffeeTableTopTexture, "wood-texture-plank-floor-wall-furniture-601095-pxhere.com.jpg", 5);
-    LoadTexture(gCoffeeTableUnder, "90DegreeRotated-wood-texture-plank-floor-wall-furniture-601095-pxhere.com.jpg", 6);
-    LoadTexture(gTrimTexture, "white-texture-paint-wallpaper-surface-blank-1371058-pxhere.com.jpg", 7);
-    LoadTexture(gSoccerBall.texture, "soccer3_sph.png", 8);
-    LoadTexture(gCouchCushionTexture, "PIXNIO-1952794-4076x3057.jpg", 9);
-    LoadTexture(gCouchTexture, "2048px-Chenille_Fabric1.jpg", 10);
-    LoadTexture(gLampTexture, "background-floor-gray-metal-metallic-smooth-1431205-pxhere.com.jpg", 11);
-    LoadTexture(gLampShadeTexture, "structure-white-texture-floor-pattern-line-769994-pxhere.com.jpg", 12);
-
-    // Build and place the objects in the scene
-    BuildObjects();
+    // Materials are known now, so start the object shader variants while the rest of the scene is set up
+    PrepareObjectShaders();
     PlaceObjects();
+
+    // Start baking the static lighting in the background
+    StartLightmapBake();
+
+    // Create the depth readback buffers for occlusion culling, the shadow maps, and the per-frame streaming buffer
+    gOcclusionCuller.Create();
+    gShadowMaps.Create();
+    if (!gFrameRing.Create(FRAME_RING_SIZE)) {
+        cout << "Persistently mapped buffers are not available, so per-frame data is uploaded with glBufferSubData." << endl;
+    }
+    gFrameUniforms.Create();
+
+    // Create the profiler's queries and overlay and name what it times
+    gProfiler.Create();
+    gProfiler.SetSection(PROFILE_FRAME, "Frame", false);
+    gProfiler.SetSection(PROFILE_SHADOWS, "Shadows", true);
+    gProfiler.SetSection(PROFILE_CULLING, "Culling", false);
+    gProfiler.SetSection(PROFILE_DRAW_LIST, "Draw list", false);
+    gProfiler.SetSection(PROFILE_OBJECTS, "Objects", true);
+    gProfiler.SetSection(PROFILE_INSTANCES, "Instances", true);
+    gProfiler.SetSection(PROFILE_LIGHTS, "Lights", true);
+    gProfiler.SetSection(PROFILE_OVERLAY, "Overlay", true);
+    gProfiler.SetSection(PROFILE_READBACK, "Readback", true);
+    gProfiler.SetSection(PROFILE_SWAP, "Swap", false);
+    gProfilerOverlay.Create();
+    if (!profileDumpFile.empty()) {
+        if (gProfiler.OpenDump(profileDumpFile.c_str()))
+            cout << "Writing the time of every pass to " << profileDumpFile << "." << endl;
+        else
+            cout << "Could not open " << profileDumpFile << " for the pass times." << endl;
+    }
     return true;
 }
 
-// Display the meshes in the window
-void Display() {
-    // Time keeping
-    float currentFrame = (float)glfwGetTime();
-    deltaTime = currentFrame - lastFrame;
-    lastFrame = currentFrame;
+// Display the meshes in the window as they were in a frame packet. Runs on the render thread
+void Display(const FramePacket& frame) {
+    // Read the pass times of an earlier frame that are ready and start timing this one
+    gProfiler.BeginFrame();
+    gProfiler.Begin(PROFILE_FRAME);
+
+    // Claim this frame's region of the streaming buffer, waiting only if the GPU is a whole ring behind
+    gFrameRing.BeginFrame();
 
     // Enable z-depth to determine which fragments to show
     glEnable(GL_DEPTH_TEST);
@@ -455,338 +778,1123 @@ void Display() {
     glClearColor(0.084f, 0.110f, 0.210f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Set the shader
-    glUseProgram(gProgram1);
+    // Follow the lights with their meshes before anything is culled or drawn
+    MoveLightMeshes(frame);
 
-    // Get the camera position
-    glm::mat4 view = camera.GetViewMatrix();
+    // Render the shadow maps only when a light or object has moved since they were cached
+    const LightComponent& keyLight = frame.lights[SceneDescription::KEY_LIGHT];
+    const LightComponent& fillLight = frame.lights[SceneDescription::FILL_LIGHT];
+    if (gShadowMaps.NeedsUpdate(keyLight.position, fillLight.position, gSceneVersion)) {
+        ProfileScope shadowTime(gProfiler, PROFILE_SHADOWS);
+        gShadowMaps.Render(gShadowProgram, keyLight.position, fillLight.position, fillLight.target, gSceneVersion, DrawShadowCasters);
+    }
 
-    // If the perspective type is set to projection
-    glm::mat4 projection;
-    if (perspective) {
-        projection = glm::perspective(glm::radians(camera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+    // Upload the lightmap once the background bake is done
+    if (gLightmapPending && gLightmapBaker.Finished()) {
+        UploadLightmap();
     }
-    // If the projection type is set to ortho
-    else {
-        projection = glm::ortho((float)(camera.Zoom / orthoMinMultiplier), (float)(camera.Zoom / orthoMaxMultiplier), (float)(camera.Zoom / orthoMinMultiplier), (float)(camera.Zoom / orthoMaxMultiplier), (float)(orthoMinMultiplier * 3.0f), (float)(orthoMaxMultiplier * 3.0f));
-    }
-
-    // Retrieves and passes transform matrices and uniforms to the Shader program
-    GLint modelLoc = glGetUniformLocation(gProgram1, "model");
-    GLint viewLoc = glGetUniformLocation(gProgram1, "view");
-    GLint projLoc = glGetUniformLocation(gProgram1, "projection");
-    GLint objectColorLoc = glGetUniformLocation(gProgram1, "objectColor");
-    GLint lightColorLoc = glGetUniformLocation(gProgram1, "lightColor");
-    GLint lightPositionLoc = glGetUniformLocation(gProgram1, "lightPos");
-    GLint viewPositionLoc = glGetUniformLocation(gProgram1, "viewPosition");
-    GLint specularIntensity1Loc = glGetUniformLocation(gProgram1, "specularIntensity1");
-    GLint light2ColorLoc = glGetUniformLocation(gProgram1, "light2Color");
-    GLint light2PositionLoc = glGetUniformLocation(gProgram1, "light2Pos");
-    GLint specularIntensity2Loc = glGetUniformLocation(gProgram1, "specularIntensity2");
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gEndTable.at(0).model));
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform3f(objectColorLoc, gObjectColor.r, gObjectColor.g, gObjectColor.b);
-    glUniform3f(lightColorLoc, gLight1Color.r, gLight1Color.g, gLight1Color.b);
-    glUniform3f(lightPositionLoc, gLight1Position.x, gLight1Position.y, gLight1Position.z);
-    glUniform1f(specularIntensity1Loc, gLight1Intensity);
-    glUniform3f(light2ColorLoc, gLight2Color.r, gLight2Color.g, gLight2Color.b);
-    glUniform3f(light2PositionLoc, gLight2Position.x, gLight2Position.y, gLight2Position.z);
-    glUniform1f(specularIntensity2Loc, gLight2Intensity);
-
-    // Send camera position to the shader
-    const glm::vec3 cameraPosition = camera.Position;
-    glUniform3f(viewPositionLoc, cameraPosition.x, cameraPosition.y, cameraPosition.z);
-
-    // Send texture coordinate scaling to shader
-    GLint UVScaleLoc = glGetUniformLocation(gProgram1, "uvScale");
-    glUniform2fv(UVScaleLoc, 1, glm::value_ptr(gUVScale));
+
+    // Baked lighting replaces the Phong shader for static meshes while the lightmap matches the scene
+    gDrawLightmapped = BakedLightingActive(frame);
+
+    // The camera was set up when the frame was simulated
+    const glm::mat4& view = frame.view;
+    const glm::mat4& projection = frame.projection;
+
+    // Extract the view frustum for culling, give back last frame's arrays, and reset the frame counters
+    gFrustum.Update(projection * view);
+    gFrameArena.Reset();
+    frameStats = FrameStats();
+    {
+        ProfileScope cullingTime(gProfiler, PROFILE_CULLING);
+        CullSceneObjects(frame);
+    }
+
+    // Sort what is left so draws sharing a program and texture are submitted together
+    {
+        ProfileScope drawListTime(gProfiler, PROFILE_DRAW_LIST);
+        BuildDrawList();
+    }
+
+    // Send the camera and lights once for every program that reads the FrameData block
+    FrameUniformData frameData;
+    frameData.view = view;
+    frameData.projection = projection;
+    frameData.light2ViewProjection = gShadowMaps.SpotViewProjection();
+    frameData.viewPosition = frame.viewPosition;
+    frameData.specularIntensity1 = keyLight.intensity;
+    frameData.lightPos = keyLight.position;
+    frameData.specularIntensity2 = fillLight.intensity;
+    frameData.lightColor = keyLight.color;
+    frameData.lightFarPlane = gShadowMaps.CubeFarPlane();
+    frameData.light2Pos = fillLight.position;
+    frameData.light2Color = fillLight.color;
+    frameData.objectColor = gObjectColor;
+    frameData.uvScale = gUVScale;
+    // Without this frame's copy the programs would read the range bound last, which the GPU may still be using, so the scene is not drawn
+    bool frameDataBound = gFrameUniforms.Update(gFrameRing, frameData);
+
+    // Object programs get their texture units the first time each one is used this frame
+    gPreparedPrograms.clear();
+    gObjectProgram = 0;
+
+    // Bind the cached shadow maps
+    glActiveTexture(GL_TEXTURE0 + SHADOW_CUBE_UNIT);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, gShadowMaps.CubeTexture());
+    glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D, gShadowMaps.SpotTexture());
+
+    // Bind the baked lightmap
+    glActiveTexture(GL_TEXTURE0 + LIGHTMAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D, gLightmapTexture);
 
     // Activate texture
     glActiveTexture(GL_TEXTURE0);
-    
-    // Draw end table
-    for (unsigned int i = 0; i < gEndTable.size(); i++) {
-        glBindTexture(GL_TEXTURE_2D, gEndTable.at(i).texture);
-        glBindVertexArray(gEndTable.at(i).vao);
-        glDrawElements(GL_TRIANGLES, gEndTable.at(i).nIndices, GL_UNSIGNED_SHORT, NULL);
-    }
-        
-    // Bind texture
-    glBindTexture(GL_TEXTURE_2D, gSoccerBall.texture);
-    // Draw soccer ball
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gSoccerBall.model));
-    // Activate the VBOs in mesh's VAO
-    glBindVertexArray(gSoccerBall.vao);
-    // Tell openGL to draw
-    glDrawElements(GL_TRIANGLES, gSoccerBall.nIndices, GL_UNSIGNED_SHORT, NULL);
-
-    // Draw floor
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gFloor.model));
-    glBindTexture(GL_TEXTURE_2D, gFloor.texture);
-    glBindVertexArray(gFloor.vao);
-    glDrawElements(GL_TRIANGLES, gFloor.nIndices, GL_UNSIGNED_SHORT, NULL);
-
-    // Draw bottom half of wall
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gWallBottom.model));
-    glBindTexture(GL_TEXTURE_2D, gWallBottom.texture);
-    glBindVertexArray(gWallBottom.vao);
-    glDrawElements(GL_TRIANGLES, gWallBottom.nIndices, GL_UNSIGNED_SHORT, NULL);
-
-    // Draw top half of wall
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gWallTop.model));
-    glBindTexture(GL_TEXTURE_2D, gWallTop.texture);
-    glBindVertexArray(gWallTop.vao);
-    glDrawElements(GL_TRIANGLES, gWallTop.nIndices, GL_UNSIGNED_SHORT, NULL);
-
-    // Draw wall trim
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gTrim.at(0).model));
-    for (unsigned int i = 0; i < gTrim.size(); i++) {
-        glBindTexture(GL_TEXTURE_2D, gTrim.at(i).texture);
-        glBindVertexArray(gTrim.at(i).vao);
-        // Draws the object
-        glDrawElements(GL_TRIANGLES, gTrim.at(i).nIndices, GL_UNSIGNED_SHORT, NULL);
-    }
-
-    // Draw coffee table
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gCoffeeTable.at(0).model));
-    for (unsigned int i = 0; i < gCoffeeTable.size(); i++) {
-        glBindTexture(GL_TEXTURE_2D, gCoffeeTable.at(i).texture);
-        glBindVertexArray(gCoffeeTable.at(i).vao);
-        // Uncomment next line to show in wireframe mode
-        // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        // Draws the object
-        glDrawElements(GL_TRIANGLES, gCoffeeTable.at(i).nIndices, GL_UNSIGNED_SHORT, NULL);
-    }
-
-    // Draw couch
-    for (unsigned int i = 0; i < gCouch.size(); i++) {
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gCouch.at(i).model));
-        glBindTexture(GL_TEXTURE_2D, gCouch.at(i).texture);
-        glBindVertexArray(gCouch.at(i).vao);
-        // Uncomment next line to show in wireframe mode
-        // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        // Draws the object
-        glDrawElements(GL_TRIANGLES, gCouch.at(i).nIndices, GL_UNSIGNED_SHORT, NULL);
-    }
-
-    // Draw lamp
-    for (unsigned int i = 0; i < gLamp.size(); i++) {
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gLamp.at(i).model));
-        glBindTexture(GL_TEXTURE_2D, gLamp.at(i).texture);
-        glBindVertexArray(gLamp.at(i).vao);
-        // Uncomment next line to show in wireframe mode
-        // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        // Draws the object
-        glDrawElements(GL_TRIANGLES, gLamp.at(i).nIndices, GL_UNSIGNED_SHORT, NULL);
+
+    // Draw the visible objects in draw list order
+    // Uncomment next line to show in wireframe mode
+    // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    if (frameDataBound) {
+        ProfileScope objectsTime(gProfiler, PROFILE_OBJECTS);
+        DrawSceneObjects();
+    }
+
+    // Draw the copies of shared shapes that DrawSceneObjects collected
+    if (frameDataBound) {
+        ProfileScope instancesTime(gProfiler, PROFILE_INSTANCES);
+        DrawInstanceGroups();
+    }
+
+    // Draw light locations
+    if (frameDataBound) {
+        ProfileScope lightsTime(gProfiler, PROFILE_LIGHTS);
+        DrawLights(frame);
+    }
+
+    // Draw the averaged pass times over the scene. Its vertices are streamed, so it comes before the ring's frame ends
+    if (frame.showProfiler) {
+        ProfileScope overlayTime(gProfiler, PROFILE_OVERLAY);
+        gProfilerOverlay.Draw(gProfiler, gHudProgram, gFrameRing, frame.framebufferWidth, frame.framebufferHeight);
+    }
+
+    // Every draw that reads this frame's streamed data has been submitted
+    gFrameRing.EndFrame();
+
+    // Read back this frame's depth to test against in later frames
+    if (frame.occlusionCulling) {
+        ProfileScope readbackTime(gProfiler, PROFILE_READBACK);
+        gOcclusionCuller.CaptureDepth(projection * view, frame.framebufferWidth, frame.framebufferHeight);
+    }
+    gProfiler.End(PROFILE_FRAME);
+
+    // Swap frame buffers
+    {
+        ProfileScope swapTime(gProfiler, PROFILE_SWAP);
+        glfwSwapBuffers(gWindow);
+    }
+    gProfiler.EndFrame();
+
+    // Tell the simulation thread the drawn, culled, and occluded counts
+    PublishRenderReport(frame);
+
+}
+
+// Read a scene and build its objects, timing each step. A bake of the scene file is used when it is up to date
+bool LoadScene(const string& path) {
+    double start = glfwGetTime();
+    string bakePath = path + ".bake";
+    uint64_t sourceStamp = SceneBake::SourceStamp(path);
+
+    // The bake already holds every vertex and matrix, so only the textures and buffer uploads are left
+    SceneBake bake;
+    if (sourceStamp && bake.Open(bakePath, sourceStamp)) {
+        double mapped = glfwGetTime();
+        for (unsigned int i = 0; i < bake.TextureCount(); i++) {
+            GLuint texture;
+            LoadTexture(texture, bake.TextureFile(i), 0);
+            gSceneTextures.push_back(texture);
+        }
+        double texturesLoaded = glfwGetTime();
+        BuildBakedObjects(bake);
+        double built = glfwGetTime();
+        cout << "Scene " << bakePath << ": " << bake.ObjectCount() << " objects, " << bake.PartCount() << " parts, "
+            << bake.TextureCount() << " textures. Mapped in " << (mapped - start) * 1000.0 << " ms, textures loaded in "
+            << (texturesLoaded - mapped) * 1000.0 << " ms, meshes uploaded in " << (built - texturesLoaded) * 1000.0 << " ms." << endl;
+        bake.Close();
+        return true;
+    }
+
+    SceneDescription scene;
+    SceneFile file;
+    if (!file.Load(path, scene)) {
+        cerr << "Failed to load scene " << file.Error() << endl;
+        return false;
+    }
+    double parsed = glfwGetTime();
+
+    // Load textures
+    for (unsigned int i = 0; i < scene.textures.size(); i++) {
+        GLuint texture;
+        LoadTexture(texture, scene.textures.at(i).file, 0);
+        gSceneTextures.push_back(texture);
+    }
+    double texturesLoaded = glfwGetTime();
+
+    // Build and place the objects in the scene. The shape generators take their temporary arrays from each thread's scratch arena
+    BuildObjects(scene);
+    double built = glfwGetTime();
+
+    cout << "Scene " << path << ": " << scene.objects.size() << " objects, " << scene.PartCount() << " parts, "
+        << scene.textures.size() << " textures. Parsed in " << (parsed - start) * 1000.0 << " ms, textures loaded in "
+        << (texturesLoaded - parsed) * 1000.0 << " ms, meshes built in " << (built - texturesLoaded) * 1000.0 << " ms." << endl;
+
+    // Later runs load the bake instead until the scene file changes
+    if (!SaveSceneBake(scene, bakePath, sourceStamp)) {
+        cout << "Could not write the scene bake " << bakePath << endl;
+    }
+    return true;
+}
+
+// Build the meshes of every object and light in a scene file
+void BuildObjects(const SceneDescription& scene) {
+    // Copies of a shape with the same texture and material are drawn with one instanced call, so count them first
+    // Shared shapes are collected as well, so they can all be built in one batch
+    typedef std::pair<ShapeKey, std::pair<int, unsigned int> > InstanceKey;
+    std::map<InstanceKey, unsigned int> copies;
+    vector<ShapeKey> shapeKeys;
+    for (unsigned int i = 0; i < scene.objects.size(); i++) {
+        const vector<ScenePart>& parts = scene.objects.at(i).parts;
+        for (unsigned int j = 0; j < parts.size(); j++) {
+            ShapeKey key;
+            if (ScenePartShape(parts.at(j), key)) {
+                copies[InstanceKey(key, std::make_pair(parts.at(j).texture, ScenePartMaterial(parts.at(j))))]++;
+                shapeKeys.push_back(key);
+            }
+        }
+    }
+
+    // Every mesh is allocated before any job runs, so the jobs only fill in meshes that already exist
+    CreateLightEntities();
+    gSceneModels.resize(scene.objects.size());
+    vector<std::pair<GLMesh*, const ScenePart*> > meshParts;
+    for (unsigned int i = 0; i < scene.objects.size(); i++) {
+        const SceneObjectDescription& object = scene.objects.at(i);
+        SceneModel& model = gSceneModels.at(i);
+        model.name = object.name;
+        model.transform = object.transform.Matrix();
+        model.parts.resize(object.parts.size());
+        for (unsigned int j = 0; j < object.parts.size(); j++) {
+            meshParts.push_back(std::make_pair(&model.parts.at(j), &object.parts.at(j)));
+        }
+    }
+
+    unsigned int objectParts = meshParts.size();
+
+    // The light positions are the translations of their meshes, which are placed with only their rotation and scale
+    GLMesh* lightMeshes[2] = { &gLight1, &gLight2 };
+    ScenePart lightShapes[2];
+    for (int i = 0; i < 2; i++) {
+        const SceneLightDescription& light = scene.lights[i];
+        if (!light.defined) {
+            continue;
+        }
+        lightShapes[i] = light.shape;
+        SetSceneLight(i, lightShapes[i].transform.translation, light.color, light.intensity);
+        lightShapes[i].transform.translation = glm::vec3(0.0f);
+        meshParts.push_back(std::make_pair(lightMeshes[i], &lightShapes[i]));
+        ShapeKey key;
+        if (ScenePartShape(lightShapes[i], key)) {
+            shapeKeys.push_back(key);
+        }
+    }
+
+    // Generate every vertex on the job system, shared shapes and parts with their own buffers alike
+    gGeometryCache.Prebuild(shapeKeys, gJobSystem, gSceneBatch);
+    auto generateParts = [&meshParts](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            GenerateScenePart(*meshParts[i].first, *meshParts[i].second);
+        }
+    };
+    gJobSystem.ParallelFor(meshParts.size(), BUILD_GRAIN, generateParts);
+
+    // Every size is known now, so the parts with their own buffers get their ranges of the batch after the shared shapes
+    vector<int> batchEntries(meshParts.size(), -1);
+    for (unsigned int i = 0; i < meshParts.size(); i++) {
+        ShapeKey key;
+        if (!ScenePartShape(*meshParts[i].second, key)) {
+            batchEntries[i] = gSceneBatch.Add(meshParts[i].first->vertices, meshParts[i].first->indices);
+        }
     }
 
+    // Then copy them into one staging block and upload it as one vertex buffer and one index buffer on this thread, which owns the GL context
+    gSceneBatch.Upload(gJobSystem);
+    gGeometryCache.FinishPrebuild(gSceneBatch);
+    for (unsigned int i = 0; i < meshParts.size(); i++) {
+        GLMesh& mesh = *meshParts[i].first;
+        const ScenePart& part = *meshParts[i].second;
+        if (batchEntries[i] >= 0) {
+            UseBatchedBuffers(mesh, gSceneBatch, batchEntries[i]);
+        }
+        CreateScenePart(mesh, part);
+        // Light meshes are drawn in their light's color, never instanced
+        if (i < objectParts && mesh.cachedShape && copies[InstanceKey(mesh.shapeKey, std::make_pair(part.texture, mesh.material))] > 1) {
+            mesh.instanceGroup = FindInstanceGroup(mesh.shapeKey, mesh.texture, mesh.material);
+        }
+    }
+    if (scene.lights[SceneDescription::FILL_LIGHT].hasTarget) {
+        SceneLight(SceneDescription::FILL_LIGHT).target = scene.lights[SceneDescription::FILL_LIGHT].target;
+    }
+
+    // Make an entity for every mesh, placed by the scene graph
+    RegisterSceneObjects();
+}
+
+// Build the meshes of every object and light in a scene bake
+void BuildBakedObjects(const SceneBake& bake) {
+    CreateLightEntities();
+    gSceneModels.resize(bake.ObjectCount());
+    for (unsigned int i = 0; i < bake.ObjectCount(); i++) {
+        const BakedObject& object = bake.Object(i);
+        SceneModel& model = gSceneModels.at(i);
+        model.name = bake.ObjectName(i);
+        model.transform = glm::make_mat4(object.transform);
+        model.parts.resize(object.partCount);
+        for (unsigned int j = 0; j < object.partCount; j++) {
+            const BakedPart& part = bake.Part(object.firstPart + j);
+            GLMesh& mesh = model.parts.at(j);
+            CreateBakedMesh(mesh, bake, bake.Shape(part.shape), glm::make_vec3(part.origin));
+            mesh.texture = part.texture >= 0 ? gSceneTextures.at(part.texture) : 0;
+            mesh.material = part.material;
+            mesh.castsShadow = (part.flags & BAKED_CASTS_SHADOW) != 0;
+            mesh.placement = glm::make_mat4(part.placement);
+            if ((part.flags & BAKED_INSTANCED) && mesh.cachedShape) {
+                mesh.instanceGroup = FindInstanceGroup(mesh.shapeKey, mesh.texture, mesh.material);
+            }
+        }
+    }
+
+    GLMesh* lightMeshes[2] = { &gLight1, &gLight2 };
+    for (int i = 0; i < 2; i++) {
+        const BakedLight& light = bake.Light(i);
+        if (!light.defined) {
+            continue;
+        }
+        SetSceneLight(i, glm::make_vec3(light.position), glm::make_vec3(light.color), light.intensity);
+        CreateBakedMesh(*lightMeshes[i], bake, bake.Shape(light.shape), glm::vec3(0.0f));
+        lightMeshes[i]->castsShadow = false;
+        lightMeshes[i]->placement = glm::make_mat4(light.placement);
+    }
+    if (bake.Light(SceneDescription::FILL_LIGHT).hasTarget) {
+        SceneLight(SceneDescription::FILL_LIGHT).target = glm::make_vec3(bake.Light(SceneDescription::FILL_LIGHT).target);
+    }
+
+    // Make an entity for every mesh, placed by the scene graph
+    RegisterSceneObjects();
+}
+
+// Create a mesh from a shape in a scene bake. The vertices are uploaded as they are, without being generated
+void CreateBakedMesh(GLMesh& mesh, const SceneBake& bake, const BakedShape& shape, glm::vec3 origin) {
+    const GLfloat* vertices = bake.ShapeVertices(shape);
+    const GLushort* indices = bake.ShapeIndices(shape);
+    if (shape.cached) {
+        ShapeKey key = shape.Key();
+        UseSharedShape(mesh, key, gGeometryCache.Acquire(key, vertices, shape.vertexFloatCount, indices, shape.indexCount, shape.Bounds()), origin);
+        return;
+    }
+    mesh.vertices.assign(vertices, vertices + shape.vertexFloatCount);
+    mesh.indices.assign(indices, indices + shape.indexCount);
+    mesh.nIndices = shape.indexCount;
+    mesh.localBounds = shape.Bounds();
+    UploadVAOS(mesh);
+}
+
+// Write the built scene to a bake so later runs can skip the scene file
+bool SaveSceneBake(const SceneDescription& scene, const string& path, uint64_t sourceStamp) {
+    SceneBake bake;
+    std::map<ShapeKey, unsigned int> cachedShapes;
+    for (unsigned int i = 0; i < scene.textures.size(); i++) {
+        bake.AddTexture(scene.textures.at(i).file);
+    }
+    for (unsigned int i = 0; i < scene.objects.size(); i++) {
+        bake.AddObject(scene.objects.at(i).name, gSceneModels.at(i).transform);
+        for (unsigned int j = 0; j < scene.objects.at(i).parts.size(); j++) {
+            const GLMesh& mesh = gSceneModels.at(i).parts.at(j);
+            BakedPart part;
+            memset(&part, 0, sizeof(part));
+            part.shape = BakeShape(bake, mesh, cachedShapes);
+            part.texture = scene.objects.at(i).parts.at(j).texture;
+            part.material = mesh.material;
+            part.flags = (mesh.castsShadow ? BAKED_CASTS_SHADOW : 0) | (mesh.instanceGroup >= 0 ? BAKED_INSTANCED : 0);
+            memcpy(part.origin, glm::value_ptr(glm::vec3(mesh.offset[3])), sizeof(part.origin));
+            memcpy(part.placement, glm::value_ptr(mesh.placement), sizeof(part.placement));
+            bake.AddPart(part);
+        }
+    }
+
+    const GLMesh* lightMeshes[2] = { &gLight1, &gLight2 };
+    for (int i = 0; i < 2; i++) {
+        const SceneLightDescription& description = scene.lights[i];
+        if (!description.defined) {
+            continue;
+        }
+        BakedLight light;
+        memset(&light, 0, sizeof(light));
+        light.defined = 1;
+        light.shape = BakeShape(bake, *lightMeshes[i], cachedShapes);
+        light.hasTarget = description.hasTarget;
+        memcpy(light.position, glm::value_ptr(description.shape.transform.translation), sizeof(light.position));
+        memcpy(light.color, glm::value_ptr(description.color), sizeof(light.color));
+        light.intensity = description.intensity;
+        memcpy(light.target, glm::value_ptr(description.target), sizeof(light.target));
+        memcpy(light.placement, glm::value_ptr(lightMeshes[i]->placement), sizeof(light.placement));
+        bake.SetLight(i, light);
+    }
+    return bake.Save(path, sourceStamp);
+}
+
+// Index of a mesh's shape in a bake being built. Meshes sharing a cached shape share one copy of it
+unsigned int BakeShape(SceneBake& bake, const GLMesh& mesh, std::map<ShapeKey, unsigned int>& cachedShapes) {
+    if (!mesh.cachedShape) {
+        return bake.AddShape(NULL, mesh.vertices, mesh.indices, mesh.localBounds);
+    }
+    std::map<ShapeKey, unsigned int>::iterator found = cachedShapes.find(mesh.shapeKey);
+    if (found != cachedShapes.end()) {
+        return found->second;
+    }
+    unsigned int shape = bake.AddShape(&mesh.shapeKey, mesh.vertices, mesh.indices, mesh.localBounds);
+    cachedShapes[mesh.shapeKey] = shape;
+    return shape;
+}
+
+// Set a light's position, color, and intensity from the scene
+void SetSceneLight(int light, glm::vec3 position, glm::vec3 color, GLfloat intensity) {
+    LightComponent& component = SceneLight(light);
+    component.position = position;
+    component.color = component.sceneColor = color;
+    component.intensity = intensity;
+}
+
+// Start a new set of entities with the key and fill lights, which keep the default values until the scene sets them
+void CreateLightEntities() {
+    gEntities.Clear();
+    LightComponent key;
+    key.position = KEY_LIGHT_POSITION;
+    key.color = key.sceneColor = KEY_LIGHT_COLOR;
+    key.intensity = KEY_LIGHT_INTENSITY;
+    gLightEntities[SceneDescription::KEY_LIGHT] = gEntities.Create();
+    gEntities.Lights().Add(gLightEntities[SceneDescription::KEY_LIGHT], key);
+
+    LightComponent fill;
+    fill.position = FILL_LIGHT_POSITION;
+    fill.color = fill.sceneColor = FILL_LIGHT_COLOR;
+    fill.intensity = FILL_LIGHT_INTENSITY;
+    fill.target = FILL_LIGHT_TARGET;
+    gLightEntities[SceneDescription::FILL_LIGHT] = gEntities.Create();
+    gEntities.Lights().Add(gLightEntities[SceneDescription::FILL_LIGHT], fill);
+}
+
+// Light component of the key or fill light
+LightComponent& SceneLight(int light) {
+    return gEntities.Lights().Get(gLightEntities[light]);
+}
+
+// Shape key of a part the geometry cache can build. Returns false for shapes that get their own buffers
+bool ScenePartShape(const ScenePart& part, ShapeKey& key) {
+    switch (part.primitive) {
+    case PRIMITIVE_SPHERE:
+        key = ShapeKey::SphereKey(part.size[0], part.rings, part.sectors);
+        return true;
+    case PRIMITIVE_CUBOID:
+        key = ShapeKey::CuboidKey(part.size[0], part.size[1], part.size[2], part.tiles[0], part.tiles[1], part.tiles[2]);
+        return true;
+    case PRIMITIVE_CYLINDER:
+        key = ShapeKey::CylinderKey(part.size[0], part.size[1], part.caps);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Generate the vertices of a scene file part that gets its own buffers. Makes no GL calls, so it can run on any thread
+void GenerateScenePart(GLMesh& mesh, const ScenePart& part) {
+    ShapeKey key;
+    if (ScenePartShape(part, key)) {
+        // The geometry cache builds shared shapes
+        return;
+    }
+    if (part.primitive == PRIMITIVE_HALF_SPHERE) {
+        // Half a sphere is not a shape the geometry cache builds, so it gets its own buffers. It keeps the rings up to the equator
+        Sphere sphere(part.size[0], part.rings, part.sectors, part.origin.x, part.origin.y, part.origin.z);
+        sphere.KeepRings((part.rings + 1) / 2);
+        mesh.vertices = sphere.GetVertices();
+        mesh.indices = sphere.GetIndices();
+    }
+    else {
+        // Planes are anchored at their front right corner
+        Vertex frontRight = { part.origin.x, part.origin.y, part.origin.z };
+        GeneratePlane(mesh, frontRight, part.size[0], part.size[1]);
+    }
+    SetLocalBounds(mesh);
+}
+
+// Create the mesh for one part of a scene file object. Parts with their own buffers must have been generated by GenerateScenePart and given their range of the scene batch
+void CreateScenePart(GLMesh& mesh, const ScenePart& part) {
+    ShapeKey key;
+    if (ScenePartShape(part, key)) {
+        UseCachedShape(mesh, key, part.origin);
+    }
+    mesh.texture = part.texture >= 0 ? gSceneTextures.at(part.texture) : 0;
+    mesh.castsShadow = part.castsShadow;
+    mesh.placement = part.transform.Matrix();
+    mesh.material = ScenePartMaterial(part);
+}
+
+// Shader features a scene file part needs
+unsigned int ScenePartMaterial(const ScenePart& part) {
+    unsigned int material = SHADER_TEXTURED | SHADER_SPECULAR | SHADER_SHADOWS;
+    // Parts without a texture use the object color
+    if (part.texture < 0) {
+        material &= ~SHADER_TEXTURED;
+    }
+    // Matte parts skip the specular highlight
+    if (part.matte) {
+        material &= ~SHADER_SPECULAR;
+    }
+    // Parts left out of the shadow maps are not shadowed either
+    if (!part.castsShadow) {
+        material &= ~SHADER_SHADOWS;
+    }
+    return material;
+}
+
+// Update the transforms and bounds of entities whose scene graph nodes moved
+void PlaceObjects() {
+    // Only moved nodes and their children are recomputed
+    gSceneGraph.Update();
+    const vector<int>& changed = gSceneGraph.Changed();
+    if (changed.empty()) {
+        return;
+    }
+
+    // Update world space bounds of the entities that moved. Each entity is independent, so chunks of them run in parallel
+    auto updateEntities = [&changed](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            int entity = gNodeEntities.at(changed.at(i));
+            if (entity < 0) {
+                continue;
+            }
+            TransformComponent& transform = gEntities.Transforms().Get(entity);
+            BoundsComponent& bounds = gEntities.Bounds().Get(entity);
+            transform.model = gSceneGraph.World(changed.at(i));
+            UpdateBounds(bounds, transform.model);
+            gSceneBounds.at(entity) = bounds.world;
+        }
+    };
+    gJobSystem.ParallelFor(changed.size(), JOB_GRAIN, updateEntities);
+
+    // Cached shadow maps no longer match
+    gSceneVersion++;
+
+    // Build the hierarchy the first time objects are placed and refit it after that
+    if (gSceneBvh.Built()) {
+        gSceneBvh.Refit(gSceneBounds);
+    }
+    else {
+        gSceneBvh.Build(gSceneBounds);
+    }
+}
+
+// Move the light meshes to the frame's light positions and refit the scene around them. Runs on the render thread
+void MoveLightMeshes(const FramePacket& frame) {
+    const GLMesh* meshes[2] = { &gLight1, &gLight2 };
+    bool moved = false;
+    for (int i = 0; i < 2; i++) {
+        const glm::vec3& position = frame.lights[i].position;
+        if (gLightNodes[i] < 0 || position == gPlacedLightPositions[i]) {
+            continue;
+        }
+        gSceneGraph.SetLocal(gLightNodes[i], glm::translate(position) * meshes[i]->placement * meshes[i]->offset);
+        gPlacedLightPositions[i] = position;
+        moved = true;
+    }
+    if (moved) {
+        // Picking reads the transforms and the hierarchy on the main thread
+        std::lock_guard<std::mutex> placement(gPlacementLock);
+        PlaceObjects();
+    }
+}
+
+// Make an entity for every mesh in the scene, with a scene graph node for each object and its parts as children
+void RegisterSceneObjects() {
+    gSceneObjects.clear();
+    gSceneGraph.Clear();
+
+    // The light meshes are placed with their rotation and scale, then moved to the light position
+    Entity key = gLightEntities[SceneDescription::KEY_LIGHT];
+    Entity fill = gLightEntities[SceneDescription::FILL_LIGHT];
+    // They are top level nodes, which the graph always accepts
+    gPlacedLightPositions[SceneDescription::KEY_LIGHT] = SceneLight(SceneDescription::KEY_LIGHT).position;
+    gPlacedLightPositions[SceneDescription::FILL_LIGHT] = SceneLight(SceneDescription::FILL_LIGHT).position;
+    gLightNodes[SceneDescription::KEY_LIGHT] = gSceneGraph.AddNode(-1, glm::translate(gPlacedLightPositions[SceneDescription::KEY_LIGHT]) * gLight1.placement * gLight1.offset);
+    gLightNodes[SceneDescription::FILL_LIGHT] = gSceneGraph.AddNode(-1, glm::translate(gPlacedLightPositions[SceneDescription::FILL_LIGHT]) * gLight2.placement * gLight2.offset);
+    AddSceneEntity(key, gLight1, "lamp light", 0, gLightNodes[SceneDescription::KEY_LIGHT]);
+    AddSceneEntity(fill, gLight2, "fluorescent light", 0, gLightNodes[SceneDescription::FILL_LIGHT]);
+
+    for (unsigned int i = 0; i < gSceneModels.size(); i++) {
+        SceneModel& model = gSceneModels.at(i);
+        model.node = gSceneGraph.AddNode(-1, model.transform);
+        glm::mat4 toObject = glm::inverse(model.transform);
+        for (unsigned int j = 0; j < model.parts.size(); j++) {
+            GLMesh& mesh = model.parts.at(j);
+            // Parts that gave their own transform are kept where the scene file put them, relative to their object
+            glm::mat4 local = mesh.placement == model.transform ? mesh.offset : toObject * mesh.placement * mesh.offset;
+            int node = gSceneGraph.AddNode(model.node, local);
+            if (node < 0) {
+                cout << "Part " << j << " of the " << model.name << " could not be added to the scene graph and is left out." << endl;
+                continue;
+            }
+            AddSceneEntity(gEntities.Create(), mesh, model.name, j, node);
+        }
+    }
+
+    gNodeEntities.assign(gSceneGraph.Size(), -1);
+    ComponentArray<TransformComponent>& transforms = gEntities.Transforms();
+    for (unsigned int i = 0; i < transforms.Size(); i++) {
+        gNodeEntities.at(transforms.At(i).node) = transforms.EntityAt(i);
+    }
+    gSceneBounds.assign(gEntities.Count(), AABB());
+}
+
+// Give an entity the components of a mesh and add it to the scene object list
+void AddSceneEntity(Entity entity, GLMesh& mesh, const string& name, unsigned int part, int node) {
+    gSceneObjects.push_back({ &mesh, name, part });
+
+    TransformComponent transform;
+    transform.node = node;
+    gEntities.Transforms().Add(entity, transform);
+
+    MeshComponent meshComponent;
+    meshComponent.vao = mesh.vao;
+    meshComponent.indexCount = mesh.nIndices;
+    meshComponent.indexOffset = mesh.indexOffset;
+    meshComponent.instanceGroup = mesh.instanceGroup;
+    gEntities.Meshes().Add(entity, meshComponent);
+
+    BoundsComponent bounds;
+    bounds.local = mesh.localBounds;
+    gEntities.Bounds().Add(entity, bounds);
+
+    // Lights are drawn in their own color, so only the other meshes get a material
+    if (!gEntities.Lights().Has(entity)) {
+        MaterialComponent material;
+        material.material = mesh.material;
+        material.texture = mesh.texture;
+        material.castsShadow = mesh.castsShadow;
+        gEntities.Materials().Add(entity, material);
+    }
+}
+
+// Mark the entities that are inside the view frustum and not hidden behind other meshes
+void CullSceneObjects(const FramePacket& frame) {
+    // Everything starts hidden. Entities in nodes the frustum rejects are never visited
+    gEntities.SetAllVisible(false);
+
+    // Each job walks one subtree of the hierarchy, so whole nodes are still accepted or rejected with one test
+    std::atomic<unsigned int> visited(0);
+    std::atomic<unsigned int> occluded(0);
+    bool testOcclusion = frame.occlusionCulling && gOcclusionCuller.Ready();
+    const Frustum* frustum = frame.frustumCulling ? &gFrustum : nullptr;
+    auto cullSubtrees = [&](unsigned int begin, unsigned int end) {
+        unsigned int subtreeVisited = 0;
+        unsigned int subtreeOccluded = 0;
+        for (unsigned int subtree = begin; subtree < end; subtree++) {
+            gSceneBvh.CullFrustum(frustum, gSceneBvh.Subtree(subtree), [&](int entity, bool inside) {
+                const BoundsComponent& entityBounds = gEntities.Bounds().Get(entity);
+                // Entities in nodes crossing the frustum are tested on their own. The sphere rejects most before the box is tested
+                if (!inside && (!gFrustum.Intersects(entityBounds.sphere) || !gFrustum.Intersects(entityBounds.world))) {
+                    return;
+                }
+                subtreeVisited++;
+                // Test what is left against the Hi-Z pyramid
+                if (testOcclusion && gOcclusionCuller.IsOccluded(entityBounds.world)) {
+                    subtreeOccluded++;
+                    return;
+                }
+                gEntities.SetVisible(entity, true);
+            });
+        }
+        visited += subtreeVisited;
+        occluded += subtreeOccluded;
+    };
+    gJobSystem.ParallelFor(gSceneBvh.SubtreeCount(), 1, cullSubtrees);
+    frameStats.culled = gEntities.Count() - visited;
+    frameStats.occluded = occluded;
+}
+
+// List the visible entities that have a material, sorted by program, texture, and vertex array
+void BuildDrawList() {
+    // Keys are worked out in parallel chunks. Hidden entities get a key that marks them for removal
+    ComponentArray<MaterialComponent>& materials = gEntities.Materials();
+    gDrawList = gFrameArena.AllocateArray<DrawItem>(materials.Size());
+    auto buildKeys = [&materials](unsigned int begin, unsigned int end) {
+        for (unsigned int slot = begin; slot < end; slot++) {
+            Entity entity = materials.EntityAt(slot);
+            DrawItem& item = gDrawList[slot];
+            item.entity = entity;
+            if (!gEntities.Visible(entity)) {
+                item.key = EntityWorld::HIDDEN_KEY;
+                continue;
+            }
+            const MaterialComponent& material = materials.At(slot);
+            const MeshComponent& mesh = gEntities.Meshes().Get(entity);
+            bool lightmapped = gDrawLightmapped && mesh.lightmapVao;
+            item.key = EntityWorld::SortKey(lightmapped, material.material, material.texture, lightmapped ? mesh.lightmapVao : mesh.vao);
+        }
+    };
+    gJobSystem.ParallelFor(materials.Size(), JOB_GRAIN, buildKeys);
+
+    // Drop the hidden entities, then put draws that share state next to each other
+    gDrawCount = std::remove_if(gDrawList, gDrawList + materials.Size(), [](const DrawItem& item) { return item.key == EntityWorld::HIDDEN_KEY; }) - gDrawList;
+    std::sort(gDrawList, gDrawList + gDrawCount);
+}
+
+// Test a ray against every triangle of a mesh. Distance is measured in multiples of the direction's length
+bool RayHitsMesh(const GLMesh& mesh, const glm::mat4& model, const glm::vec3& origin, const glm::vec3& direction, float& distance) {
+    // Move the ray into object space so the vertices can be used as they are
+    glm::mat4 inverseModel = glm::inverse(model);
+    glm::vec3 localOrigin = glm::vec3(inverseModel * glm::vec4(origin, 1.0f));
+    glm::vec3 localDirection = glm::vec3(inverseModel * glm::vec4(direction, 0.0f));
+
+    bool hit = false;
+    distance = FLT_MAX;
+    for (unsigned int i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        glm::vec3 corners[3];
+        for (int corner = 0; corner < 3; corner++) {
+            unsigned int vertex = mesh.indices.at(i + corner) * 8;
+            corners[corner] = glm::vec3(mesh.vertices.at(vertex), mesh.vertices.at(vertex + 1), mesh.vertices.at(vertex + 2));
+        }
+        // Moller-Trumbore ray triangle intersection
+        glm::vec3 edge1 = corners[1] - corners[0];
+        glm::vec3 edge2 = corners[2] - corners[0];
+        glm::vec3 p = glm::cross(localDirection, edge2);
+        float determinant = glm::dot(edge1, p);
+        if (std::fabs(determinant) < 1e-8f) {
+            continue;
+        }
+        float inverseDeterminant = 1.0f / determinant;
+        glm::vec3 toOrigin = localOrigin - corners[0];
+        float u = glm::dot(toOrigin, p) * inverseDeterminant;
+        if (u < 0.0f || u > 1.0f) {
+            continue;
+        }
+        glm::vec3 q = glm::cross(toOrigin, edge1);
+        float v = glm::dot(localDirection, q) * inverseDeterminant;
+        if (v < 0.0f || u + v > 1.0f) {
+            continue;
+        }
+        float t = glm::dot(edge2, q) * inverseDeterminant;
+        if (t > 0.0f && t < distance) {
+            distance = t;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+// Transform an entity's object space bounds by its model matrix
+void UpdateBounds(BoundsComponent& bounds, const glm::mat4& model) {
+    bounds.world = bounds.local.Transform(model);
+    bounds.sphere.center = bounds.world.Center();
+    bounds.sphere.radius = glm::length(bounds.world.Extents());
+}
+
+// Draw a mesh's triangles with the current program and texture
+void DrawMesh(GLuint vao, GLuint indexCount, GLintptr indexOffset, const glm::mat4& model, GLint modelLoc) {
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, (void*)indexOffset);
+    frameStats.drawn++;
+    frameStats.drawCalls++;
+}
+
+// Draw the entities in the draw list with the cheapest program that covers each material
+void DrawSceneObjects() {
+    // Each instance group gets room in the frame arena for every one of its parts
+    for (unsigned int i = 0; i < gInstanceGroups.size(); i++) {
+        InstanceGroup& group = gInstanceGroups.at(i);
+        group.models = gFrameArena.AllocateArray<glm::mat4>(group.parts);
+        group.modelCount = 0;
+    }
+
+    // The list is sorted by texture within each program, so a texture is only bound when it changes
+    GLuint boundTexture = 0;
+    bool textureBound = false;
+    for (unsigned int i = 0; i < gDrawCount; i++) {
+        Entity entity = gDrawList[i].entity;
+        const MeshComponent& mesh = gEntities.Meshes().Get(entity);
+        const MaterialComponent& material = gEntities.Materials().Get(entity);
+        const glm::mat4& model = gEntities.Transforms().Get(entity).model;
+
+        // Copies of a shared shape are drawn together once the list has been walked
+        bool lightmapped = gDrawLightmapped && mesh.lightmapVao;
+        if (!lightmapped && mesh.instanceGroup >= 0) {
+            InstanceGroup& group = gInstanceGroups.at(mesh.instanceGroup);
+            group.models[group.modelCount++] = model;
+            continue;
+        }
+        bool textured = lightmapped || (material.material & SHADER_TEXTURED) != 0;
+        if (textured && (!textureBound || boundTexture != material.texture)) {
+            glBindTexture(GL_TEXTURE_2D, material.texture);
+            boundTexture = material.texture;
+            textureBound = true;
+        }
+
+        // Lightmapped meshes use their unwelded vertices, which carry the lightmap UVs
+        if (lightmapped) {
+            GLint modelLoc = UseObjectProgram(gLightmapProgram);
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            glUniform4fv(glGetUniformLocation(gLightmapProgram, "lightmapScaleOffset"), 1, glm::value_ptr(mesh.lightmapScaleOffset));
+            glBindVertexArray(mesh.lightmapVao);
+            glDrawArrays(GL_TRIANGLES, 0, mesh.lightmapVertexCount);
+            frameStats.drawn++;
+            frameStats.drawCalls++;
+            continue;
+        }
+        GLint modelLoc = UseObjectProgram(ObjectShader(ShaderVariants::Key(material.material, SCENE_LIGHT_COUNT)));
+        DrawMesh(mesh.vao, mesh.indexCount, mesh.indexOffset, model, modelLoc);
+    }
+}
+
+// Draw the mesh of every visible light in the color it had when the frame was simulated
+void DrawLights(const FramePacket& frame) {
     // Switch to the program for the light objects (does not interact with the lighting shaders)
     glUseProgram(gProgram2);
-    modelLoc = glGetUniformLocation(gProgram2, "model");
-    viewLoc = glGetUniformLocation(gProgram2, "view");
-    projLoc = glGetUniformLocation(gProgram2, "projection");
+    GLint modelLoc = glGetUniformLocation(gProgram2, "model");
     GLint colorLoc = glGetUniformLocation(gProgram2, "color");
 
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform4f(colorLoc, gLight1Color.r, gLight1Color.g, gLight1Color.b, 1.0f);
-
     // Unbind texture
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    // Draw light locations
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gLight1.model));
-    glBindVertexArray(gLight1.vao);
-    glDrawElements(GL_TRIANGLES, gLight1.nIndices, GL_UNSIGNED_SHORT, NULL);
-    
-    glUniform4f(colorLoc, gLight2Color.r, gLight2Color.g, gLight2Color.b, 1.0f);
-    glUniformMatrix4fv(colorLoc, 1, GL_FALSE, glm::value_ptr(gLight2Color));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gLight2.model));
-    glBindVertexArray(gLight2.vao);
-    glDrawElements(GL_TRIANGLES, gLight2.nIndices, GL_UNSIGNED_SHORT, NULL);
+    for (int i = 0; i < 2; i++) {
+        Entity entity = gLightEntities[i];
+        if (!gEntities.Visible(entity)) {
+            continue;
+        }
+        const LightComponent& light = frame.lights[i];
+        const MeshComponent& mesh = gEntities.Meshes().Get(entity);
+        glUniform4f(colorLoc, light.color.r, light.color.g, light.color.b, 1.0f);
+        DrawMesh(mesh.vao, mesh.indexCount, mesh.indexOffset, gEntities.Transforms().Get(entity).model, modelLoc);
+    }
+
     // Deactivate the VAO
     glBindVertexArray(0);
-    // Swap frame buffers
-    glfwSwapBuffers(gWindow);
+}
+
+// Switch to an object program, setting its texture units the first time it is used. Returns the model uniform location
+GLint UseObjectProgram(GLuint program) {
+    if (program != gObjectProgram) {
+        glUseProgram(program);
+        gObjectProgram = program;
+    }
+    GLint modelLoc = glGetUniformLocation(program, "model");
+    if (std::find(gPreparedPrograms.begin(), gPreparedPrograms.end(), program) != gPreparedPrograms.end()) {
+        return modelLoc;
+    }
+    gPreparedPrograms.push_back(program);
+
+    // Texture units of the cached shadow maps and the lightmap. Variants without them ignore these
+    glUniform1i(glGetUniformLocation(program, "shadowCube"), SHADOW_CUBE_UNIT);
+    glUniform1i(glGetUniformLocation(program, "shadowMap"), SHADOW_MAP_UNIT);
+    glUniform1i(glGetUniformLocation(program, "lightmap"), LIGHTMAP_UNIT);
+    return modelLoc;
+}
 
+// Start compiling the object shader variant for every material in the scene so none compile mid frame
+void PrepareObjectShaders() {
+    // A variant that fails later is drawn with every feature turned on, so those variants are always built
+    gObjectShaders.SetFallbackFeatures(OBJECT_FALLBACK_FEATURES);
+    gObjectShaders.Prepare(ShaderVariants::Key(OBJECT_FALLBACK_FEATURES, SCENE_LIGHT_COUNT));
+    gObjectShaders.Prepare(ShaderVariants::Key(OBJECT_FALLBACK_FEATURES | SHADER_INSTANCED, SCENE_LIGHT_COUNT));
+    ComponentArray<MaterialComponent>& materials = gEntities.Materials();
+    for (unsigned int i = 0; i < materials.Size(); i++) {
+        const MeshComponent& mesh = gEntities.Meshes().Get(materials.EntityAt(i));
+        gObjectShaders.Prepare(ShaderVariants::Key(materials.At(i).material | (mesh.instanceGroup >= 0 ? SHADER_INSTANCED : 0), SCENE_LIGHT_COUNT));
+    }
+    // Room to mark every variant and the lightmap program as prepared without allocating mid frame
+    gPreparedPrograms.reserve(gObjectShaders.Count() + 1);
 }
 
-// Build object meshes for the scene that don't have their own function
-void BuildObjects() {
+// Object shader variant for a key. Finishing or compiling a variant the first time it is drawn with is counted as shader work
+GLuint ObjectShader(unsigned int key) {
+    AllocationScope shaderAllocations(ALLOC_SHADERS);
+    bool failedBefore = gObjectShaders.Failed(key);
+    GLuint program = gObjectShaders.Get(key);
+    if (!failedBefore && gObjectShaders.Failed(key)) {
+        cout << "Object shader variant " << key << " failed to build. Drawing with variant " << gObjectShaders.FallbackKey(key) << " instead." << endl;
+    }
+    if (gPreparedPrograms.capacity() < gObjectShaders.Count() + 1) {
+        gPreparedPrograms.reserve(gObjectShaders.Count() + 1);
+    }
+    return program;
+}
 
-    // Create an anchor position for planes
-    Vertex frontRight;
-    frontRight.x = 1.0f;
-    frontRight.y = 0.0f;
-    frontRight.z = 1.0f;
+// Draw every entity that casts shadows with the shadow map program
+void DrawShadowCasters(GLint modelLoc) {
+    ComponentArray<MaterialComponent>& materials = gEntities.Materials();
+    for (unsigned int i = 0; i < materials.Size(); i++) {
+        if (!materials.At(i).castsShadow) {
+            continue;
+        }
+        Entity entity = materials.EntityAt(i);
+        const MeshComponent& mesh = gEntities.Meshes().Get(entity);
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gEntities.Transforms().Get(entity).model));
+        glBindVertexArray(mesh.vao);
+        glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_SHORT, (void*)mesh.indexOffset);
+    }
+}
 
-    // Create the ball
-    Sphere ball(0.5f, 12, 32, 0.0f, 0.0f, 0.0f);
-    gSoccerBall.vertices = ball.GetVertices();
-    gSoccerBall.indices = ball.GetIndices();
-    CreateVAOS(gSoccerBall);
-    
-    // Create sphere for lamp light
-    Sphere light1(0.5f, 12, 32, 0.0f, 0.0f, 0.0f);
-    gLight1.vertices = light1.GetVertices();
-    gLight1.indices = light1.GetIndices();
-    CreateVAOS(gLight1);
-
-    // Create plane for fluorescent light
-    CreatePlane(gLight2, frontRight, FLOOR_LENGTH + 2, FLOOR_WIDTH, 1);
-    CreateVAOS(gLight2);
-    
-    // Create floor and wall
-    CreatePlane(gFloor, frontRight, FLOOR_LENGTH, FLOOR_WIDTH, gFloor.texture);
-    CreatePlane(gWallBottom, frontRight, WALL_LENGTH, WALL_WIDTH, gWallTop.texture);
-    CreatePlane(gWallTop, frontRight, WALL_LENGTH + 0.4f, WALL_WIDTH, gWallBottom.texture);
-    
-    // Create trim for wall
-    GLMesh tempTrim;
-    Cuboid lowerTrim(0.01f, 3.0f, 0.01f, 0.0f, 0.0092f, 0.0f, gTrimTexture);
-    Cuboid upperTrim(0.01f, 3.0f, 0.01f, 0.0f, 0.405f, 0.0f, gTrimTexture);
+// Show the frame rate and the drawn, culled, and occluded counts the render thread reported in the window title once per second
+void ReportFrameStats() {
+    float currentTime = (float)glfwGetTime();
+    if (currentTime - statsTime < 1.0f) {
+        return;
+    }
+    gRenderReports.Acquire();
+    const RenderReport& report = gRenderReports.ReadSlot();
+    float fps = (report.frames - statsFrames) / (currentTime - statsTime);
+    statsTime = currentTime;
+    statsFrames = report.frames;
+
+    // Heap allocations of the code that runs every frame since the last report. Anything but zero is a regression
+    string allocations;
+    if (AllocationTracker::Enabled()) {
+        uint64_t frameAllocations = AllocationTracker::Count(ALLOC_INPUT) + AllocationTracker::Count(ALLOC_RENDER);
+        allocations = " | Frame heap allocations: " + std::to_string(frameAllocations - statsAllocations);
+        statsAllocations = frameAllocations;
+    }
 
-    tempTrim.vertices = lowerTrim.GetVertices();
-    tempTrim.indices = lowerTrim.GetIndices();
-    tempTrim.texture = gTrimTexture;
-    gTrim.push_back(tempTrim);
+    string title = string(WINDOW_TITLE) + " | " + std::to_string((int)(fps + 0.5f)) + " FPS | Drawn: " + std::to_string(report.stats.drawn)
+        + " in " + std::to_string(report.stats.drawCalls) + " draw calls"
+        + " | Culled: " + std::to_string(report.stats.culled) + (frustumCulling ? "" : " (culling off)")
+        + " | Occluded: " + std::to_string(report.stats.occluded) + (occlusionCulling ? "" : " (occlusion off)")
+        + allocations
+        + " | Shadow renders: " + std::to_string(report.shadowRenders)
+        + " | Shader variants: " + std::to_string(report.shaderVariants)
+        + (report.lighting ? string(" | ") + report.lighting : string())
+        + (swapInterval ? " | Vsync on" : " | Vsync off")
+        + (renderOnDemand ? " | On demand" : " | Continuous")
+        + (Idle() ? " | Idle" : (frameRateLimit > 0.0 ? " | Limit " + std::to_string((int)frameRateLimit) : ""));
+    glfwSetWindowTitle(gWindow, title.c_str());
+}
 
-    tempTrim.vertices = upperTrim.GetVertices();
-    tempTrim.indices = upperTrim.GetIndices();
-    gTrim.push_back(tempTrim);
-    for (unsigned int i = 0; i < gTrim.size(); i++) {
-        CreateVAOS(gTrim.at(i));
+// Print the heap allocations counted against each subsystem, when this build counts them
+void ReportAllocations() {
+    if (!AllocationTracker::Enabled()) {
+        return;
+    }
+    cout << "Heap allocations:" << endl;
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+        cout << "\t" << AllocationTracker::Name((AllocationTag)tag) << ": " << AllocationTracker::Count((AllocationTag)tag)
+            << " (" << AllocationTracker::Bytes((AllocationTag)tag) / 1024 << " KB)" << endl;
     }
+}
+
+// Fill a frame packet with the camera, lights, and settings of this frame and hand it to the render thread
+void PublishFrame() {
+    // Sleep until the render thread has taken the previous packet. Publishing over it would throw that frame away,
+    // and this wait is what holds the simulation to the rate the render thread draws at. The render thread signals
+    // gFrameTaken right after each take, so the timeout only bounds a missed wake up and the thread never spins
+    while (gFramePackets.Pending()) {
+        gFrameTaken.Wait(WAIT_TIMEOUT);
+    }
+
+    FramePacket& frame = gFramePackets.WriteSlot();
+    frame.view = camera.GetViewMatrix();
 
-    // Create the lamp, end table, coffee table, and couch
-    CreateLamp(gLamp);
-    CreateEndTable(gEndTable);
-    CreateCoffeeTable(gCoffeeTable);
-    CreateCouch(gCouch);
+    // If the perspective type is set to projection
+    if (perspective) {
+        frame.projection = glm::perspective(glm::radians(camera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+    }
+    // If the projection type is set to ortho
+    else {
+        frame.projection = glm::ortho((float)(camera.Zoom / orthoMinMultiplier), (float)(camera.Zoom / orthoMaxMultiplier), (float)(camera.Zoom / orthoMinMultiplier), (float)(camera.Zoom / orthoMaxMultiplier), (float)(orthoMinMultiplier * 3.0f), (float)(orthoMaxMultiplier * 3.0f));
+    }
+    frame.viewPosition = camera.Position;
+    frame.lights[SceneDescription::KEY_LIGHT] = SceneLight(SceneDescription::KEY_LIGHT);
+    frame.lights[SceneDescription::FILL_LIGHT] = SceneLight(SceneDescription::FILL_LIGHT);
+    frame.frustumCulling = frustumCulling;
+    frame.occlusionCulling = occlusionCulling;
+    frame.bakedLighting = bakedLighting;
+    frame.showProfiler = showProfiler;
+    frame.swapInterval = swapInterval;
+    glfwGetFramebufferSize(gWindow, &frame.framebufferWidth, &frame.framebufferHeight);
+
+    gFramePackets.Publish();
+    gRenderWake.Notify();
 }
 
-// Perform matrix transformations to get model matrices for objects
-void PlaceObjects() {
-    // Keep the model's original dimensions
-    glm::mat4 scale = glm::scale(glm::vec3(2.0f, 2.0f, 2.0f));
-    // Set original rotation of model to 45 degree angle
-    glm::mat4 rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-    // Put model in position at origin
-    glm::mat4 translation = glm::translate(glm::vec3(glm::vec3(-5.1f, 2.401f, -7.0f)));
-
-    // Model matrix
-    glm::mat4 model = translation * rotation * scale;
-
-    // Draw end table
-    for (unsigned int i = 0; i < gEndTable.size(); i++) {
-        gEndTable.at(i).model = model;
-    }
-
-    // Set matrix for soccer ball
-    scale = glm::scale(glm::vec3(1.5f, 1.5f, 1.5f));
-    translation = glm::translate(glm::vec3(-4.7f, 0.74f, -6.8f));
-    model = translation * rotation * scale;
-    gSoccerBall.model = model;
-    
-    // Floor
-    scale = glm::scale(glm::vec3(10.0f, 10.0f, 10.0f));
-    translation = glm::translate(glm::vec3(10.0f, 0.0f, 0.0f));
-    model = translation * rotation * scale;
-    gFloor.model = model;
-
-    // Trim
-    translation = glm::translate(glm::vec3(-10.0f, 0.01f, -9.9999f));
-    model = translation * rotation * scale;
-    for (unsigned int i = 0; i < gTrim.size(); i++) {
-        gTrim.at(i).model = model;
-    }
-    // Bottom of wall
-    rotation = glm::rotate(PI / 2, glm::vec3(1.0f, 0.0f, 0.0f));
-    scale = glm::scale(glm::vec3(10.0f, 10.0f, 10.0f));
-    translation = glm::translate(glm::vec3(10.0f, 10.0f, -10.0f));
-    model = translation * rotation * scale;
-    gWallBottom.model = model;
-
-    // Top of wall
-    rotation = glm::rotate(PI / 2, glm::vec3(1.0f, 0.0f, 0.0f));
-    scale = glm::scale(glm::vec3(10.0f, 10.0f, 10.0f));
-    translation = glm::translate(glm::vec3(10.0f, 14.0f, -10.0f));
-    model = translation * rotation * scale;
-    gWallTop.model = model;
-
-    // Coffee table
-    scale = glm::scale(glm::vec3(2.0f, 2.0f, 2.0f));
-    rotation = glm::rotate(1.5701f, glm::vec3(0.0f, 1.0f, 0.0f));
-    translation = glm::translate(glm::vec3(0.0f, 2.661f, 0.0f));
-    model = translation * rotation * scale;
-    for (unsigned int i = 0; i < gCoffeeTable.size(); i++) {
-        gCoffeeTable.at(i).model = model;
-    }
-    // Couch
-    scale = glm::scale(glm::vec3(1.0f, 1.0f, 1.0f));
-    for (unsigned int i = 0; i < gCouch.size(); i++) {
-        if (i < 3) {
-            // Draw bottom cushion
-            translation = glm::translate(glm::vec3(-3.0f, 2.5f, -7.2f));
-            rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-            model = translation * rotation * scale;
-            gCouch.at(i).model = model;
+// Draw the newest frame packet whenever one arrives. Runs on its own thread, which owns the GL context
+void RenderLoop() {
+    AllocationTracker::SetTag(ALLOC_RENDER);
+    glfwMakeContextCurrent(gWindow);
+    int appliedSwapInterval = swapInterval;
+    int viewportWidth = 0;
+    int viewportHeight = 0;
+    bool occlusionWasOn = false;
+    while (gRenderRunning) {
+        // Rebuild any programs whose shader files were saved, even while no frames arrive
+        ReloadChangedShaders();
+
+        // Sleep until the simulation thread publishes a frame, then let it start on the next one
+        if (!gFramePackets.Acquire()) {
+            gRenderWake.Wait(WAIT_TIMEOUT);
+            continue;
         }
-        else if (i > 2 && i < 6) {
-            // Draw back cushion
-            translation = glm::translate(glm::vec3(-3.0f, 4.5f, -8.0f));
-            rotation = glm::rotate(1.309f, glm::vec3(1.0f, 0.0f, 0.0f));
-            model = translation * rotation * scale;
-            gCouch.at(i).model = model;
+        gFrameTaken.Notify();
+        const FramePacket& frame = gFramePackets.ReadSlot();
+
+        // Apply settings that need the GL context
+        if (frame.swapInterval != appliedSwapInterval) {
+            glfwSwapInterval(frame.swapInterval);
+            appliedSwapInterval = frame.swapInterval;
         }
-        else if (i > (gCouch.size() - 3)) {
-            translation = glm::translate(glm::vec3(-3.3f, 1.85f, -8.199f));
-            rotation = glm::rotate((float)(PI/2), glm::vec3(1.0f, 0.0f, 0.0f));
-            model = translation * rotation * scale;
-            gCouch.at(i).model = model;
+        if (frame.framebufferWidth != viewportWidth || frame.framebufferHeight != viewportHeight) {
+            glViewport(0, 0, frame.framebufferWidth, frame.framebufferHeight);
+            // Size the Hi-Z pyramid for the new window here, so drawing the frame does not allocate it
+            gOcclusionCuller.Reserve(frame.framebufferWidth, frame.framebufferHeight);
+            viewportWidth = frame.framebufferWidth;
+            viewportHeight = frame.framebufferHeight;
         }
-        else {
-            translation = glm::translate(glm::vec3(-3.0f, 1.5f, -7.2f));
-            rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-            model = translation * rotation * scale;
-            gCouch.at(i).model = model;
+        // Depth captured before occlusion culling was toggled no longer matches the view
+        if (frame.occlusionCulling != occlusionWasOn) {
+            gOcclusionCuller.Invalidate();
+            occlusionWasOn = frame.occlusionCulling;
         }
+
+        // Drawing a frame must not allocate. One time work inside it counts against its own subsystem
+        ZeroAllocationScope renderAllocations(ALLOC_RENDER);
+        Display(frame);
     }
+    glfwMakeContextCurrent(NULL);
+}
 
-    // Position lights
-    rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-    translation = glm::translate(gLight1Position);
-    model = translation * rotation * scale;
-    gLight1.model = model;
+// Publish the counters of the frame just drawn for the simulation thread
+void PublishRenderReport(const FramePacket& frame) {
+    static unsigned int framesDrawn = 0;
+    RenderReport& report = gRenderReports.WriteSlot();
+    report.stats = frameStats;
+    report.frames = ++framesDrawn;
+    report.shadowRenders = gShadowMaps.RenderCount();
+    report.shaderVariants = gObjectShaders.Count();
+    report.lighting = gLightmapPending ? "Baking lightmap" : (BakedLightingActive(frame) ? "Baked lighting" : "Dynamic lighting");
+    gRenderReports.Publish();
+}
 
-    translation = glm::translate(gLight2Position);
-    model = translation * rotation * scale;
-    gLight2.model = model;
+// Record that the user did something, which keeps the frame rate at its normal limit and needs a new frame
+void NoteActivity() {
+    lastActivity = glfwGetTime();
+    MarkDirty();
+}
 
-    // Position the lamp
-    rotation = glm::rotate(PI, glm::vec3(1.0f, 0.0f, 0.0f));
-    scale = glm::scale(glm::vec3(1.0f, 1.0f, 1.0f));
-    translation = glm::translate(glm::vec3(-5.1f, 4.3f, -8.3f));
-    
-    for (unsigned int i = 0; i < gLamp.size(); i++) {
-        model = translation * rotation * scale;
-        rotation = glm::rotate(PI, glm::vec3(1.0f, 0.0f, -1.0f));
-        gLamp.at(i).model = model;
+// Draw the next frames even when rendering on demand. Safe to call from the render thread
+void MarkDirty() {
+    redrawFrames = REDRAW_FRAMES;
+    // Wake the simulation thread if it is waiting for events
+    glfwPostEmptyEvent();
+}
+
+// True if there has been no input for a while
+bool Idle() {
+    return glfwGetTime() - lastActivity > IDLE_DELAY;
+}
+
+// Bake the lighting of every placed mesh in the background. The light meshes are left out since they glow
+void StartLightmapBake() {
+    vector<LightmapInput> inputs;
+    for (unsigned int i = 0; i < gSceneObjects.size(); i++) {
+        const GLMesh& mesh = *gSceneObjects.at(i).mesh;
+        LightmapInput input;
+        input.vertices = mesh.vertices;
+        input.indices = mesh.indices;
+        input.model = gEntities.Transforms().Get(i).model;
+        input.baked = !gEntities.Lights().Has(i);
+        input.occluder = gEntities.Materials().Has(i) && gEntities.Materials().Get(i).castsShadow;
+        inputs.push_back(input);
     }
+    gLightmapBaker.Start(gJobSystem, inputs, SceneLight(SceneDescription::KEY_LIGHT).position, SceneLight(SceneDescription::FILL_LIGHT).position);
+    gLightmapSceneVersion = gSceneVersion;
+    gLightmapPending = true;
 }
 
-// Create vertex array objects for meshes
-void CreateVAOS(GLMesh& mesh) {
+// Create the lightmap texture and the lightmapped vertex arrays from a finished bake
+void UploadLightmap() {
+    AllocationScope lightmapAllocations(ALLOC_LIGHTMAP);
+    glDeleteTextures(1, &gLightmapTexture);
+    gLightmapTexture = gLightmapBaker.CreateTexture();
+
+    const vector<LightmapChart>& charts = gLightmapBaker.Charts();
+    for (unsigned int i = 0; i < gSceneObjects.size() && i < charts.size(); i++) {
+        GLMesh& mesh = *gSceneObjects.at(i).mesh;
+        const LightmapChart& chart = charts.at(i);
+        // Meshes without a place in the atlas keep their own material
+        if (!chart.placed) {
+            gEntities.Meshes().Get(i).lightmapVao = 0;
+            continue;
+        }
+        if (!mesh.lightmapVao) {
+            glGenVertexArrays(1, &mesh.lightmapVao);
+            glGenBuffers(1, &mesh.lightmapVbo);
+        }
+        glBindVertexArray(mesh.lightmapVao);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.lightmapVbo);
+        glBufferData(GL_ARRAY_BUFFER, chart.vertices.size() * sizeof(GLfloat), chart.vertices.data(), GL_STATIC_DRAW);
+
+        // Strides between vertices is 10 (x, y, z, nx, ny, nz, u, v, lightmap u, lightmap v)
+        GLint stride = sizeof(float) * 10;
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, 0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 3));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 6));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 8));
+        glEnableVertexAttribArray(3);
+
+        MeshComponent& component = gEntities.Meshes().Get(i);
+        component.lightmapVao = mesh.lightmapVao;
+        component.lightmapVertexCount = chart.vertices.size() / 10;
+        component.lightmapScaleOffset = chart.scaleOffset;
+    }
+    glBindVertexArray(0);
+    gLightmapPending = false;
+}
+
+// True if baked lighting is turned on and the lightmap was baked for the current objects and the frame's lights
+bool BakedLightingActive(const FramePacket& frame) {
+    return frame.bakedLighting && gLightmapTexture && !gLightmapPending && gLightmapSceneVersion == gSceneVersion
+        && gLightmapBaker.LightPosition(0) == frame.lights[SceneDescription::KEY_LIGHT].position
+        && gLightmapBaker.LightPosition(1) == frame.lights[SceneDescription::FILL_LIGHT].position;
+}
+
+// Set a mesh's index count and object space bounds from its generated vertices
+void SetLocalBounds(GLMesh& mesh) {
+    // Set the number of indices
+    mesh.nIndices = mesh.indices.size();
+
+    // Object space bounds from the vertex positions (first three of every eight floats)
+    mesh.localBounds = AABB();
+    for (unsigned int i = 0; i + 2 < mesh.vertices.size(); i += 8) {
+        mesh.localBounds.Expand(glm::vec3(mesh.vertices[i], mesh.vertices[i + 1], mesh.vertices[i + 2]));
+    }
+}
+
+// Send a mesh's vertices and indices to the GPU and set up its vertex array
+void UploadVAOS(GLMesh& mesh) {
     // Set sizes for data being passed to OpenGL
     const GLuint floatsPerVertex = 3;
     const GLuint floatsPerNormal = 3;
     const GLuint floatsPerUV = 2;
 
-    // Set the number of indices
-    mesh.nIndices = mesh.indices.size();
-
     // Generate vertex arrays
     glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
     glBindVertexArray(mesh.vao);
@@ -812,8 +1920,8 @@ void CreateVAOS(GLMesh& mesh) {
     glEnableVertexAttribArray(2);
 }
 
-// Create a plane for wall or floor
-void CreatePlane(GLMesh& mesh, Vertex frontRight, GLfloat length, GLfloat width, GLuint texture) {
+// Generate the vertices of a plane for wall or floor
+void GeneratePlane(GLMesh& mesh, Vertex frontRight, GLfloat length, GLfloat width) {
     vec3 normal(0.0f, 1.0f, 0.0f);
 
     // Create vertices for corners of plane
@@ -826,186 +1934,138 @@ void CreatePlane(GLMesh& mesh, Vertex frontRight, GLfloat length, GLfloat width,
     mesh.indices = { 0, 1, 3,  // Triangle 1
                      1, 2, 3   // Triangle 2
     };
-    // Create VAOS/VBOS and assign texture
-    CreateVAOS(mesh);
-}
-
-// Create lamp
-void CreateLamp(vector<GLMesh>& meshArray) {
-    GLMesh mesh;
-    Sphere base(0.4f, 12, 32, 0.0f, 0.0f, 0.0f);
-    mesh.vertices = base.GetVertices();
-    mesh.vertices.resize(mesh.vertices.size() / 2);
-    mesh.indices = base.GetIndices();
-    mesh.indices.resize(mesh.indices.size() / 2);
-    mesh.texture = gLampTexture;
-    CreateVAOS(mesh);
-    meshArray.push_back(mesh);
-
-    Cylinder stand(1.5f, 0.1f, 0.0f, -0.3f, 0.0f, BOTTOM);
-    mesh.vertices = stand.GetVertices();
-    mesh.indices = stand.GetIndices();
-    mesh.texture = gLampTexture;
-    CreateVAOS(mesh);
-    meshArray.push_back(mesh);
-
-    Cylinder shade(1.1f, 0.8f, 0.0f, -1.7f, 0.0f, NONE);
-    mesh.vertices = shade.GetVertices();
-    mesh.indices = shade.GetIndices();
-    mesh.texture = gLampShadeTexture;
-    CreateVAOS(mesh);
-    meshArray.push_back(mesh);
-}
-
-// Create the end table
-void CreateEndTable(vector<GLMesh>& meshArray) {
-    
-    GLMesh mesh;
-
-    // Create cuboids for flat surfaces
-    Cuboid topSurface(0.8f, 1.0f, 0.2f, -0.5f, 1.0f, -1.0f, 1);
-    mesh.vertices = topSurface.GetVertices();
-    mesh.indices = topSurface.GetIndices();
-    mesh.texture = gEndTableSurfacesTexture;
-    CreateVAOS(mesh);
-    meshArray.push_back(mesh);
-
-    Cuboid bottomSurface(2.0f, 1.0f, 0.2f, -0.5f, 0.0f, -1.0f, 1);
-    mesh.vertices = bottomSurface.GetVertices();
-    mesh.indices = bottomSurface.GetIndices();
-    mesh.texture = gEndTableSurfacesTexture;
-    CreateVAOS(mesh);
-    meshArray.push_back(mesh);
-
-    // Create cylinders for end table supports and legs
-    Cylinder backLeftSupport(1.0f, 0.1f, -0.4f, 0.8f, -0.9f, NONE);
-    Cylinder middleLeftSupport(1.0f, 0.1f, -0.4f, 0.8f, -0.6f, NONE);
-    Cylinder frontLeftSupport(1.0f, 0.1f, -0.4f, 0.8f, -0.3f, NONE);
-    Cylinder backRightSupport(1.0f, 0.1f, 0.4f, 0.8f, -0.9f, NONE);
-    Cylinder middleRightSupport(1.0f, 0.1f, 0.4f, 0.8f, -0.6f, NONE);
-    Cylinder frontRightSupport(1.0f, 0.1f, 0.4f, 0.8f, -0.3f, NONE);
-    Cylinder backLeftLeg(1.0f, 0.1f, -0.4f, -0.2f, -0.9f, BOTTOM);
-    Cylinder backRightLeg(1.0f, 0.1f, 0.4f, -0.2f, -0.9f, BOTTOM);
-    Cylinder frontLeftLeg(1.0f, 0.1f, -0.4f, -0.2f, 0.9f, BOTTOM);
-    Cylinder frontRightLeg(1.0f, 0.1f, 0.4f, -0.2f, 0.9f, BOTTOM);
-    
-    // Add cylinders to vector to use in loop
-    vector<Cylinder> legsAndSupports = { backLeftSupport, middleLeftSupport, frontLeftSupport, backRightSupport, middleRightSupport, frontRightSupport, backLeftLeg, backRightLeg, frontLeftLeg, frontRightLeg };
-
-    // Generate vertices and indices, store in local variable, then add to vector of meshes
-    for (unsigned int i = 0; i < legsAndSupports.size(); i++) {
-        mesh.vertices = legsAndSupports.at(i).GetVertices();
-        mesh.indices = legsAndSupports.at(i).GetIndices();
-        mesh.texture = gEndTableCylindersTexture;
-        meshArray.push_back(mesh);
-    }
-
-    // Create the VAOs for each part of the end table
-    for (unsigned int i = 0; i < meshArray.size(); i++) {
-        CreateVAOS(meshArray.at(i));
-    }
-}
-
-// Create the coffee table
-void CreateCoffeeTable(vector<GLMesh>& meshArray) {
-    GLMesh tempMesh;
-
-    Cuboid topSurface(4.0f, 3.0f, 0.2f, -2.5f, 0.3f, -1.0f, 1);
-    Cuboid frontLeftLeg(0.2f, 0.2f, 1.53f, -2.3f, 0.2f, -0.9f, 1);
-    Cuboid backLeftLeg(0.2f, 0.2f, 1.53f, 0.1f, 0.2f, -0.9f, 1);
-    Cuboid frontRightLeg(0.2f, 0.2f, 1.53f, -2.3f, 0.2f, 2.7f, 1);
-    Cuboid backRighttLeg(0.2f, 0.2f, 1.53f, 0.1f, 0.2f, 2.7f, 1);
-    Cuboid frontUnderpinning(3.5f, 0.1f, 0.3f, -2.25f, 0.2f, -0.8f, 1);
-    Cuboid backUnderpinning(3.5f, 0.1f, 0.3f, 0.15f, 0.2f, -0.8f, 1);
-    Cuboid leftUnderpinning(0.1f, 2.4f, 0.3f, -2.2f, 0.2f, -0.85f, 1);
-    Cuboid rightUnderpinning(0.1f, 2.4f, 0.3f, -2.2f, 0.2f, 2.75f, 1);
-
-    // Place pieces into vector to run through loop
-    vector<Cuboid> coffeeTable = { topSurface, frontLeftLeg, backLeftLeg, frontRightLeg, backRighttLeg, frontUnderpinning, backUnderpinning, leftUnderpinning, rightUnderpinning };
-    for (unsigned int i = 0; i < coffeeTable.size(); i++) {
-        // Vector items 5 and 6 are the front and back underpinnings, adjust texture accordingly
-        if (i == 5 || i == 6) {
-            coffeeTable.at(i).SetTiles(0.25f, 1.0f, 1.0f);
-        }
-        // Vector items 7 and 8 are the left and right underpinnings, adjust texture accordingly
-        else if (i == 7 || i == 8) {
-            coffeeTable.at(i).SetTiles(1.0f, 0.25f, 1.0f);
-        }
-        // Generate the vertices and indices in the cuboid object, then retrieve them and place in this piece's vertices and indices vectors
-        coffeeTable.at(i).GenCuboid();
-        tempMesh.vertices = coffeeTable.at(i).GetVertices();
-        tempMesh.indices = coffeeTable.at(i).GetIndices();
-        // The first five pieces use the same texture
-        if (i < 5) {
-            tempMesh.texture = gCoffeeTableTopTexture;
+}
+
+// Point a mesh that has its own range of a geometry batch at the batch's buffers
+void UseBatchedBuffers(GLMesh& mesh, const GeometryBatch& batch, unsigned int entry) {
+    const BatchRange& range = batch.Range(entry);
+    mesh.vao = batch.CreateVertexArray(entry);
+    mesh.vbos[0] = batch.VertexBuffer();
+    mesh.vbos[1] = batch.IndexBuffer();
+    mesh.vertexOffset = range.vertexOffset;
+    mesh.indexOffset = range.indexOffset;
+    mesh.batched = true;
+}
+
+// Point a mesh at a shape from the geometry cache, placed at origin
+void UseCachedShape(GLMesh& mesh, const ShapeKey& key, glm::vec3 origin) {
+    UseSharedShape(mesh, key, gGeometryCache.Acquire(key), origin);
+}
+
+// Point a mesh at a shape the geometry cache has handed out, placed at origin
+void UseSharedShape(GLMesh& mesh, const ShapeKey& key, const SharedShape& shape, glm::vec3 origin) {
+    // The vertices are kept for picking and lightmap baking. The buffers on the GPU are the shape's
+    mesh.vertices = shape.vertices;
+    mesh.indices = shape.indices;
+    mesh.vao = shape.vao;
+    mesh.vbos[0] = shape.vbos[0];
+    mesh.vbos[1] = shape.vbos[1];
+    mesh.vertexOffset = shape.vertexOffset;
+    mesh.indexOffset = shape.indexOffset;
+    mesh.nIndices = shape.nIndices;
+    mesh.localBounds = shape.bounds;
+    mesh.offset = glm::translate(origin);
+    mesh.cachedShape = true;
+    mesh.shapeKey = key;
+    mesh.instanceGroup = -1;
+}
+
+// Instance group that draws copies of a shape with a texture and material, creating it the first time. Returns the group's index
+int FindInstanceGroup(const ShapeKey& key, GLuint texture, unsigned int material) {
+    for (unsigned int i = 0; i < gInstanceGroups.size(); i++) {
+        const InstanceGroup& other = gInstanceGroups.at(i);
+        if (!(key < other.shape.shapeKey) && !(other.shape.shapeKey < key) && other.texture == texture && other.material == material) {
+            gInstanceGroups.at(i).parts++;
+            return i;
         }
-        // As do the last 4
-        else {
-            tempMesh.texture = gCoffeeTableUnder;
+    }
+    InstanceGroup group;
+    UseCachedShape(group.shape, key, glm::vec3(0.0f));
+    group.parts = 1;
+    group.material = material;
+    group.texture = texture;
+
+    // Same buffers and attributes as the shape's own vertex array
+    glGenVertexArrays(1, &group.instanceVao);
+    glBindVertexArray(group.instanceVao);
+    glBindBuffer(GL_ARRAY_BUFFER, group.shape.vbos[0]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, group.shape.vbos[1]);
+    GLint stride = sizeof(float) * 8;
+    GLintptr first = group.shape.vertexOffset;
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)first);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(first + sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(first + sizeof(float) * 6));
+    glEnableVertexAttribArray(2);
+
+    // Plus a model matrix per instance, one column per attribute. The buffer is bound each frame from the frame ring
+    for (GLuint column = 0; column < 4; column++) {
+        glVertexAttribFormat(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4) * column);
+        glVertexAttribBinding(3 + column, INSTANCE_BINDING);
+        glEnableVertexAttribArray(3 + column);
+    }
+    glVertexBindingDivisor(INSTANCE_BINDING, 1);
+    glBindVertexArray(0);
+
+    gInstanceGroups.push_back(group);
+    return gInstanceGroups.size() - 1;
+}
+
+// Draw the visible copies of each shared shape with one instanced draw call
+void DrawInstanceGroups() {
+    for (unsigned int i = 0; i < gInstanceGroups.size(); i++) {
+        InstanceGroup& group = gInstanceGroups.at(i);
+        if (group.modelCount == 0) {
+            continue;
         }
-        // Add to the mesh
-        meshArray.push_back(tempMesh);
-    }
-    // Create the VAOs for each part of the coffee table
-    for (unsigned int i = 0; i < meshArray.size(); i++) {
-        CreateVAOS(meshArray.at(i));
-    }
-}
-
-// Create the couch
-void CreateCouch(vector<GLMesh>& meshArray) {
-    GLMesh tempMesh;
-
-    Cuboid leftCushion(3.0f, 2.98f, 1.0f, 0.0f, 0.0f, 0.0f, 1);
-    Cuboid centerCushion(3.0f, 2.98f, 1.0f, 3.0f, 0.0f, 0.0f, 1);
-    Cuboid rightCushion(3.0f, 2.98f, 1.0f, 6.0f, 0.0f, 0.0f, 1);
-    Cuboid backLeftCushion(3.0f, 2.98f, 1.0f, 0.0f, 0.0f, 0.0f, 1);
-    Cuboid backCenterCushion(3.0f, 2.98f, 1.0f, 3.0f, 0.0f, 0.0f, 1);
-    Cuboid backRightCushion(3.0f, 2.98f, 1.0f, 6.0f, 0.0f, 0.0f, 1);
-    Cuboid base(5.0f, 10.0f, 1.47f, -0.5f, -0.02f, -2.0f, 1);
-    Cuboid leftArm(4.99f, 0.497f, 1.54f, -0.499f, 1.5f, -2.0f, 1);
-    Cuboid rightArm(4.99f, 0.497f, 1.54f, 9.001f, 1.5f, -2.0f, 1);
-    Cuboid back(0.51f, 10.01f, 3.79f, -0.5001f, 2.3f, -1.999f, 1);
-    Cylinder leftArmCap(5.02f, 0.4f, 0.0f, 4.0f, -1.0f, BOTH);
-    Cylinder rightArmCap(5.02f, 0.402f, 9.6f, 4.0f, -1.0f, BOTH);
-
-    vector<Cuboid> couch = { leftCushion, centerCushion, rightCushion, backLeftCushion, backCenterCushion, backRightCushion, base, leftArm, rightArm, back};
-
-    for (unsigned int i = 0; i < couch.size(); i++) {
-        // Generate the vertices and indices in the cuboid object, then retrieve them and place in this piece's vertices and indices vectors
-        tempMesh.vertices = couch.at(i).GetVertices();
-        tempMesh.indices = couch.at(i).GetIndices();
-        // The first six pieces use the same texture
-        if (i < 6) {
-            tempMesh.texture = gCouchCushionTexture;
+        bool textured = (group.material & SHADER_TEXTURED) != 0;
+        GLsizei count = group.modelCount;
+        RingAllocation allocation = gFrameRing.Allocate(count * sizeof(glm::mat4), sizeof(glm::vec4));
+        if (allocation.data) {
+            memcpy(allocation.data, group.models, count * sizeof(glm::mat4));
+            gFrameRing.Commit(allocation);
+            UseObjectProgram(ObjectShader(ShaderVariants::Key(group.material | SHADER_INSTANCED, SCENE_LIGHT_COUNT)));
+            if (textured) {
+                glBindTexture(GL_TEXTURE_2D, group.texture);
+            }
+            glBindVertexArray(group.instanceVao);
+            glBindVertexBuffer(INSTANCE_BINDING, gFrameRing.Buffer(), allocation.offset, sizeof(glm::mat4));
+            glDrawElementsInstanced(GL_TRIANGLES, group.shape.nIndices, GL_UNSIGNED_SHORT, (void*)group.shape.indexOffset, count);
+            frameStats.drawn += count;
+            frameStats.drawCalls++;
         }
         else {
-            tempMesh.texture = gCouchTexture;
+            // The frame ring is full, so draw the copies one at a time
+            GLint modelLoc = UseObjectProgram(ObjectShader(ShaderVariants::Key(group.material, SCENE_LIGHT_COUNT)));
+            if (textured) {
+                glBindTexture(GL_TEXTURE_2D, group.texture);
+            }
+            for (unsigned int j = 0; j < group.modelCount; j++) {
+                DrawMesh(group.shape.vao, group.shape.nIndices, group.shape.indexOffset, group.models[j], modelLoc);
+            }
         }
-        // Add to the mesh
-        meshArray.push_back(tempMesh);
+        group.modelCount = 0;
     }
+}
 
-    tempMesh.vertices = leftArmCap.GetVertices();
-    tempMesh.indices = leftArmCap.GetIndices();
-    tempMesh.texture = gCouchTexture;
-    meshArray.push_back(tempMesh);
-    
-    tempMesh.vertices = rightArmCap.GetVertices();
-    tempMesh.indices = rightArmCap.GetIndices();
-    tempMesh.texture = gCouchTexture;
-    meshArray.push_back(tempMesh);
-
-
-    // Create the VAOs for each part of the coffee table
-    for (unsigned int i = 0; i < meshArray.size(); i++) {
-        CreateVAOS(meshArray.at(i));
+// Delete the instance vertex arrays and release their shapes
+void DestroyInstanceGroups() {
+    for (unsigned int i = 0; i < gInstanceGroups.size(); i++) {
+        glDeleteVertexArrays(1, &gInstanceGroups.at(i).instanceVao);
+        DestroyMesh(gInstanceGroups.at(i).shape);
     }
+    gInstanceGroups.clear();
+}
+
+// Function to change the size of a GLFWwindow. The render thread sets the viewport from the next frame packet
+void ChangeSize(GLFWwindow*, int, int) {
+    MarkDirty();
 }
 
-// Function to change the size of a GLFWwindow
-void ChangeSize(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+// Redraw when the window needs its contents again, for example after being uncovered
+void WindowRefreshCallback(GLFWwindow*) {
+    MarkDirty();
 }
 
 // Function to process user input
@@ -1016,6 +2076,17 @@ void ProcessInput(GLFWwindow* window) {
     // Amount camera has moved
     float cameraOffset = cameraSpeed * deltaTime;
 
+    // Holding a movement key keeps the frame rate up
+    static const int movementKeys[] = { GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E,
+        GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_LEFT, GLFW_KEY_RIGHT, GLFW_KEY_PAGE_UP, GLFW_KEY_PAGE_DOWN };
+    bool moving = false;
+    for (unsigned int i = 0; i < sizeof(movementKeys) / sizeof(movementKeys[0]) && !moving; i++) {
+        moving = glfwGetKey(window, movementKeys[i]) == GLFW_PRESS;
+    }
+    if (moving) {
+        NoteActivity();
+    }
+
     // Check if user pressed a key and convert into moving the camera
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
         camera.ProcessKeyboard(FORWARD, deltaTime);
@@ -1036,6 +2107,30 @@ void ProcessInput(GLFWwindow* window) {
         camera.ProcessKeyboard(DOWN, deltaTime);
     }
 
+    // Move the lamp's light with the arrow keys along the floor and Page Up and Page Down vertically. Its mesh follows on the render thread
+    glm::vec3 lightMove(0.0f);
+    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
+        lightMove.z -= 1.0f;
+    }
+    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
+        lightMove.z += 1.0f;
+    }
+    if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
+        lightMove.x -= 1.0f;
+    }
+    if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
+        lightMove.x += 1.0f;
+    }
+    if (glfwGetKey(window, GLFW_KEY_PAGE_UP) == GLFW_PRESS) {
+        lightMove.y += 1.0f;
+    }
+    if (glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS) {
+        lightMove.y -= 1.0f;
+    }
+    if (lightMove != glm::vec3(0.0f)) {
+        SceneLight(SceneDescription::KEY_LIGHT).position += lightMove * cameraOffset;
+    }
+
     // Enable shutdown proceedure if user presses the Escape key
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
@@ -1043,14 +2138,122 @@ void ProcessInput(GLFWwindow* window) {
 
 // Destroy a mesh
 void DestroyMesh(GLMesh& mesh) {
-    glDeleteVertexArrays(1, &mesh.vao);
-    glDeleteBuffers(1, &mesh.vbos[0]);
-    glDeleteBuffers(1, &mesh.vbos[1]);
+    // Cached shapes are deleted by the cache once no mesh uses them
+    if (mesh.cachedShape) {
+        gGeometryCache.Release(mesh.shapeKey);
+        mesh.cachedShape = false;
+    }
+    else {
+        glDeleteVertexArrays(1, &mesh.vao);
+        // The scene's geometry batch deletes its buffers once at shutdown
+        if (!mesh.batched) {
+            glDeleteBuffers(1, &mesh.vbos[0]);
+            glDeleteBuffers(1, &mesh.vbos[1]);
+        }
+    }
+    if (mesh.lightmapVao) {
+        glDeleteVertexArrays(1, &mesh.lightmapVao);
+        glDeleteBuffers(1, &mesh.lightmapVbo);
+    }
 }
 
 // Destroy the shader program
 void DestroyShaderProgram(GLuint programId) {
     glDeleteProgram(programId);
+
+    // Stop using its stages so stages no program needs anymore are deleted
+    std::map<GLuint, ProgramStages>::iterator stages = gProgramStages.find(programId);
+    if (stages != gProgramStages.end()) {
+        gShaderStages.Release(stages->second.vertexShader);
+        gShaderStages.Release(stages->second.fragmentShader);
+        gProgramStages.erase(stages);
+    }
+}
+
+// Read every shader file and start watching them for changes
+bool LoadShaderFiles() {
+    vector<string> files;
+    files.push_back(OBJECT_VERTEX_SHADER);
+    files.push_back(OBJECT_FRAGMENT_SHADER);
+    files.push_back(FRAME_DATA_SHADER);
+    for (unsigned int i = 0; i < sizeof(gShaderFilePrograms) / sizeof(gShaderFilePrograms[0]); i++) {
+        files.push_back(gShaderFilePrograms[i].vertexFile);
+        files.push_back(gShaderFilePrograms[i].fragmentFile);
+    }
+    gShaderWatcher.Start(SHADER_DIRECTORY, files);
+    for (unsigned int i = 0; i < files.size(); i++) {
+        if (!ReadShaderFile(gShaderWatcher.Path(files.at(i)), gShaderSources[files.at(i)])) {
+            cerr << "Failed to read shader " << gShaderWatcher.Path(files.at(i)) << endl;
+            return false;
+        }
+    }
+    SetObjectShaderSources();
+    return true;
+}
+
+// Source of a shader file with the FrameData block placed after its #version line, or at the top if it has none
+string ShaderSource(const string& file) {
+    const string& source = gShaderSources[file];
+    size_t start = 0;
+    if (source.compare(0, 8, "#version") == 0) {
+        start = source.find('\n');
+        start = start == string::npos ? source.size() : start + 1;
+    }
+    return source.substr(0, start) + (start > 0 && source[start - 1] != '\n' ? "\n" : "") + gShaderSources[FRAME_DATA_SHADER] + "\n" + source.substr(start);
+}
+
+// Give the object shader variants the current sources. Returns false if any variant fails with them
+bool SetObjectShaderSources() {
+    return gObjectShaders.SetSources(ShaderSource(OBJECT_VERTEX_SHADER), ShaderSource(OBJECT_FRAGMENT_SHADER));
+}
+
+// Relink the programs that use any shader file saved since the last frame. A program that fails to build keeps its old version
+void ReloadChangedShaders() {
+    AllocationScope shaderAllocations(ALLOC_SHADERS);
+    vector<string> changed = gShaderWatcher.Poll();
+    for (unsigned int i = 0; i < changed.size(); i++) {
+        const string& file = changed.at(i);
+        string source;
+        // Skip saves that did not change anything
+        if (!ReadShaderFile(gShaderWatcher.Path(file), source) || source == gShaderSources[file]) {
+            continue;
+        }
+        gShaderSources[file] = source;
+        MarkDirty();
+
+        // Object shader variants are rebuilt together. The FrameData block is in every program, so all of them are rebuilt when it changes
+        bool frameData = file == FRAME_DATA_SHADER;
+        if (frameData || file == OBJECT_VERTEX_SHADER || file == OBJECT_FRAGMENT_SHADER) {
+            bool reloaded = SetObjectShaderSources();
+            cout << (reloaded ? "Reloaded the object shaders for " : "Kept the previous object shaders after errors in ") << file << endl;
+            if (!frameData) {
+                continue;
+            }
+        }
+
+        // Only the changed stage compiles. The other stage is shared with the running program
+        for (unsigned int p = 0; p < sizeof(gShaderFilePrograms) / sizeof(gShaderFilePrograms[0]); p++) {
+            const ShaderFileProgram& files = gShaderFilePrograms[p];
+            if (!frameData && file != files.vertexFile && file != files.fragmentFile) {
+                continue;
+            }
+            GLuint program;
+            BeginShaderProgram(ShaderSource(files.vertexFile).c_str(), ShaderSource(files.fragmentFile).c_str(), program);
+            if (!FinishShaderProgram(program)) {
+                DestroyShaderProgram(program);
+                cout << "Kept the previous program after errors in " << file << endl;
+                continue;
+            }
+            DestroyShaderProgram(*files.program);
+            *files.program = program;
+            cout << "Reloaded " << file << endl;
+
+            // The shadow maps were drawn with the old shadow program
+            if (files.program == &gShadowProgram) {
+                gShadowMaps.Invalidate();
+            }
+        }
+    }
 }
 
 // Test resources. Input is a compiled vertex or fragment shader or a linked program. Resource is the type and can be VERTEX, FRAGMENT, or PROGRAM
@@ -1133,30 +2336,65 @@ void MousePositionCallback(GLFWwindow* window, double xpos, double ypos) {
 
     // Send mouse movement to camera controls
     camera.ProcessMouseMovement(xOffset, yOffset);
+    NoteActivity();
 }
 
 // This function enables reading of mouse scroll wheel movement
 void MouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
     // Send the scroll wheel movement to the camera controls
     camera.ProcessMouseScroll((float)yoffset);
+    NoteActivity();
 }
 
 // This function catches a press of the p key for perspective and ortho projection toggling and changing light colors
 // This callback was used because the normal key callback would repeat the keypress even with a short press of the key
 void KeyCallBack(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    NoteActivity();
+
     if (key == GLFW_KEY_P && action == GLFW_PRESS) {
         perspective = !perspective;
     }
 
+    // Toggle view frustum culling when C is pressed
+    if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+        frustumCulling = !frustumCulling;
+    }
+
+    // Toggle render on demand when R is pressed
+    if (key == GLFW_KEY_R && action == GLFW_PRESS) {
+        renderOnDemand = !renderOnDemand;
+    }
+
+    // Toggle vsync when V is pressed
+    if (key == GLFW_KEY_V && action == GLFW_PRESS) {
+        swapInterval = swapInterval ? 0 : 1;
+    }
+
+    // Toggle baked lighting when L is pressed
+    if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        bakedLighting = !bakedLighting;
+    }
+
+    // Toggle occlusion culling when O is pressed
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        occlusionCulling = !occlusionCulling;
+    }
+
+    // Toggle the profiler overlay when H is pressed
+    if (key == GLFW_KEY_H && action == GLFW_PRESS) {
+        showProfiler = !showProfiler;
+    }
+
     // Modify light 1's color when F1 is pressed
     if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
         static bool Light1Colored = false;
         Light1Colored = !Light1Colored;
+        LightComponent& light = SceneLight(SceneDescription::KEY_LIGHT);
         if (Light1Colored) {
-            gLight1Color = glm::vec3(0.754f, 0.471f, 0.104f);
+            light.color = glm::vec3(0.754f, 0.471f, 0.104f);
         }
         else {
-            gLight1Color = glm::vec3(1.0f, 1.0f, 0.941f);
+            light.color = light.sceneColor;
         }
     }
 
@@ -1164,15 +2402,36 @@ void KeyCallBack(GLFWwindow* window, int key, int scancode, int action, int mods
     if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
         static bool Light2Colored = false;
         Light2Colored = !Light2Colored;
+        LightComponent& light = SceneLight(SceneDescription::FILL_LIGHT);
         if (Light2Colored) {
-            gLight2Color = glm::vec3(0.254f, 0.471f, 0.104f);
+            light.color = glm::vec3(0.254f, 0.471f, 0.104f);
         }
         else {
-            gLight2Color = glm::vec3(1.0f, 1.0f, 0.778f);
+            light.color = light.sceneColor;
         }
     }
 }
 
+// Name the object in the center of the view when the left mouse button is clicked
+void MouseButtonCallback(GLFWwindow*, int button, int action, int) {
+    NoteActivity();
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) {
+        return;
+    }
+    // The render thread may be moving the light meshes
+    std::lock_guard<std::mutex> placement(gPlacementLock);
+    float distance;
+    int item = gSceneBvh.Raycast(camera.Position, camera.Front, distance,
+        [](int item, const glm::vec3& origin, const glm::vec3& direction, float& hitDistance) {
+            return RayHitsMesh(*gSceneObjects.at(item).mesh, gEntities.Transforms().Get(item).model, origin, direction, hitDistance);
+        });
+    if (item < 0) {
+        cout << "Nothing is in the center of the view." << endl;
+        return;
+    }
+    cout << "Looking at the " << gSceneObjects.at(item).name << " (part " << gSceneObjects.at(item).part << "), " << distance << " units away." << endl;
+}
+
 // Load textures
 void LoadTexture(GLuint& texture, string filename, GLuint textureNum) {
     // Create texture id
@@ -1207,49 +2466,66 @@ void LoadTexture(GLuint& texture, string filename, GLuint textureNum) {
     stbi_image_free(data);
 }
 
+// Delete the textures of the scene file
 void DestroyTextures() {
-    glGenTextures(1, &gFloor.texture);
-    glGenTextures(1, &gWallBottom.texture);
-    glGenTextures(1, &gWallTop.texture);
-    glGenTextures(1, &gEndTableSurfacesTexture);
-    glGenTextures(1, &gEndTableCylindersTexture);
-    glGenTextures(1, &gCoffeeTableTopTexture);
-    glGenTextures(1, &gCoffeeTableUnder);
-    glGenTextures(1, &gSoccerBall.texture);
-    glGenTextures(1, &gTrimTexture);
-    glGenTextures(1, &gCouchCushionTexture);
-    glGenTextures(1, &gLampTexture);
-    glGenTextures(1, &gLampShadeTexture);
+    if (!gSceneTextures.empty()) {
+        glDeleteTextures(gSceneTextures.size(), gSceneTextures.data());
+    }
+    gSceneTextures.clear();
 }
 
 // Create a shader program. Requires source for vertex and fragment shaders and the program id to update
-bool CreateShaderProgram(const char* VertexShaderSource, const char* FragmentShaderSource, GLuint& programId) {
+// Submit a program's shaders for compiling and linking without waiting for the results. FinishShaderProgram checks them
+bool BeginShaderProgram(const char* VertexShaderSource, const char* FragmentShaderSource, GLuint& programId) {
 
     // Create the shader program object
     programId = glCreateProgram();
 
-    // Create fragment and vertex shaders
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    // Use the binary saved by an earlier run if the driver still accepts it
+    if (gProgramCache.Load(VertexShaderSource, FragmentShaderSource, programId))
+        return true;
 
-    // Assign the shader sources to each shader
-    glShaderSource(vertexShader, 1, &VertexShaderSource, NULL);
-    glShaderSource(fragmentShader, 1, &FragmentShaderSource, NULL);
+    // Compile the vertex and fragment shaders, unless another program already compiled the same source
+    GLuint vertexShader = gShaderStages.Acquire(GL_VERTEX_SHADER, VertexShaderSource);
+    GLuint fragmentShader = gShaderStages.Acquire(GL_FRAGMENT_SHADER, FragmentShaderSource);
 
-    // Compile shaders and test for errors
-    glCompileShader(vertexShader);
-    if (!TestResource(vertexShader, VERTEX))
-        return false;
-    glCompileShader(fragmentShader);
-    if (!TestResource(fragmentShader, FRAGMENT))
-        return false;
-
-    // Attach compiled shaders to program
+    // Link. Nothing is queried here, so with KHR_parallel_shader_compile the driver keeps working in the background
     glAttachShader(programId, vertexShader);
     glAttachShader(programId, fragmentShader);
+    if (gProgramCache.Enabled())
+        glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(programId);
-    if (!TestResource(programId, PROGRAM))
+
+    gPendingPrograms.push_back({ programId, vertexShader, fragmentShader, VertexShaderSource, FragmentShaderSource });
+    return true;
+}
+
+// Wait for a program started with BeginShaderProgram and test it for errors. Programs that are already finished pass straight through
+bool FinishShaderProgram(GLuint programId) {
+    unsigned int index = 0;
+    while (index < gPendingPrograms.size() && gPendingPrograms.at(index).program != programId) {
+        index++;
+    }
+    if (index == gPendingPrograms.size()) {
+        return true;
+    }
+    PendingProgram pending = gPendingPrograms.at(index);
+    gPendingPrograms.erase(gPendingPrograms.begin() + index);
+
+    // Test the shaders first so a compile error is reported instead of the link error it causes
+    bool success = TestResource(pending.vertexShader, VERTEX) && TestResource(pending.fragmentShader, FRAGMENT) && TestResource(programId, PROGRAM);
+
+    // The linked program no longer needs its shaders attached. They are kept so a reload can reuse the unchanged stage
+    glDetachShader(programId, pending.vertexShader);
+    glDetachShader(programId, pending.fragmentShader);
+    if (!success) {
+        gShaderStages.Release(pending.vertexShader);
+        gShaderStages.Release(pending.fragmentShader);
         return false;
+    }
+    gProgramStages[programId] = { pending.vertexShader, pending.fragmentShader };
 
+    // Save the linked program so the next run can skip compiling
+    gProgramCache.Save(pending.vertexSource.c_str(), pending.fragmentSource.c_str(), programId);
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#pragma once
+/* RingBuffer.h : This file contains the code necessary to stream data
+ *      that changes every frame to the GPU. Uniforms, instance data, and
+ *		dynamic vertices are written straight into one persistently
+ *		mapped buffer instead of being uploaded with glBufferData.
+ *
+ *				The buffer is split into one region per frame in flight.
+ *				Each frame sub-allocates from its own region while the GPU
+ *				may still be reading the regions of the frames before it.
+ *				A fence is placed at the end of every frame, and a region
+ *				is only reused once the fence of the frame that last
+ *				wrote it has signaled, so nothing waits on the driver
+ *				unless the GPU falls a whole ring behind.
+ *
+ *				Drivers without buffer storage, or that refuse to map it,
+ *				get a plain buffer instead. Allocations are then written
+ *				to a staging region in client memory, and Commit sends each
+ *				one with glBufferSubData before the draw that reads it.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdlib>
+
+// Space handed out by RingBuffer::Allocate for the current frame
+struct RingAllocation {
+	void* data;					// Where to write the data, NULL if the frame's region is full
+	GLintptr offset;			// Offset of the data within RingBuffer::Buffer()
+	GLsizeiptr size;			// Bytes allocated
+};
+
+/* This class owns a persistently mapped buffer that is sub-allocated one frame at a time
+*/
+class RingBuffer {
+private:
+	static const unsigned int NUM_FRAMES = 3;	// Regions in the ring, one per frame the GPU may still be reading
+	static const GLsizeiptr REGION_ALIGNMENT = 256;	// Largest offset alignment OpenGL allows for uniform and storage buffers
+	GLuint buffer;							// Buffer holding every region
+	char* mapped;							// Start of the buffer in client memory, NULL if it could not be mapped
+	char* staging;							// Region written in place of the buffer when it is not mapped
+	GLsizeiptr frameSize;					// Bytes in each region
+	GLsync fences[NUM_FRAMES];				// Signaled when the GPU is done with the frame that last used each region
+	unsigned int frame;						// Region used by the current frame
+	GLsizeiptr used;						// Bytes allocated from the current region so far
+	bool frameStarted;						// True between BeginFrame and EndFrame
+
+public:
+	// Constructor
+	RingBuffer();
+	// Create and map a buffer with room for frameSize bytes per frame. Needs a current context. Returns false if it falls back to glBufferSubData
+	bool Create(GLsizeiptr frameSize);
+	// Unmap and delete the buffer
+	void Destroy();
+	// Start a frame, waiting for the GPU if it is still reading this frame's region
+	void BeginFrame();
+	// Space for size bytes starting at a multiple of alignment. The data pointer is NULL if the region is full
+	RingAllocation Allocate(GLsizeiptr size, GLsizeiptr alignment);
+	// Send an allocation's data to the buffer after writing it. Only does work when the buffer is not mapped
+	void Commit(const RingAllocation& allocation);
+	// End the frame after the last draw that reads its allocations
+	void EndFrame();
+	// Buffer to bind allocations from
+	GLuint Buffer() const;
+	// Bytes allocated so far this frame
+	GLsizeiptr Used() const;
+};
+
+// Constructor
+RingBuffer::RingBuffer() {
+	buffer = 0;
+	mapped = NULL;
+	staging = NULL;
+	frameSize = 0;
+	frame = 0;
+	used = 0;
+	frameStarted = false;
+	for (unsigned int i = 0; i < NUM_FRAMES; i++) {
+		fences[i] = 0;
+	}
+}
+
+// Create and map a buffer with room for frameSize bytes per frame
+bool RingBuffer::Create(GLsizeiptr frameSize) {
+	// Round the regions up so each one starts at an offset every binding alignment accepts
+	this->frameSize = (frameSize + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+
+	// Persistent buffers can be bound to any target, so the target used here does not limit their use
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+		glBufferStorage(GL_COPY_WRITE_BUFFER, this->frameSize * NUM_FRAMES, NULL, flags);
+		mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, this->frameSize * NUM_FRAMES, flags);
+	}
+	if (mapped) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		return true;
+	}
+
+	// Storage cannot be given a second size, so the fallback needs a new buffer
+	glDeleteBuffers(1, &buffer);
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, this->frameSize * NUM_FRAMES, NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	staging = (char*)malloc(this->frameSize);
+	return false;
+}
+
+// Unmap and delete the buffer
+void RingBuffer::Destroy() {
+	for (unsigned int i = 0; i < NUM_FRAMES; i++) {
+		if (fences[i]) {
+			glDeleteSync(fences[i]);
+			fences[i] = 0;
+		}
+	}
+	if (buffer) {
+		if (mapped) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+	mapped = NULL;
+	free(staging);
+	staging = NULL;
+}
+
+// Start a frame, waiting for the GPU if it is still reading this frame's region
+void RingBuffer::BeginFrame() {
+	if (fences[frame]) {
+		while (glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+		}
+		glDeleteSync(fences[frame]);
+		fences[frame] = 0;
+	}
+	used = 0;
+	frameStarted = true;
+}
+
+// Space for size bytes starting at a multiple of alignment
+RingAllocation RingBuffer::Allocate(GLsizeiptr size, GLsizeiptr alignment) {
+	RingAllocation allocation = { NULL, 0, size };
+	GLsizeiptr start = (used + alignment - 1) / alignment * alignment;
+	if ((!mapped && !staging) || !frameStarted || start + size > frameSize) {
+		return allocation;
+	}
+	used = start + size;
+	allocation.offset = frameSize * frame + start;
+	allocation.data = mapped ? mapped + allocation.offset : staging + start;
+	return allocation;
+}
+
+// Send an allocation's data to the buffer after writing it
+void RingBuffer::Commit(const RingAllocation& allocation) {
+	if (mapped || !allocation.data) {
+		return;
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset, allocation.size, allocation.data);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// End the frame after the last draw that reads its allocations
+void RingBuffer::EndFrame() {
+	if (!frameStarted) {
+		return;
+	}
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame = (frame + 1) % NUM_FRAMES;
+	frameStarted = false;
+}
+
+// Buffer to bind allocations from
+GLuint RingBuffer::Buffer() const {
+	return buffer;
+}
+
+// Bytes allocated so far this frame
+GLsizeiptr RingBuffer::Used() const {
+	return used;
+}
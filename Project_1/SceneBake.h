@@ -0,0 +1,447 @@
+#pragma once
+/* SceneBake.h : This file contains the code necessary to save a built
+ *      scene in a binary file and to use it on later runs instead of the
+ *		scene file. The bake holds the final interleaved vertices and
+ *		indices of every shape, a record per part with its shape,
+ *		texture, material, and model matrix, the bounds of each shape,
+ *		and the lights, so loading it needs no parsing and no shape
+ *		generation.
+ *
+ *				The file is mapped into memory and its arrays are used in
+ *				place. Vertices and indices go from the mapping straight
+ *				into vertex buffers. Every section has a fixed size worked
+ *				out from the counts in the header, so opening a bake only
+ *				checks that the counts and ranges fit the file.
+ *
+ *				A bake stores the size and modification time of the scene
+ *				file it was made from and is ignored once they change.
+ *				Numbers are stored in the byte order of the machine that
+ *				wrote them.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include "GeometryCache.h"
+#include "MappedFile.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Start of a bake file
+struct BakedHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceStamp;			// Size and modification time of the scene file
+	uint32_t textureCount;
+	uint32_t objectCount;
+	uint32_t shapeCount;
+	uint32_t partCount;
+	uint32_t vertexFloatCount;		// Floats in the vertex section, eight per vertex
+	uint32_t indexCount;
+	uint32_t stringBytes;
+	uint32_t reserved;
+};
+
+// Text kept in the string section
+struct BakedString {
+	uint32_t offset;
+	uint32_t length;
+};
+
+// Vertices and indices of one shape
+struct BakedShape {
+	uint32_t cached;				// 1 if the geometry cache owns the shape, 0 if the part gets its own buffers
+	uint32_t type;					// ShapeKey of cached shapes
+	float size[3];
+	int32_t detail[2];
+	float tiles[3];
+	uint32_t firstVertexFloat;		// Range of the shape in the vertex section
+	uint32_t vertexFloatCount;
+	uint32_t firstIndex;			// Range of the shape in the index section
+	uint32_t indexCount;
+	float boundsMin[3];				// Bounds of the vertices
+	float boundsMax[3];
+
+	// Geometry cache key of the shape
+	ShapeKey Key() const;
+	// Bounds of the vertices
+	AABB Bounds() const;
+};
+
+// A named group of parts
+struct BakedObject {
+	BakedString name;
+	uint32_t firstPart;
+	uint32_t partCount;
+	float transform[16];			// Model matrix of the object line
+};
+
+// Flags of a part
+enum BakedPartFlags { BAKED_CASTS_SHADOW = 1, BAKED_INSTANCED = 2 };
+
+// One mesh of an object
+struct BakedPart {
+	uint32_t shape;					// Index of the shape
+	int32_t texture;				// Index of the texture, -1 for none
+	uint32_t material;				// Shader features
+	uint32_t flags;					// BakedPartFlags
+	float origin[3];				// Where a cached shape is moved to before the placement
+	float placement[16];			// Model matrix from the scene file
+};
+
+// A light and its mesh
+struct BakedLight {
+	uint32_t defined;
+	uint32_t shape;
+	uint32_t hasTarget;
+	float position[3];
+	float color[3];
+	float intensity;
+	float target[3];
+	float placement[16];			// Rotation and scale of the mesh. The position is applied when it is placed
+};
+
+/* This class writes bake files and reads them through a memory mapping
+*/
+class SceneBake {
+private:
+	static const uint32_t FILE_MAGIC = 0x424E4353;	// "SCNB", marks a bake written by this class
+	static const uint32_t FILE_VERSION = 4;			// Changes whenever the layout, the shape generators, or the materials given to parts change
+
+	// Mapped file and its sections, valid while the bake is open
+	MappedFile file;
+	const BakedHeader* header;
+	const BakedString* textures;
+	const BakedObject* objects;
+	const BakedShape* shapes;
+	const BakedPart* parts;
+	const BakedLight* lights;
+	const float* vertices;
+	const uint16_t* indices;
+	const char* strings;
+
+	// Contents of a bake being built
+	std::vector<BakedString> newTextures;
+	std::vector<BakedObject> newObjects;
+	std::vector<BakedShape> newShapes;
+	std::vector<BakedPart> newParts;
+	BakedLight newLights[2];
+	std::vector<float> newVertices;
+	std::vector<uint16_t> newIndices;
+	std::string newStrings;
+
+	// Append text to the string section being built
+	BakedString AddString(const std::string& text);
+	// Bytes a bake with the counts in header needs. Sets the offset of each section
+	static size_t Layout(const BakedHeader& header, size_t offsets[9]);
+
+public:
+	// Constructor
+	SceneBake();
+	// Size and modification time of a file folded together, 0 if it does not exist
+	static uint64_t SourceStamp(const std::string& path);
+
+	// Map a bake. Returns false if it is missing, damaged, from another version, or made from a different scene file
+	bool Open(const std::string& path, uint64_t sourceStamp);
+	// Unmap the bake
+	void Close();
+
+	// Contents of the open bake
+	unsigned int TextureCount() const;
+	std::string TextureFile(unsigned int texture) const;
+	unsigned int ObjectCount() const;
+	const BakedObject& Object(unsigned int object) const;
+	std::string ObjectName(unsigned int object) const;
+	unsigned int PartCount() const;
+	const BakedPart& Part(unsigned int part) const;
+	const BakedShape& Shape(unsigned int shape) const;
+	const BakedLight& Light(unsigned int light) const;
+	// Vertices and indices of a shape within the mapping
+	const float* ShapeVertices(const BakedShape& shape) const;
+	const uint16_t* ShapeIndices(const BakedShape& shape) const;
+
+	// Add to the bake being built. Textures, objects, and shapes are numbered in the order they are added
+	unsigned int AddTexture(const std::string& file);
+	// Start an object. Parts added after it belong to it
+	void AddObject(const std::string& name, const glm::mat4& transform);
+	// Add a shape. key is NULL for shapes the geometry cache does not own
+	unsigned int AddShape(const ShapeKey* key, const std::vector<float>& shapeVertices, const std::vector<uint16_t>& shapeIndices, const AABB& bounds);
+	void AddPart(const BakedPart& part);
+	void SetLight(unsigned int light, const BakedLight& value);
+	// Write the bake being built. Returns false if the file cannot be written
+	bool Save(const std::string& path, uint64_t sourceStamp);
+};
+
+// Geometry cache key of the shape
+ShapeKey BakedShape::Key() const {
+	ShapeKey key = { (ShapeType)type, { size[0], size[1], size[2] }, { detail[0], detail[1] }, { tiles[0], tiles[1], tiles[2] } };
+	return key;
+}
+
+// Bounds of the vertices
+AABB BakedShape::Bounds() const {
+	AABB bounds;
+	bounds.min = glm::vec3(boundsMin[0], boundsMin[1], boundsMin[2]);
+	bounds.max = glm::vec3(boundsMax[0], boundsMax[1], boundsMax[2]);
+	return bounds;
+}
+
+// Constructor
+SceneBake::SceneBake() {
+	Close();
+	memset(newLights, 0, sizeof(newLights));
+}
+
+// Size and modification time of a file folded together
+uint64_t SceneBake::SourceStamp(const std::string& path) {
+	struct stat status;
+	if (stat(path.c_str(), &status) != 0) {
+		return 0;
+	}
+	return ((uint64_t)status.st_mtime << 24) ^ (uint64_t)status.st_size;
+}
+
+// Bytes a bake with the counts in header needs
+size_t SceneBake::Layout(const BakedHeader& header, size_t offsets[9]) {
+	// Every section before the vertices is a multiple of four bytes long, so the floats stay aligned
+	size_t size = sizeof(BakedHeader);
+	offsets[0] = size;
+	size += header.textureCount * sizeof(BakedString);
+	offsets[1] = size;
+	size += header.objectCount * sizeof(BakedObject);
+	offsets[2] = size;
+	size += header.shapeCount * sizeof(BakedShape);
+	offsets[3] = size;
+	size += header.partCount * sizeof(BakedPart);
+	offsets[4] = size;
+	size += 2 * sizeof(BakedLight);
+	offsets[5] = size;
+	size += header.vertexFloatCount * sizeof(float);
+	offsets[6] = size;
+	size += header.indexCount * sizeof(uint16_t);
+	offsets[7] = size;
+	size += header.stringBytes;
+	offsets[8] = size;
+	return size;
+}
+
+// Map a bake
+bool SceneBake::Open(const std::string& path, uint64_t sourceStamp) {
+	Close();
+	if (!file.Open(path) || file.Size() < sizeof(BakedHeader)) {
+		Close();
+		return false;
+	}
+	const BakedHeader* mapped = (const BakedHeader*)file.Data();
+	size_t offsets[9];
+	if (mapped->magic != FILE_MAGIC || mapped->version != FILE_VERSION || mapped->sourceStamp != sourceStamp
+		|| Layout(*mapped, offsets) != file.Size()) {
+		Close();
+		return false;
+	}
+	const char* data = file.Data();
+	header = mapped;
+	textures = (const BakedString*)(data + offsets[0]);
+	objects = (const BakedObject*)(data + offsets[1]);
+	shapes = (const BakedShape*)(data + offsets[2]);
+	parts = (const BakedPart*)(data + offsets[3]);
+	lights = (const BakedLight*)(data + offsets[4]);
+	vertices = (const float*)(data + offsets[5]);
+	indices = (const uint16_t*)(data + offsets[6]);
+	strings = data + offsets[7];
+
+	// Check every range once here so the accessors can trust them
+	bool valid = true;
+	for (uint32_t i = 0; i < header->textureCount && valid; i++) {
+		valid = textures[i].offset <= header->stringBytes && textures[i].length <= header->stringBytes - textures[i].offset;
+	}
+	for (uint32_t i = 0; i < header->objectCount && valid; i++) {
+		valid = objects[i].name.offset <= header->stringBytes && objects[i].name.length <= header->stringBytes - objects[i].name.offset
+			&& objects[i].firstPart <= header->partCount && objects[i].partCount <= header->partCount - objects[i].firstPart;
+	}
+	for (uint32_t i = 0; i < header->shapeCount && valid; i++) {
+		const BakedShape& shape = shapes[i];
+		valid = shape.firstVertexFloat <= header->vertexFloatCount && shape.vertexFloatCount <= header->vertexFloatCount - shape.firstVertexFloat
+			&& shape.firstIndex <= header->indexCount && shape.indexCount <= header->indexCount - shape.firstIndex;
+	}
+	for (uint32_t i = 0; i < header->partCount && valid; i++) {
+		valid = parts[i].shape < header->shapeCount && parts[i].texture < (int32_t)header->textureCount;
+	}
+	for (uint32_t i = 0; i < 2 && valid; i++) {
+		valid = !lights[i].defined || lights[i].shape < header->shapeCount;
+	}
+	if (!valid) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+// Unmap the bake
+void SceneBake::Close() {
+	file.Close();
+	header = NULL;
+	textures = NULL;
+	objects = NULL;
+	shapes = NULL;
+	parts = NULL;
+	lights = NULL;
+	vertices = NULL;
+	indices = NULL;
+	strings = NULL;
+}
+
+// Contents of the open bake
+unsigned int SceneBake::TextureCount() const {
+	return header ? header->textureCount : 0;
+}
+
+std::string SceneBake::TextureFile(unsigned int texture) const {
+	return std::string(strings + textures[texture].offset, textures[texture].length);
+}
+
+unsigned int SceneBake::ObjectCount() const {
+	return header ? header->objectCount : 0;
+}
+
+const BakedObject& SceneBake::Object(unsigned int object) const {
+	return objects[object];
+}
+
+std::string SceneBake::ObjectName(unsigned int object) const {
+	return std::string(strings + objects[object].name.offset, objects[object].name.length);
+}
+
+unsigned int SceneBake::PartCount() const {
+	return header ? header->partCount : 0;
+}
+
+const BakedPart& SceneBake::Part(unsigned int part) const {
+	return parts[part];
+}
+
+const BakedShape& SceneBake::Shape(unsigned int shape) const {
+	return shapes[shape];
+}
+
+const BakedLight& SceneBake::Light(unsigned int light) const {
+	return lights[light];
+}
+
+// Vertices and indices of a shape within the mapping
+const float* SceneBake::ShapeVertices(const BakedShape& shape) const {
+	return vertices + shape.firstVertexFloat;
+}
+
+const uint16_t* SceneBake::ShapeIndices(const BakedShape& shape) const {
+	return indices + shape.firstIndex;
+}
+
+// Append text to the string section being built
+BakedString SceneBake::AddString(const std::string& text) {
+	BakedString result = { (uint32_t)newStrings.size(), (uint32_t)text.size() };
+	newStrings += text;
+	return result;
+}
+
+// Add a texture to the bake being built
+unsigned int SceneBake::AddTexture(const std::string& file) {
+	newTextures.push_back(AddString(file));
+	return newTextures.size() - 1;
+}
+
+// Start an object
+void SceneBake::AddObject(const std::string& name, const glm::mat4& transform) {
+	BakedObject object;
+	object.name = AddString(name);
+	object.firstPart = newParts.size();
+	object.partCount = 0;
+	memcpy(object.transform, glm::value_ptr(transform), sizeof(object.transform));
+	newObjects.push_back(object);
+}
+
+// Add a shape
+unsigned int SceneBake::AddShape(const ShapeKey* key, const std::vector<float>& shapeVertices, const std::vector<uint16_t>& shapeIndices, const AABB& bounds) {
+	BakedShape shape;
+	memset(&shape, 0, sizeof(shape));
+	if (key) {
+		shape.cached = 1;
+		shape.type = key->type;
+		memcpy(shape.size, key->size, sizeof(shape.size));
+		memcpy(shape.detail, key->detail, sizeof(shape.detail));
+		memcpy(shape.tiles, key->tiles, sizeof(shape.tiles));
+	}
+	shape.firstVertexFloat = newVertices.size();
+	shape.vertexFloatCount = shapeVertices.size();
+	shape.firstIndex = newIndices.size();
+	shape.indexCount = shapeIndices.size();
+	memcpy(shape.boundsMin, glm::value_ptr(bounds.min), sizeof(shape.boundsMin));
+	memcpy(shape.boundsMax, glm::value_ptr(bounds.max), sizeof(shape.boundsMax));
+	newVertices.insert(newVertices.end(), shapeVertices.begin(), shapeVertices.end());
+	newIndices.insert(newIndices.end(), shapeIndices.begin(), shapeIndices.end());
+	newShapes.push_back(shape);
+	return newShapes.size() - 1;
+}
+
+// Add a part to the current object
+void SceneBake::AddPart(const BakedPart& part) {
+	newParts.push_back(part);
+	if (!newObjects.empty()) {
+		newObjects.back().partCount++;
+	}
+}
+
+// Set one of the two lights
+void SceneBake::SetLight(unsigned int light, const BakedLight& value) {
+	newLights[light] = value;
+}
+
+// Write the bake being built
+bool SceneBake::Save(const std::string& path, uint64_t sourceStamp) {
+	BakedHeader newHeader;
+	memset(&newHeader, 0, sizeof(newHeader));
+	newHeader.magic = FILE_MAGIC;
+	newHeader.version = FILE_VERSION;
+	newHeader.sourceStamp = sourceStamp;
+	newHeader.textureCount = newTextures.size();
+	newHeader.objectCount = newObjects.size();
+	newHeader.shapeCount = newShapes.size();
+	newHeader.partCount = newParts.size();
+	newHeader.vertexFloatCount = newVertices.size();
+	newHeader.indexCount = newIndices.size();
+	newHeader.stringBytes = newStrings.size();
+
+	// Write to a temporary file first so a run that stops part way never leaves a bake that looks complete
+	std::string temporary = path + ".tmp";
+	FILE* output = fopen(temporary.c_str(), "wb");
+	if (!output) {
+		return false;
+	}
+	bool written = fwrite(&newHeader, sizeof(newHeader), 1, output) == 1
+		&& fwrite(newTextures.data(), sizeof(BakedString), newTextures.size(), output) == newTextures.size()
+		&& fwrite(newObjects.data(), sizeof(BakedObject), newObjects.size(), output) == newObjects.size()
+		&& fwrite(newShapes.data(), sizeof(BakedShape), newShapes.size(), output) == newShapes.size()
+		&& fwrite(newParts.data(), sizeof(BakedPart), newParts.size(), output) == newParts.size()
+		&& fwrite(newLights, sizeof(BakedLight), 2, output) == 2
+		&& fwrite(newVertices.data(), sizeof(float), newVertices.size(), output) == newVertices.size()
+		&& fwrite(newIndices.data(), sizeof(uint16_t), newIndices.size(), output) == newIndices.size()
+		&& fwrite(newStrings.data(), 1, newStrings.size(), output) == newStrings.size();
+	written = fclose(output) == 0 && written;
+	if (!written) {
+		remove(temporary.c_str());
+		return false;
+	}
+	remove(path.c_str());
+	return rename(temporary.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,654 @@
+#pragma once
+/* SceneFile.h : This file contains the code necessary to read a room
+ *      from a scene file instead of building it in code. A scene file
+ *		lists the textures, the two lights, and the objects of a room,
+ *		each object made of primitive shapes, so a new room only needs
+ *		a new file.
+ *
+ *				The file is read into memory with one call and parsed in a
+ *				single pass. Words are found in place and numbers are
+ *				converted straight from the buffer, so parsing does not
+ *				copy the text apart from names.
+ *
+ *				One statement per line. Everything after # is a comment,
+ *				and names containing spaces go in double quotes.
+ *
+ *				texture <name> <image file>
+ *				light key|fill <shape> [options] position <x y z> color <r g b> intensity <i> [target <x y z>]
+ *				object <name> [options]
+ *					<shape> [options]
+ *				end
+ *
+ *				Shapes:
+ *				sphere <radius> <rings> <sectors>
+ *				halfsphere <radius> <rings> <sectors>
+ *				cuboid <length> <width> <height>
+ *				cylinder <height> <radius> none|top|bottom|both
+ *				plane <length> <width>
+ *				Sizes must be positive. Spheres need at least 2 rings and
+ *				3 sectors, and no more than 65536 rings times sectors.
+ *				Numbers are plain decimals, so nan, inf, and hex are refused.
+ *
+ *				Options. Parts take the texture, transform, and flags of
+ *				their object for anything they leave out:
+ *				at <x y z>						where the shape is built
+ *				tiles <sides> <front and back> <top and bottom>	texture repeats of a cuboid
+ *				texture <name>
+ *				translate <x y z>
+ *				rotate <radians> <axis x y z>
+ *				scale <x y z>
+ *				matte							no specular highlight
+ *				noshadow						left out of the shadow maps and not shadowed
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include "Cylinder.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Kinds of shape a scene file part can be
+enum ScenePrimitive { PRIMITIVE_SPHERE, PRIMITIVE_HALF_SPHERE, PRIMITIVE_CUBOID, PRIMITIVE_CYLINDER, PRIMITIVE_PLANE };
+
+// Translation, rotation, and scale of an object or a part
+struct SceneTransform {
+	glm::vec3 translation;
+	float angle;					// Rotation in radians
+	glm::vec3 axis;					// Axis of the rotation
+	glm::vec3 scale;
+	bool hasTranslation;			// Set when the file gave a value. A part uses its object's value otherwise
+	bool hasRotation;
+	bool hasScale;
+
+	// Constructor
+	SceneTransform();
+	// Copy of this transform with anything it leaves out taken from parent
+	SceneTransform Inherit(const SceneTransform& parent) const;
+	// Model matrix, scaling first, then rotating, then translating
+	glm::mat4 Matrix() const;
+};
+
+// One primitive shape of an object
+struct ScenePart {
+	ScenePrimitive primitive;
+	float size[3];					// Radius of spheres, length, width, and height of cuboids, height and radius of cylinders, length and width of planes
+	int rings;						// Rings and sectors of spheres
+	int sectors;
+	CylinderType caps;				// Ends a cylinder is closed at
+	float tiles[3];					// Texture repeats on the sides, front and back, and top and bottom of a cuboid
+	glm::vec3 origin;				// Where the shape is built before the transform is applied
+	int texture;					// Index into SceneDescription::textures, -1 for none
+	bool matte;						// True if the part has no specular highlight
+	bool castsShadow;				// True if the part is drawn into the shadow maps
+	SceneTransform transform;		// Complete once the part is read, with the object's values filled in
+
+	// Constructor
+	ScenePart();
+};
+
+// A named group of parts, such as a table
+struct SceneObjectDescription {
+	std::string name;
+	SceneTransform transform;		// Transform given on the object line
+	std::vector<ScenePart> parts;
+};
+
+// An image file and the name parts use for it
+struct SceneTextureDescription {
+	std::string name;
+	std::string file;
+};
+
+// A light and the mesh that shows where it is
+struct SceneLightDescription {
+	bool defined;					// True if the file has this light
+	ScenePart shape;				// Mesh of the light. Its translation is the light position
+	glm::vec3 color;
+	float intensity;
+	glm::vec3 target;				// Point the light's shadow map is aimed at
+	bool hasTarget;
+};
+
+// Everything read from a scene file
+struct SceneDescription {
+	static const int KEY_LIGHT = 0;
+	static const int FILL_LIGHT = 1;
+
+	std::vector<SceneTextureDescription> textures;
+	std::vector<SceneObjectDescription> objects;
+	SceneLightDescription lights[2];
+
+	// Constructor
+	SceneDescription();
+	// Parts in every object
+	unsigned int PartCount() const;
+};
+
+/* This class parses scene files into a SceneDescription
+*/
+class SceneFile {
+private:
+	// Word of the file being parsed, pointing into the buffer
+	struct Word {
+		const char* text;
+		size_t length;
+	};
+
+	static const int MAX_SPHERE_VERTICES = 65536;	// Vertices 16 bit indices can reach
+
+	// What the options being read belong to
+	enum OptionTarget { OPTIONS_OBJECT, OPTIONS_PART, OPTIONS_LIGHT };
+
+	const char* cursor;				// Next character to parse
+	const char* end;				// End of the buffer
+	int line;						// Line of the cursor, counted from 1
+	std::string path;				// File name used in errors
+	std::string error;				// Description of the first error
+
+	// Next word on the current line. Returns false at the end of the line
+	bool NextWord(Word& word);
+	// Move to the start of the next line. Returns false without moving if there are words left on the current one
+	bool EndLine();
+	// Record an error at the current line. Always returns false
+	bool Fail(const std::string& message);
+	// Read the next word as a number
+	bool ReadFloat(float& value);
+	bool ReadInt(int& value);
+	bool ReadVec3(glm::vec3& value);
+	// Read the next word as a shape dimension, which must be positive
+	bool ReadSize(float& value);
+	// Read the next word as a name
+	bool ReadName(std::string& name);
+	// Read a shape and its dimensions
+	bool ReadShape(const Word& word, ScenePart& part);
+	// Read options until the end of the line
+	bool ReadOptions(ScenePart& part, OptionTarget target, SceneDescription& scene, SceneLightDescription* light);
+
+	// True if a word is the given text
+	static bool Is(const Word& word, const char* text);
+	// Index of the texture with a name, -1 if the scene has none by that name
+	static int FindTexture(const SceneDescription& scene, const std::string& name);
+
+public:
+	// Constructor
+	SceneFile();
+	// Read and parse a scene file. Returns false and sets the error if the file cannot be read or is not valid
+	bool Load(const std::string& path, SceneDescription& scene);
+	// Parse scene text. The text must be followed by a terminating null
+	bool Parse(const char* text, size_t length, SceneDescription& scene);
+	// Description of the error that stopped the last Load or Parse
+	const std::string& Error() const;
+};
+
+// Constructor
+SceneTransform::SceneTransform() {
+	translation = glm::vec3(0.0f);
+	angle = 0.0f;
+	axis = glm::vec3(0.0f, 1.0f, 0.0f);
+	scale = glm::vec3(1.0f);
+	hasTranslation = false;
+	hasRotation = false;
+	hasScale = false;
+}
+
+// Copy of this transform with anything it leaves out taken from parent
+SceneTransform SceneTransform::Inherit(const SceneTransform& parent) const {
+	SceneTransform result = *this;
+	if (!hasTranslation) {
+		result.translation = parent.translation;
+		result.hasTranslation = parent.hasTranslation;
+	}
+	if (!hasRotation) {
+		result.angle = parent.angle;
+		result.axis = parent.axis;
+		result.hasRotation = parent.hasRotation;
+	}
+	if (!hasScale) {
+		result.scale = parent.scale;
+		result.hasScale = parent.hasScale;
+	}
+	return result;
+}
+
+// Model matrix, scaling first, then rotating, then translating
+glm::mat4 SceneTransform::Matrix() const {
+	return glm::translate(translation) * glm::rotate(angle, axis) * glm::scale(scale);
+}
+
+// Constructor
+ScenePart::ScenePart() {
+	primitive = PRIMITIVE_SPHERE;
+	size[0] = size[1] = size[2] = 0.0f;
+	rings = 0;
+	sectors = 0;
+	caps = NONE;
+	tiles[0] = tiles[1] = tiles[2] = 1.0f;
+	origin = glm::vec3(0.0f);
+	texture = -1;
+	matte = false;
+	castsShadow = true;
+}
+
+// Constructor
+SceneDescription::SceneDescription() {
+	for (int i = 0; i < 2; i++) {
+		lights[i].defined = false;
+		lights[i].color = glm::vec3(1.0f);
+		lights[i].intensity = 0.0f;
+		lights[i].target = glm::vec3(0.0f);
+		lights[i].hasTarget = false;
+	}
+}
+
+// Parts in every object
+unsigned int SceneDescription::PartCount() const {
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < objects.size(); i++) {
+		count += objects[i].parts.size();
+	}
+	return count;
+}
+
+// Constructor
+SceneFile::SceneFile() {
+	cursor = NULL;
+	end = NULL;
+	line = 0;
+}
+
+// Read and parse a scene file
+bool SceneFile::Load(const std::string& path, SceneDescription& scene) {
+	this->path = path;
+	line = 0;
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		return Fail("cannot open the file");
+	}
+	// Read the whole file at once. The string keeps a null after the text for strtof to stop at
+	std::string text;
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (length > 0) {
+		text.resize(length);
+		length = (long)fread(&text[0], 1, length, file);
+		text.resize(length);
+	}
+	fclose(file);
+	return Parse(text.c_str(), text.size(), scene);
+}
+
+// Parse scene text
+bool SceneFile::Parse(const char* text, size_t length, SceneDescription& scene) {
+	cursor = text;
+	end = text + length;
+	line = 1;
+	error.clear();
+	if (path.empty()) {
+		path = "scene";
+	}
+
+	SceneObjectDescription* object = NULL;	// Object whose parts are being read
+	ScenePart objectDefaults;				// Texture, transform, and flags the object's parts start with
+	while (cursor < end) {
+		Word word;
+		if (!NextWord(word)) {
+			EndLine();
+			continue;
+		}
+
+		if (Is(word, "texture")) {
+			SceneTextureDescription texture;
+			if (!ReadName(texture.name) || !ReadName(texture.file)) {
+				return false;
+			}
+			if (FindTexture(scene, texture.name) >= 0) {
+				return Fail("texture " + texture.name + " is already defined");
+			}
+			scene.textures.push_back(texture);
+		}
+		else if (Is(word, "light")) {
+			Word which, shape;
+			if (!NextWord(which) || !(Is(which, "key") || Is(which, "fill"))) {
+				return Fail("expected key or fill after light");
+			}
+			SceneLightDescription& light = scene.lights[Is(which, "key") ? SceneDescription::KEY_LIGHT : SceneDescription::FILL_LIGHT];
+			light = SceneLightDescription();
+			light.color = glm::vec3(1.0f);
+			light.intensity = 0.0f;
+			light.hasTarget = false;
+			if (!NextWord(shape)) {
+				return Fail("expected the shape of the light");
+			}
+			if (!ReadShape(shape, light.shape) || !ReadOptions(light.shape, OPTIONS_LIGHT, scene, &light)) {
+				return false;
+			}
+			if (!light.shape.transform.hasTranslation) {
+				return Fail("light needs a position");
+			}
+			// The light shines from inside its mesh, so the mesh must not shadow it
+			light.shape.castsShadow = false;
+			light.defined = true;
+		}
+		else if (Is(word, "object")) {
+			if (object) {
+				return Fail("object " + object->name + " is missing its end");
+			}
+			scene.objects.push_back(SceneObjectDescription());
+			object = &scene.objects.back();
+			objectDefaults = ScenePart();
+			if (!ReadName(object->name) || !ReadOptions(objectDefaults, OPTIONS_OBJECT, scene, NULL)) {
+				return false;
+			}
+			object->transform = objectDefaults.transform;
+		}
+		else if (Is(word, "end")) {
+			if (!object) {
+				return Fail("end without an object");
+			}
+			object = NULL;
+		}
+		else {
+			if (!object) {
+				return Fail("shapes must be inside an object");
+			}
+			ScenePart part;
+			part.texture = objectDefaults.texture;
+			part.matte = objectDefaults.matte;
+			part.castsShadow = objectDefaults.castsShadow;
+			if (!ReadShape(word, part) || !ReadOptions(part, OPTIONS_PART, scene, NULL)) {
+				return false;
+			}
+			part.transform = part.transform.Inherit(objectDefaults.transform);
+			object->parts.push_back(part);
+		}
+
+		if (!EndLine()) {
+			return Fail("unexpected words at the end of the line");
+		}
+	}
+	if (object) {
+		return Fail("object " + object->name + " is missing its end");
+	}
+	return true;
+}
+
+// Description of the error that stopped the last Load or Parse
+const std::string& SceneFile::Error() const {
+	return error;
+}
+
+// Next word on the current line
+bool SceneFile::NextWord(Word& word) {
+	while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) {
+		cursor++;
+	}
+	if (cursor >= end || *cursor == '\n' || *cursor == '#') {
+		return false;
+	}
+	// Quoted names run to the closing quote
+	if (*cursor == '"') {
+		const char* start = ++cursor;
+		while (cursor < end && *cursor != '"' && *cursor != '\n') {
+			cursor++;
+		}
+		word.text = start;
+		word.length = cursor - start;
+		if (cursor < end && *cursor == '"') {
+			cursor++;
+		}
+		return true;
+	}
+	word.text = cursor;
+	while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r' && *cursor != '\n' && *cursor != '#') {
+		cursor++;
+	}
+	word.length = cursor - word.text;
+	return true;
+}
+
+// Move past the end of the current line
+bool SceneFile::EndLine() {
+	Word word;
+	if (NextWord(word)) {
+		return false;
+	}
+	while (cursor < end && *cursor != '\n') {
+		cursor++;
+	}
+	if (cursor < end) {
+		cursor++;
+		line++;
+	}
+	return true;
+}
+
+// Record an error at the current line
+bool SceneFile::Fail(const std::string& message) {
+	error = path + ":" + std::to_string(line) + ": " + message;
+	return false;
+}
+
+// Read the next word as a number
+bool SceneFile::ReadFloat(float& value) {
+	Word word;
+	if (!NextWord(word)) {
+		return Fail("expected a number");
+	}
+	// An empty quoted word would otherwise parse as 0
+	if (word.length == 0) {
+		return Fail("expected a number, found an empty word");
+	}
+	// strtof also takes nan, inf, and hex, so only plain decimal characters are let through
+	for (size_t i = 0; i < word.length; i++) {
+		if (!strchr("0123456789+-.eE", word.text[i])) {
+			return Fail("expected a number, found " + std::string(word.text, word.length));
+		}
+	}
+	char* stop;
+	value = strtof(word.text, &stop);
+	if (stop != word.text + word.length) {
+		return Fail("expected a number, found " + std::string(word.text, word.length));
+	}
+	// Numbers too large for a float come back infinite
+	if (!std::isfinite(value)) {
+		return Fail("number out of range: " + std::string(word.text, word.length));
+	}
+	return true;
+}
+
+bool SceneFile::ReadInt(int& value) {
+	Word word;
+	if (!NextWord(word)) {
+		return Fail("expected a whole number");
+	}
+	if (word.length == 0) {
+		return Fail("expected a whole number, found an empty word");
+	}
+	char* stop;
+	value = (int)strtol(word.text, &stop, 10);
+	if (stop != word.text + word.length) {
+		return Fail("expected a whole number, found " + std::string(word.text, word.length));
+	}
+	return true;
+}
+
+bool SceneFile::ReadVec3(glm::vec3& value) {
+	return ReadFloat(value.x) && ReadFloat(value.y) && ReadFloat(value.z);
+}
+
+// Read the next word as a shape dimension. A zero or negative size gives degenerate bounds
+bool SceneFile::ReadSize(float& value) {
+	if (!ReadFloat(value)) {
+		return false;
+	}
+	if (value <= 0.0f) {
+		return Fail("sizes must be positive");
+	}
+	return true;
+}
+
+// Read the next word as a name
+bool SceneFile::ReadName(std::string& name) {
+	Word word;
+	if (!NextWord(word)) {
+		return Fail("expected a name");
+	}
+	name.assign(word.text, word.length);
+	return true;
+}
+
+// Read a shape and its dimensions
+bool SceneFile::ReadShape(const Word& word, ScenePart& part) {
+	if (Is(word, "sphere") || Is(word, "halfsphere")) {
+		part.primitive = Is(word, "sphere") ? PRIMITIVE_SPHERE : PRIMITIVE_HALF_SPHERE;
+		if (!ReadSize(part.size[0]) || !ReadInt(part.rings) || !ReadInt(part.sectors)) {
+			return false;
+		}
+		// Fewer than two rings divides by zero when the sphere is built and fewer than three sectors has no area, and its vertices are indexed with 16 bits
+		if (part.rings < 2 || part.sectors < 3) {
+			return Fail("a sphere needs at least 2 rings and 3 sectors");
+		}
+		if ((long long)part.rings * part.sectors > MAX_SPHERE_VERTICES) {
+			return Fail("a sphere can have at most " + std::to_string(MAX_SPHERE_VERTICES) + " rings times sectors");
+		}
+		return true;
+	}
+	if (Is(word, "cuboid")) {
+		part.primitive = PRIMITIVE_CUBOID;
+		return ReadSize(part.size[0]) && ReadSize(part.size[1]) && ReadSize(part.size[2]);
+	}
+	if (Is(word, "cylinder")) {
+		part.primitive = PRIMITIVE_CYLINDER;
+		Word caps;
+		if (!ReadSize(part.size[0]) || !ReadSize(part.size[1])) {
+			return false;
+		}
+		if (!NextWord(caps)) {
+			return Fail("expected none, top, bottom, or both after the cylinder size");
+		}
+		if (Is(caps, "none")) {
+			part.caps = NONE;
+		}
+		else if (Is(caps, "top")) {
+			part.caps = TOP;
+		}
+		else if (Is(caps, "bottom")) {
+			part.caps = BOTTOM;
+		}
+		else if (Is(caps, "both")) {
+			part.caps = BOTH;
+		}
+		else {
+			return Fail("expected none, top, bottom, or both after the cylinder size");
+		}
+		return true;
+	}
+	if (Is(word, "plane")) {
+		part.primitive = PRIMITIVE_PLANE;
+		return ReadSize(part.size[0]) && ReadSize(part.size[1]);
+	}
+	return Fail("unknown statement or shape " + std::string(word.text, word.length));
+}
+
+// Read options until the end of the line
+bool SceneFile::ReadOptions(ScenePart& part, OptionTarget target, SceneDescription& scene, SceneLightDescription* light) {
+	Word word;
+	while (NextWord(word)) {
+		if (Is(word, "texture")) {
+			std::string name;
+			if (!ReadName(name)) {
+				return false;
+			}
+			part.texture = FindTexture(scene, name);
+			if (part.texture < 0) {
+				return Fail("texture " + name + " is not defined");
+			}
+		}
+		else if (Is(word, "translate") && target != OPTIONS_LIGHT) {
+			if (!ReadVec3(part.transform.translation)) {
+				return false;
+			}
+			part.transform.hasTranslation = true;
+		}
+		else if (Is(word, "rotate")) {
+			if (!ReadFloat(part.transform.angle) || !ReadVec3(part.transform.axis)) {
+				return false;
+			}
+			part.transform.hasRotation = true;
+		}
+		else if (Is(word, "scale")) {
+			if (!ReadVec3(part.transform.scale)) {
+				return false;
+			}
+			part.transform.hasScale = true;
+		}
+		else if (Is(word, "matte")) {
+			part.matte = true;
+		}
+		else if (Is(word, "noshadow")) {
+			part.castsShadow = false;
+		}
+		else if (Is(word, "at") && target != OPTIONS_OBJECT) {
+			if (!ReadVec3(part.origin)) {
+				return false;
+			}
+		}
+		else if (Is(word, "tiles") && target != OPTIONS_OBJECT) {
+			if (!ReadFloat(part.tiles[0]) || !ReadFloat(part.tiles[1]) || !ReadFloat(part.tiles[2])) {
+				return false;
+			}
+		}
+		else if (Is(word, "position") && light) {
+			if (!ReadVec3(part.transform.translation)) {
+				return false;
+			}
+			part.transform.hasTranslation = true;
+		}
+		else if (Is(word, "color") && light) {
+			if (!ReadVec3(light->color)) {
+				return false;
+			}
+		}
+		else if (Is(word, "intensity") && light) {
+			if (!ReadFloat(light->intensity)) {
+				return false;
+			}
+		}
+		else if (Is(word, "target") && light) {
+			if (!ReadVec3(light->target)) {
+				return false;
+			}
+			light->hasTarget = true;
+		}
+		else {
+			return Fail("unknown option " + std::string(word.text, word.length));
+		}
+	}
+	return true;
+}
+
+// True if a word is the given text
+bool SceneFile::Is(const Word& word, const char* text) {
+	return strlen(text) == word.length && strncmp(word.text, text, word.length) == 0;
+}
+
+// Index of the texture with a name
+int SceneFile::FindTexture(const SceneDescription& scene, const std::string& name) {
+	for (unsigned int i = 0; i < scene.textures.size(); i++) {
+		if (scene.textures[i].name == name) {
+			return i;
+		}
+	}
+	return -1;
+}
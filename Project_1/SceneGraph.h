@@ -0,0 +1,146 @@
+#pragma once
+/* SceneGraph.h : This file contains the code necessary to hold the
+ *      transform hierarchy of the scene. Every object is a node whose
+ *		parts are its children, so moving an object is one change to
+ *		its node and its parts follow.
+ *
+ *				Nodes are kept in flat arrays, one array per field, in
+ *				depth first order. A node's descendants are the nodes right
+ *				after it, up to the end of its subtree, so updating a moved
+ *				node is one pass over a contiguous range with each parent's
+ *				world matrix computed before its children read it.
+ *
+ *				Changing a local transform only marks the node dirty.
+ *				Update recomputes the world matrices of dirty nodes and
+ *				their descendants and lists every node it touched, and
+ *				nodes outside those subtrees are not visited at all.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/* This class stores local and world transforms of a node hierarchy and updates only what changed
+*/
+class SceneGraph {
+private:
+	std::vector<int> parents;				// Parent of each node, -1 for top level nodes
+	std::vector<int> subtreeEnds;			// One past the last descendant of each node
+	std::vector<glm::mat4> locals;			// Transform relative to the parent
+	std::vector<glm::mat4> worlds;			// Transform relative to the scene, valid after Update
+	std::vector<uint8_t> dirty;				// 1 if the node's local transform changed since the last Update
+	std::vector<int> dirtyNodes;			// Nodes marked dirty since the last Update
+	std::vector<int> changed;				// Nodes whose world transform the last Update recomputed
+
+public:
+	// Add a node. Its parent must be -1 or a node whose descendants are all at the end of the graph. Returns the node
+	int AddNode(int parent, const glm::mat4& local);
+	// Remove every node
+	void Clear();
+	// Change a node's transform relative to its parent
+	void SetLocal(int node, const glm::mat4& local);
+	// Recompute the world transforms of dirty nodes and their descendants
+	void Update();
+	// Nodes the last Update recomputed, in depth first order
+	const std::vector<int>& Changed() const;
+	// Transform relative to the parent
+	const glm::mat4& Local(int node) const;
+	// Transform relative to the scene
+	const glm::mat4& World(int node) const;
+	// Parent of a node, -1 for top level nodes
+	int Parent(int node) const;
+	// Number of nodes
+	unsigned int Size() const;
+};
+
+// Add a node
+int SceneGraph::AddNode(int parent, const glm::mat4& local) {
+	int node = parents.size();
+	// Only the end of the graph can grow, so a parent must be the last node added or one of its ancestors
+	if (parent >= 0 && subtreeEnds[parent] != node) {
+		return -1;
+	}
+	parents.push_back(parent);
+	subtreeEnds.push_back(node + 1);
+	locals.push_back(local);
+	worlds.push_back(local);
+	dirty.push_back(1);
+	dirtyNodes.push_back(node);
+	for (int ancestor = parent; ancestor >= 0; ancestor = parents[ancestor]) {
+		subtreeEnds[ancestor] = node + 1;
+	}
+	return node;
+}
+
+// Remove every node
+void SceneGraph::Clear() {
+	parents.clear();
+	subtreeEnds.clear();
+	locals.clear();
+	worlds.clear();
+	dirty.clear();
+	dirtyNodes.clear();
+	changed.clear();
+}
+
+// Change a node's transform relative to its parent
+void SceneGraph::SetLocal(int node, const glm::mat4& local) {
+	locals[node] = local;
+	if (!dirty[node]) {
+		dirty[node] = 1;
+		dirtyNodes.push_back(node);
+	}
+}
+
+// Recompute the world transforms of dirty nodes and their descendants
+void SceneGraph::Update() {
+	changed.clear();
+	// In depth first order a dirty node's subtree covers any dirty nodes inside it, so each subtree is updated once
+	std::sort(dirtyNodes.begin(), dirtyNodes.end());
+	int covered = 0;
+	for (unsigned int i = 0; i < dirtyNodes.size(); i++) {
+		int start = dirtyNodes[i];
+		if (start < covered) {
+			continue;
+		}
+		covered = subtreeEnds[start];
+		for (int node = start; node < covered; node++) {
+			int parent = parents[node];
+			worlds[node] = parent >= 0 ? worlds[parent] * locals[node] : locals[node];
+			dirty[node] = 0;
+			changed.push_back(node);
+		}
+	}
+	dirtyNodes.clear();
+}
+
+// Nodes the last Update recomputed
+const std::vector<int>& SceneGraph::Changed() const {
+	return changed;
+}
+
+// Transform relative to the parent
+const glm::mat4& SceneGraph::Local(int node) const {
+	return locals[node];
+}
+
+// Transform relative to the scene
+const glm::mat4& SceneGraph::World(int node) const {
+	return worlds[node];
+}
+
+// Parent of a node
+int SceneGraph::Parent(int node) const {
+	return parents[node];
+}
+
+// Number of nodes
+unsigned int SceneGraph::Size() const {
+	return parents.size();
+}
@@ -0,0 +1,88 @@
+#pragma once
+/* ShaderStages.h : This file contains the code necessary to share
+ *      compiled shader stages between programs. A stage is looked up
+ *		by its type and source text, so programs built from the same
+ *		source share one shader object and it is only compiled once.
+ *
+ *				When a shader file changes, relinking its programs only
+ *				compiles the stage whose source changed. The other stage is
+ *				found here already compiled. Stages are counted and deleted
+ *				when the last program using them is destroyed.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+/* This class holds compiled shader objects keyed by stage type and source
+*/
+class ShaderStages {
+private:
+	typedef std::pair<GLenum, std::string> StageKey;
+
+	// A compiled shader object and the number of programs using it
+	struct Stage {
+		GLuint shader;
+		unsigned int references;
+	};
+
+	std::map<StageKey, Stage> stages;		// Every stage in use
+	unsigned int compiles;					// Number of stages compiled so far
+
+public:
+	// Constructor
+	ShaderStages();
+	// Shader object for a stage, compiling it if no program uses this source yet. Status is not checked here
+	GLuint Acquire(GLenum type, const char* source);
+	// Stop using a shader object, deleting it if no program uses it anymore
+	void Release(GLuint shader);
+	// Number of stages compiled so far
+	unsigned int Compiles() const;
+};
+
+// Constructor
+ShaderStages::ShaderStages() {
+	compiles = 0;
+}
+
+// Shader object for a stage, compiling it if no program uses this source yet
+GLuint ShaderStages::Acquire(GLenum type, const char* source) {
+	StageKey key(type, source);
+	std::map<StageKey, Stage>::iterator found = stages.find(key);
+	if (found != stages.end()) {
+		found->second.references++;
+		return found->second.shader;
+	}
+	Stage stage;
+	stage.shader = glCreateShader(type);
+	stage.references = 1;
+	glShaderSource(stage.shader, 1, &source, NULL);
+	glCompileShader(stage.shader);
+	compiles++;
+	stages[key] = stage;
+	return stage.shader;
+}
+
+// Stop using a shader object
+void ShaderStages::Release(GLuint shader) {
+	for (std::map<StageKey, Stage>::iterator it = stages.begin(); it != stages.end(); ++it) {
+		if (it->second.shader == shader) {
+			if (--it->second.references == 0) {
+				glDeleteShader(shader);
+				stages.erase(it);
+			}
+			return;
+		}
+	}
+}
+
+// Number of stages compiled so far
+unsigned int ShaderStages::Compiles() const {
+	return compiles;
+}
@@ -0,0 +1,230 @@
+#pragma once
+/* ShaderVariants.h : This file contains the code necessary to build
+ *      specialized versions of one shader from feature flags. Each
+ *		flag becomes a #define placed after the #version line, so the
+ *		shader source can leave out the code for features a material
+ *		does not use and that code costs nothing on the GPU.
+ *
+ *				Variants are compiled the first time they are asked for and
+ *				kept until Destroy, so only variants that are actually used
+ *				are ever compiled. Prepare starts a compile without waiting
+ *				for it, so several variants can compile at once.
+ *
+ *				FinishAll checks every variant started so far, so a
+ *				broken variant stops the program at startup like the other
+ *				shaders do. A variant that still fails later is drawn with
+ *				its fallback, the same key with the fallback features
+ *				added, instead of not being drawn at all.
+ *
+ *				SetSources swaps in edited sources. Every variant is built
+ *				from the new sources first and the old programs are only
+ *				replaced if all of them compile and link.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+#include <map>
+#include <string>
+
+// Features a material can ask for. A variant key is a combination of these plus a light count
+enum ShaderFeature {
+	SHADER_TEXTURED = 1,		// Sample uTexture instead of using objectColor
+	SHADER_SPECULAR = 2,		// Add specular highlights
+	SHADER_SHADOWS = 4,			// Sample the shadow maps
+	SHADER_INSTANCED = 8		// Read the model matrix from a per-instance attribute instead of a uniform
+};
+
+/* This class compiles and caches the variants of one vertex and fragment shader pair
+*/
+class ShaderVariants {
+private:
+	static const unsigned int LIGHT_COUNT_SHIFT = 8;	// Bits of the key below this hold feature flags
+	typedef bool (*BeginFunction)(const char*, const char*, GLuint&);
+	typedef bool (*FinishFunction)(GLuint);
+	typedef void (*DestroyFunction)(GLuint);
+
+	// A variant that has been started
+	struct Variant {
+		GLuint program;						// Program object, 0 if it failed
+		bool finished;						// True once the compile and link results have been checked
+	};
+
+	std::string version;					// Text of the #version line, for example "440 core"
+	std::string vertexSource;				// Vertex shader source without a #version line
+	std::string fragmentSource;				// Fragment shader source without a #version line
+	BeginFunction begin;					// Starts compiling and linking a vertex and fragment shader into a program
+	FinishFunction finish;					// Waits for a started program and checks it for errors
+	DestroyFunction destroy;				// Deletes a program
+	std::map<unsigned int, Variant> programs;	// Started variants by key
+	unsigned int fallbackFeatures;			// Added to the key of a failed variant to find the program drawn instead
+
+	// Header placed in front of both shaders of a variant
+	std::string Header(unsigned int key) const;
+	// Start compiling a variant from the given sources
+	Variant Begin(unsigned int key, const std::string& vertex, const std::string& fragment) const;
+	// Wait for a variant and check it. Deletes the program if it failed
+	bool Finish(Variant& variant) const;
+
+public:
+	// Constructor
+	ShaderVariants(const char* version, BeginFunction begin, FinishFunction finish, DestroyFunction destroy);
+	// Set the sources, rebuilding any variants already started. Sources must not have a #version line since the header supplies it.
+	// Returns false and keeps the old sources and programs if any variant fails
+	bool SetSources(const std::string& vertex, const std::string& fragment);
+	// Combine feature flags and a light count into a variant key
+	static unsigned int Key(unsigned int features, unsigned int lightCount);
+	// Start compiling a variant without waiting for it
+	void Prepare(unsigned int key);
+	// Wait for every started variant and check it. Returns false if any failed
+	bool FinishAll();
+	// Features added to a failed variant's key to find the program used in its place
+	void SetFallbackFeatures(unsigned int features);
+	// Key whose program is drawn in place of a variant. The key itself unless the variant failed
+	unsigned int FallbackKey(unsigned int key) const;
+	// True if the variant was started, checked, and failed
+	bool Failed(unsigned int key) const;
+	// Program for a variant, compiling it or waiting for it the first time. Returns the fallback's program if it fails, or 0 if that fails too
+	GLuint Get(unsigned int key);
+	// Number of variants started so far
+	unsigned int Count() const;
+	// Delete every compiled variant
+	void Destroy();
+};
+
+// Constructor
+ShaderVariants::ShaderVariants(const char* version, BeginFunction begin, FinishFunction finish, DestroyFunction destroy)
+	: version(version), begin(begin), finish(finish), destroy(destroy) {
+	fallbackFeatures = 0;
+}
+
+// Set the sources, rebuilding any variants already started
+bool ShaderVariants::SetSources(const std::string& vertex, const std::string& fragment) {
+	// Build every variant in use from the new sources before replacing any of them
+	std::map<unsigned int, Variant> rebuilt;
+	for (std::map<unsigned int, Variant>::iterator it = programs.begin(); it != programs.end(); ++it) {
+		rebuilt[it->first] = Begin(it->first, vertex, fragment);
+	}
+	bool success = true;
+	for (std::map<unsigned int, Variant>::iterator it = rebuilt.begin(); it != rebuilt.end(); ++it) {
+		success = Finish(it->second) && success;
+	}
+	if (!success) {
+		for (std::map<unsigned int, Variant>::iterator it = rebuilt.begin(); it != rebuilt.end(); ++it) {
+			destroy(it->second.program);
+		}
+		return false;
+	}
+	Destroy();
+	programs = rebuilt;
+	vertexSource = vertex;
+	fragmentSource = fragment;
+	return true;
+}
+
+// Start compiling a variant from the given sources
+ShaderVariants::Variant ShaderVariants::Begin(unsigned int key, const std::string& vertex, const std::string& fragment) const {
+	std::string header = Header(key);
+	Variant variant = { 0, false };
+	begin((header + vertex).c_str(), (header + fragment).c_str(), variant.program);
+	return variant;
+}
+
+// Wait for a variant and check it
+bool ShaderVariants::Finish(Variant& variant) const {
+	if (variant.finished) {
+		return variant.program != 0;
+	}
+	variant.finished = true;
+	if (!finish(variant.program)) {
+		destroy(variant.program);
+		variant.program = 0;
+	}
+	return variant.program != 0;
+}
+
+// Combine feature flags and a light count into a variant key
+unsigned int ShaderVariants::Key(unsigned int features, unsigned int lightCount) {
+	return features | (lightCount << LIGHT_COUNT_SHIFT);
+}
+
+// Header placed in front of both shaders of a variant
+std::string ShaderVariants::Header(unsigned int key) const {
+	std::string header = "#version " + version + "\n";
+	if (key & SHADER_TEXTURED) {
+		header += "#define TEXTURED\n";
+	}
+	if (key & SHADER_SPECULAR) {
+		header += "#define SPECULAR\n";
+	}
+	if (key & SHADER_SHADOWS) {
+		header += "#define SHADOWS\n";
+	}
+	if (key & SHADER_INSTANCED) {
+		header += "#define INSTANCED\n";
+	}
+	header += "#define LIGHT_COUNT " + std::to_string(key >> LIGHT_COUNT_SHIFT) + "\n";
+	return header;
+}
+
+// Start compiling a variant without waiting for it
+void ShaderVariants::Prepare(unsigned int key) {
+	if (programs.count(key)) {
+		return;
+	}
+	programs[key] = Begin(key, vertexSource, fragmentSource);
+}
+
+// Wait for every started variant and check it
+bool ShaderVariants::FinishAll() {
+	bool success = true;
+	for (std::map<unsigned int, Variant>::iterator it = programs.begin(); it != programs.end(); ++it) {
+		success = Finish(it->second) && success;
+	}
+	return success;
+}
+
+// Features added to a failed variant's key
+void ShaderVariants::SetFallbackFeatures(unsigned int features) {
+	fallbackFeatures = features;
+}
+
+// Key whose program is drawn in place of a variant
+unsigned int ShaderVariants::FallbackKey(unsigned int key) const {
+	return Failed(key) ? key | fallbackFeatures : key;
+}
+
+// True if the variant was started, checked, and failed
+bool ShaderVariants::Failed(unsigned int key) const {
+	std::map<unsigned int, Variant>::const_iterator it = programs.find(key);
+	return it != programs.end() && it->second.finished && !it->second.program;
+}
+
+// Program for a variant, compiling it or waiting for it the first time
+GLuint ShaderVariants::Get(unsigned int key) {
+	Prepare(key);
+	// Failures are remembered too so a broken variant is not compiled again every frame
+	Variant& variant = programs[key];
+	if (Finish(variant)) {
+		return variant.program;
+	}
+	unsigned int fallback = key | fallbackFeatures;
+	return fallback != key ? Get(fallback) : 0;
+}
+
+// Number of variants started so far
+unsigned int ShaderVariants::Count() const {
+	return programs.size();
+}
+
+// Delete every compiled variant
+void ShaderVariants::Destroy() {
+	for (std::map<unsigned int, Variant>::iterator it = programs.begin(); it != programs.end(); ++it) {
+		Finish(it->second);
+		destroy(it->second.program);
+	}
+	programs.clear();
+}
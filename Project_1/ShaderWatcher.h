@@ -0,0 +1,153 @@
+#pragma once
+/* ShaderWatcher.h : This file contains the code necessary to read
+ *      shader files and notice when they are saved, so shaders can be
+ *		edited and reloaded while the program runs.
+ *
+ *				On Linux the shader folder is watched with inotify and
+ *				changes are read without blocking. Everywhere else the
+ *				modification times of the watched files are checked a few
+ *				times a second.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Read a whole shader file into source. Returns false if it cannot be opened
+bool ReadShaderFile(const std::string& path, std::string& source) {
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	source = contents.str();
+	return true;
+}
+
+/* This class reports which files in a folder have been saved since it was last asked
+*/
+class ShaderWatcher {
+private:
+	const double POLL_INTERVAL = 0.5;			// Seconds between modification time checks when inotify is not used
+	std::string directory;						// Folder holding the shader files
+	std::vector<std::string> files;				// Names of the watched files within the folder
+	std::vector<time_t> modifiedTimes;			// Last modification time seen for each file
+	std::chrono::steady_clock::time_point lastPoll;	// Time of the last modification time check
+	int inotifyDescriptor;						// inotify instance, -1 when polling modification times
+
+	// Modification time of a watched file, 0 if it is missing
+	time_t ModifiedTime(const std::string& file) const;
+
+public:
+	// Constructor
+	ShaderWatcher();
+	// Close the inotify instance
+	~ShaderWatcher();
+	// Start watching files, given by name, in a folder
+	void Start(const std::string& directory, const std::vector<std::string>& files);
+	// Names of watched files saved since the last call. Never blocks
+	std::vector<std::string> Poll();
+	// Path of a watched file
+	std::string Path(const std::string& file) const;
+};
+
+// Constructor
+ShaderWatcher::ShaderWatcher() {
+	inotifyDescriptor = -1;
+}
+
+// Close the inotify instance
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+	if (inotifyDescriptor >= 0) {
+		close(inotifyDescriptor);
+	}
+#endif
+}
+
+// Modification time of a watched file, 0 if it is missing
+time_t ShaderWatcher::ModifiedTime(const std::string& file) const {
+	struct stat status;
+	if (stat(Path(file).c_str(), &status) != 0) {
+		return 0;
+	}
+	return status.st_mtime;
+}
+
+// Path of a watched file
+std::string ShaderWatcher::Path(const std::string& file) const {
+	return directory + "/" + file;
+}
+
+// Start watching files in a folder
+void ShaderWatcher::Start(const std::string& directory, const std::vector<std::string>& files) {
+	this->directory = directory;
+	this->files = files;
+	modifiedTimes.clear();
+	for (unsigned int i = 0; i < files.size(); i++) {
+		modifiedTimes.push_back(ModifiedTime(files[i]));
+	}
+	lastPoll = std::chrono::steady_clock::now();
+#ifdef __linux__
+	// Editors either write the file in place or write a new file and rename it over the old one
+	inotifyDescriptor = inotify_init1(IN_NONBLOCK);
+	if (inotifyDescriptor >= 0 && inotify_add_watch(inotifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		close(inotifyDescriptor);
+		inotifyDescriptor = -1;
+	}
+#endif
+}
+
+// Names of watched files saved since the last call
+std::vector<std::string> ShaderWatcher::Poll() {
+	std::vector<std::string> changed;
+#ifdef __linux__
+	if (inotifyDescriptor >= 0) {
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(inotifyDescriptor, buffer, sizeof(buffer))) > 0) {
+			for (char* next = buffer; next < buffer + length; next += sizeof(inotify_event) + ((inotify_event*)next)->len) {
+				const inotify_event* event = (const inotify_event*)next;
+				if (event->len == 0) {
+					continue;
+				}
+				std::string name(event->name);
+				if (std::find(files.begin(), files.end(), name) != files.end() && std::find(changed.begin(), changed.end(), name) == changed.end()) {
+					changed.push_back(name);
+				}
+			}
+		}
+		return changed;
+	}
+#endif
+	// Without inotify compare modification times, but not every frame
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (std::chrono::duration<double>(now - lastPoll).count() < POLL_INTERVAL) {
+		return changed;
+	}
+	lastPoll = now;
+	for (unsigned int i = 0; i < files.size(); i++) {
+		time_t modified = ModifiedTime(files[i]);
+		if (modified != modifiedTimes[i]) {
+			modifiedTimes[i] = modified;
+			changed.push_back(files[i]);
+		}
+	}
+	return changed;
+}
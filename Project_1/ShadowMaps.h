@@ -0,0 +1,219 @@
+#pragma once
+/* ShadowMaps.h : This file contains the code necessary to render and
+ *      cache shadow maps for the two scene lights. The key light is a
+ *		point light and gets a depth cube map holding the distance to
+ *		the nearest surface in every direction. The fill light is
+ *		treated as a spot light aimed at the room and gets a single
+ *		perspective depth map.
+ *
+ *				Everything in the scene is static, so the maps are only
+ *				rendered when a light moves or objects are placed again.
+ *				Every other frame reuses the cached maps.
+ *
+ *Author:      David Smith
+ *Date:        October 19, 2026
+ *Version:     1.0
+ */
+
+#include <GL/glew.h>
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+/* This class holds the shadow map textures and framebuffers and knows when they need to be rendered again
+*/
+class ShadowMaps {
+private:
+	static const int CUBE_SIZE = 1024;		// Width and height of each cube map face
+	static const int SPOT_SIZE = 2048;		// Width and height of the spot light map
+	const float CUBE_NEAR = 0.1f;			// Near plane of the cube map faces
+	const float CUBE_FAR = 30.0f;			// Far plane of the cube map faces, stored distances are divided by this
+	const float SPOT_NEAR = 1.0f;			// Near plane of the spot light
+	const float SPOT_FAR = 60.0f;			// Far plane of the spot light
+	const float SPOT_ANGLE = 100.0f;		// Field of view of the spot light in degrees
+	GLuint cubeTexture;						// Depth cube map for the key light
+	GLuint spotTexture;						// Depth map for the fill light
+	GLuint framebuffer;						// Framebuffer the maps are attached to while rendering
+	glm::mat4 spotViewProjection;			// View projection matrix of the fill light
+	glm::vec3 cachedLight1;					// Key light position the maps were rendered with
+	glm::vec3 cachedLight2;					// Fill light position the maps were rendered with
+	unsigned int cachedSceneVersion;		// Scene version the maps were rendered with
+	bool rendered;							// True once the maps have been rendered
+	unsigned int renderCount;				// Number of times the maps have been rendered
+
+public:
+	// Constructor. Textures are created in Create once a context exists
+	ShadowMaps();
+	// Create the textures and framebuffer
+	void Create();
+	// Free the textures and framebuffer
+	void Destroy();
+	// True if the cached maps do not match the lights or the scene
+	bool NeedsUpdate(const glm::vec3& light1, const glm::vec3& light2, unsigned int sceneVersion) const;
+	// Render the maps again next frame, for example after the depth program changed
+	void Invalidate();
+	// Render both maps. drawCasters(modelLoc) must draw every shadow casting mesh
+	template <typename DrawCasters>
+	void Render(GLuint depthProgram, const glm::vec3& light1, const glm::vec3& light2, const glm::vec3& spotTarget, unsigned int sceneVersion, DrawCasters drawCasters);
+	// Depth cube map for the key light
+	GLuint CubeTexture() const;
+	// Depth map for the fill light
+	GLuint SpotTexture() const;
+	// Distance the cube map depths are divided by
+	float CubeFarPlane() const;
+	// View projection matrix of the fill light
+	const glm::mat4& SpotViewProjection() const;
+	// Number of times the maps have been rendered
+	unsigned int RenderCount() const;
+};
+
+// Constructor
+ShadowMaps::ShadowMaps() {
+	cubeTexture = 0;
+	spotTexture = 0;
+	framebuffer = 0;
+	cachedSceneVersion = 0;
+	rendered = false;
+	renderCount = 0;
+}
+
+// Create the textures and framebuffer
+void ShadowMaps::Create() {
+	// Cube map holding linear distance from the key light
+	glGenTextures(1, &cubeTexture);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, cubeTexture);
+	for (int face = 0; face < 6; face++) {
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, CUBE_SIZE, CUBE_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	// Depth map for the fill light. Outside the map counts as lit
+	glGenTextures(1, &spotTexture);
+	glBindTexture(GL_TEXTURE_2D, spotTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, SPOT_SIZE, SPOT_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	const GLfloat border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// Depth only framebuffer
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Free the textures and framebuffer
+void ShadowMaps::Destroy() {
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &cubeTexture);
+	glDeleteTextures(1, &spotTexture);
+	rendered = false;
+}
+
+// True if the cached maps do not match the lights or the scene
+bool ShadowMaps::NeedsUpdate(const glm::vec3& light1, const glm::vec3& light2, unsigned int sceneVersion) const {
+	return !rendered || light1 != cachedLight1 || light2 != cachedLight2 || sceneVersion != cachedSceneVersion;
+}
+
+// Render the maps again next frame
+void ShadowMaps::Invalidate() {
+	rendered = false;
+}
+
+// Render both maps
+template <typename DrawCasters>
+void ShadowMaps::Render(GLuint depthProgram, const glm::vec3& light1, const glm::vec3& light2, const glm::vec3& spotTarget, unsigned int sceneVersion, DrawCasters drawCasters) {
+	// Direction and up vector for each cube map face in the order OpenGL numbers them
+	static const glm::vec3 faceDirections[6] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	static const glm::vec3 faceUps[6] = {
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+
+	// Keep the viewport so it can be restored for the main pass
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	glUseProgram(depthProgram);
+	GLint viewProjectionLoc = glGetUniformLocation(depthProgram, "lightViewProjection");
+	GLint lightPositionLoc = glGetUniformLocation(depthProgram, "lightPosition");
+	GLint farPlaneLoc = glGetUniformLocation(depthProgram, "farPlane");
+	GLint linearDepthLoc = glGetUniformLocation(depthProgram, "linearDepth");
+	GLint modelLoc = glGetUniformLocation(depthProgram, "model");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glEnable(GL_DEPTH_TEST);
+
+	// Key light, one face at a time, storing distance divided by the far plane
+	glViewport(0, 0, CUBE_SIZE, CUBE_SIZE);
+	glm::mat4 cubeProjection = glm::perspective(glm::radians(90.0f), 1.0f, CUBE_NEAR, CUBE_FAR);
+	glUniform3f(lightPositionLoc, light1.x, light1.y, light1.z);
+	glUniform1f(farPlaneLoc, CUBE_FAR);
+	glUniform1i(linearDepthLoc, 1);
+	for (int face = 0; face < 6; face++) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cubeTexture, 0);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glm::mat4 faceViewProjection = cubeProjection * glm::lookAt(light1, light1 + faceDirections[face], faceUps[face]);
+		glUniformMatrix4fv(viewProjectionLoc, 1, GL_FALSE, glm::value_ptr(faceViewProjection));
+		drawCasters(modelLoc);
+	}
+
+	// Fill light, aimed at the target with ordinary depth
+	glViewport(0, 0, SPOT_SIZE, SPOT_SIZE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, spotTexture, 0);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	spotViewProjection = glm::perspective(glm::radians(SPOT_ANGLE), 1.0f, SPOT_NEAR, SPOT_FAR) * glm::lookAt(light2, spotTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+	glUniformMatrix4fv(viewProjectionLoc, 1, GL_FALSE, glm::value_ptr(spotViewProjection));
+	glUniform1i(linearDepthLoc, 0);
+	drawCasters(modelLoc);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	cachedLight1 = light1;
+	cachedLight2 = light2;
+	cachedSceneVersion = sceneVersion;
+	rendered = true;
+	renderCount++;
+}
+
+// Depth cube map for the key light
+GLuint ShadowMaps::CubeTexture() const {
+	return cubeTexture;
+}
+
+// Depth map for the fill light
+GLuint ShadowMaps::SpotTexture() const {
+	return spotTexture;
+}
+
+// Distance the cube map depths are divided by
+float ShadowMaps::CubeFarPlane() const {
+	return CUBE_FAR;
+}
+
+// View projection matrix of the fill light
+const glm::mat4& ShadowMaps::SpotViewProjection() const {
+	return spotViewProjection;
+}
+
+// Number of times the maps have been rendered
+unsigned int ShadowMaps::RenderCount() const {
+	return renderCount;
+}
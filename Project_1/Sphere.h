@@ -22,6 +22,8 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <gl/glew.h>
 
+#include "Arena.h"
+
 #include <vector>
 
 namespace {
@@ -45,25 +47,29 @@ private:
 	float originZ;							// Z coordinate for the center of the top
 	vector<GLfloat> vertices;				// Storage for the vertices
 	vector<GLushort> indices;				// Storage for the indices
-	vector<vec2> UVs;				// Temporary storage for UVs
-	vector<vec3> normals;					// Temporary storage for normals
-	vector<vec3> vertexData;				// Temporary storage for vertices
+	ArenaScope scratch;						// Gives the temporary storage back to the thread's scratch arena
+	ArenaVector<vec2> UVs;					// Temporary storage for UVs
+	ArenaVector<vec3> normals;				// Temporary storage for normals
+	ArenaVector<vec3> vertexData;			// Temporary storage for vertices
 
 public:
 	// Parameterized constructor for a sphere
 	Sphere(float radius, int rings, int sectors, float x, float y, float z);
 	// Generate the vertices
 	void GenSphere();
-	// Generate the indices
+	// Generate the indices of the quad between a ring and the next, from a sector to the next
 	void GenIndices(int r, int s);
+	// Keep only the lowest rings and the triangles between them
+	void KeepRings(int rings);
 	// Retrieve the vertices
 	vector<GLfloat> GetVertices();
 	// Retrieve the indices
 	vector<GLushort> GetIndices();
 };
 
-// Parameterized constructor
-Sphere::Sphere(float radius, int rings, int sectors, float x, float y, float z) {
+// Parameterized constructor. The temporary storage is taken from the scratch arena of the thread building the sphere
+Sphere::Sphere(float radius, int rings, int sectors, float x, float y, float z) : scratch(Arena::Scratch()),
+	UVs(ArenaAllocator<vec2>(Arena::Scratch())), normals(ArenaAllocator<vec3>(Arena::Scratch())), vertexData(ArenaAllocator<vec3>(Arena::Scratch())) {
 	numRings = rings;
 	numSectors = sectors;
 	m_radius = radius;
@@ -78,6 +84,14 @@ void Sphere::GenSphere() {
 	const float R = 1.0f / (float)(numRings - 1);
 	const float S = 1.0f / (float)(numSectors - 1);
 
+	// Room for every vertex up front, so nothing grows one push at a time
+	unsigned int count = numRings * numSectors;
+	UVs.reserve(count);
+	vertexData.reserve(count);
+	normals.reserve(count);
+	vertices.reserve(count * 8);
+	indices.reserve((numRings - 1) * (numSectors - 1) * 6);
+
 	for (int ring = 0; ring < numRings; ring++) {
 		for (int sector = 0; sector < numSectors; sector++) {
 			const float x = cos(2 * PI * sector * S) * sin(PI * ring * R);
@@ -87,6 +101,11 @@ void Sphere::GenSphere() {
 			UVs.push_back(vec2(sector * S, ring * R));
 			vertexData.push_back(vec3(x, y, z) * m_radius);
 			normals.push_back(normalize(vec3(x, y, z) - vec3(originX, originY, originZ)));
+		}
+	}
+	// One row of quads between each ring and the next. The last sector lies on the first, so it closes the row without wrapping
+	for (int ring = 0; ring + 1 < numRings; ring++) {
+		for (int sector = 0; sector + 1 < numSectors; sector++) {
 			GenIndices(ring, sector);
 		}
 	}
@@ -99,11 +118,11 @@ void Sphere::GenSphere() {
 
 }
 
-// Generate the indices
+// Generate the indices of one quad
 void Sphere::GenIndices(int ring, int sector) {
 	int curRow = ring * numSectors;
 	int nextRow = (ring + 1) * numSectors;
-	int nextS = (sector + 1) % numSectors;
+	int nextS = sector + 1;
 
 	indices.push_back(curRow + sector);
 	indices.push_back(nextRow + sector);
@@ -114,6 +133,16 @@ void Sphere::GenIndices(int ring, int sector) {
 	indices.push_back(curRow + nextS);
 }
 
+// Keep only the lowest rings. The rows of quads are stored in ring order, so the ones between the kept rings come first
+void Sphere::KeepRings(int rings) {
+	if (rings >= numRings) {
+		return;
+	}
+	numRings = rings;
+	vertices.resize(numRings * numSectors * 8);
+	indices.resize((numRings - 1) * (numSectors - 1) * 6);
+}
+
 // Retrieve the vertices
 vector<GLfloat> Sphere::GetVertices() {
 	return vertices;
@@ -0,0 +1,19 @@
+// No #version line. Placed after the #version line of every shader when its program is built, so
+// every program reads the same FrameData layout
+
+// Per-frame data shared by every program. Must match FrameUniformData in FrameUniforms.h
+layout(std140, binding = 0) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 light2ViewProjection;      // Fill light's shadow map view projection
+    vec3 viewPosition;
+    float specularIntensity1;       // Intensity of the key light
+    vec3 lightPos;
+    float specularIntensity2;       // Intensity of the fill light
+    vec3 lightColor;
+    float lightFarPlane;            // Far plane of the key light's shadow cube
+    vec3 light2Pos;
+    vec3 light2Color;
+    vec3 objectColor;
+    vec2 uvScale;
+};
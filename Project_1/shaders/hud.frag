@@ -0,0 +1,13 @@
+#version 440 core
+
+in vec2 texCoord;
+in vec4 vertexColor;
+
+out vec4 fragmentColor;
+
+uniform sampler2D glyphs;                   // Glyph atlas, 1 where a glyph's pixel is set
+
+void main()
+{
+    fragmentColor = vec4(vertexColor.rgb, vertexColor.a * texture(glyphs, texCoord).r);
+}
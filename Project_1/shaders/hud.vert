@@ -0,0 +1,19 @@
+#version 440 core
+
+layout(location = 0) in vec2 position;     // Position in pixels from the top left of the window
+layout(location = 1) in vec2 aTexCoord;    // Coordinates in the glyph atlas
+layout(location = 2) in vec4 color;
+
+out vec2 texCoord;
+out vec4 vertexColor;
+
+uniform vec2 screenSize;                    // Size of the framebuffer in pixels
+
+void main()
+{
+    // Pixels to clip coordinates, with y pointing down the window
+    vec2 ndc = position / screenSize * 2.0f - 1.0f;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0f, 1.0f);
+    texCoord = aTexCoord;
+    vertexColor = color;
+}
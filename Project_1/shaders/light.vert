@@ -0,0 +1,15 @@
+#version 440 core
+
+layout(location = 0) in vec3 position;      // Vertex data from Vertex Attrib Pointer 0
+layout(location = 1) in vec3 normals;       // Color data from Vertex Attrib Pointer 1
+layout(location = 2) in vec2 aTexCoord;     // Texture coordinates
+
+//Uniform / Global variables for the  transform matrices
+uniform mat4 model;
+
+// FrameData, the per-frame values shared by every program, is added from frame_data.glsl when the program is built
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0f); // Transforms vertices into clip coordinates
+}
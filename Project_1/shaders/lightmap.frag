@@ -0,0 +1,20 @@
+#version 440 core
+
+in vec2 vertexTextureCoordinate;
+in vec2 vertexLightmapCoordinate;
+
+out vec4 fragmentColor;
+
+uniform sampler2D uTexture;
+uniform sampler2D lightmap;         // Baked diffuse light, red for the key light and green for the fill light
+
+// FrameData, the per-frame values shared by every program, is added from frame_data.glsl when the program is built
+
+void main()
+{
+    // Same ambient terms as the Phong shader. Diffuse light and shadows come from the lightmap and specular is skipped
+    vec2 baked = texture(lightmap, vertexLightmapCoordinate).rg;
+    vec3 lightingResult = 0.3f * lightColor + 0.1f * light2Color + baked.r * lightColor + baked.g * light2Color;
+    vec4 textureColor = texture(uTexture, vertexTextureCoordinate * uvScale);
+    fragmentColor = vec4(lightingResult * textureColor.xyz, 1.0);
+}
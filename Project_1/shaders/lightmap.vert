@@ -0,0 +1,21 @@
+#version 440 core
+
+layout(location = 0) in vec3 position;      // VAP position 0 for vertex position data
+layout(location = 2) in vec2 textureCoordinate;
+layout(location = 3) in vec2 lightmapCoordinate;    // Position of the vertex in the mesh's lightmap chart
+
+out vec2 vertexTextureCoordinate;
+out vec2 vertexLightmapCoordinate;
+
+//Uniform / Global variables for the transform matrices
+uniform mat4 model;
+uniform vec4 lightmapScaleOffset;           // Maps the chart into the atlas
+
+// FrameData, the per-frame values shared by every program, is added from frame_data.glsl when the program is built
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+    vertexTextureCoordinate = textureCoordinate;
+    vertexLightmapCoordinate = lightmapCoordinate * lightmapScaleOffset.xy + lightmapScaleOffset.zw;
+}
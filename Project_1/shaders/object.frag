@@ -0,0 +1,127 @@
+// No #version line. ShaderVariants adds it along with the TEXTURED, SPECULAR, SHADOWS, and LIGHT_COUNT
+// defines for each material
+
+in vec3 vertexNormal;               // For incoming normals
+in vec3 vertexFragmentPos;          // For incoming fragment position
+#ifdef TEXTURED
+in vec2 vertexTextureCoordinate;
+#endif
+#if defined(SHADOWS) && LIGHT_COUNT > 1
+in vec4 vertexLight2Position;       // For incoming position as seen from the fill light
+#endif
+
+
+out vec4 fragmentColor;             // For outgoing cube color to the GPU
+
+// Uniform / Global variables for textures. Object color, lights, and camera/view position are in FrameData
+uniform sampler2D uTexture;         // Useful when working with multiple textures
+uniform samplerCube shadowCube;     // Distance from the key light to the nearest surface, divided by lightFarPlane
+uniform sampler2D shadowMap;        // Depth as seen from the fill light
+
+// FrameData, the per-frame values shared by every program, is added from frame_data.glsl when the program is built
+
+#ifdef SHADOWS
+// Returns 1.0 where the key light reaches the fragment and 0.0 where it is in shadow
+float KeyLightShadow(vec3 norm, vec3 lightDirection)
+{
+    vec3 fromLight = vertexFragmentPos - lightPos;
+    float closest = texture(shadowCube, fromLight).r * lightFarPlane;
+    float bias = max(0.05 * (1.0 - dot(norm, lightDirection)), 0.01);  // Steeper surfaces need more bias to avoid acne
+    return length(fromLight) - bias > closest ? 0.0 : 1.0;
+}
+
+#if LIGHT_COUNT > 1
+// Returns how much of the fill light reaches the fragment, softened with 3x3 percentage closer filtering
+float FillLightShadow(vec3 norm, vec3 lightDirection)
+{
+    vec3 projected = vertexLight2Position.xyz / vertexLight2Position.w * 0.5 + 0.5;
+    if (projected.z > 1.0)
+        return 1.0;
+    float bias = max(0.002 * (1.0 - dot(norm, lightDirection)), 0.0005);
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0));
+    float lit = 0.0;
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            float closest = texture(shadowMap, projected.xy + vec2(x, y) * texelSize).r;
+            lit += projected.z - bias > closest ? 0.0 : 1.0;
+        }
+    }
+    return lit / 9.0;
+}
+#endif
+#endif
+
+void main()
+{
+    /*Phong lighting model calculations to generate ambient, diffuse, and specular components
+     *Calculate for light 1
+     *Calculate Ambient lighting*/
+    float ambientStrength = 0.3f; // Set ambient or global lighting strength
+    vec3 ambient = ambientStrength * lightColor; // Generate ambient light color
+
+    //Calculate Diffuse lighting*/
+    vec3 norm = normalize(vertexNormal);                            // Normalize vectors to 1 unit
+    vec3 lightDirection = normalize(lightPos - vertexFragmentPos);  // Calculate distance (light direction) between light source and fragments/pixels on cube
+    float impact = max(dot(norm, lightDirection), 0.0);             // Calculate diffuse impact by generating dot product of normal and light
+    vec3 diffuse = impact * lightColor;                             // Generate diffuse light color
+
+    vec3 specular = vec3(0.0);
+#ifdef SPECULAR
+    //Calculate Specular lighting*/
+    float highlightSize = 16.0f;                                // Set specular highlight size
+    vec3 viewDir = normalize(viewPosition - vertexFragmentPos); // Calculate view direction
+    vec3 reflectDir = reflect(-lightDirection, norm);           // Calculate reflection vector
+    //Calculate specular component
+    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), highlightSize);
+    specular = specularIntensity1 * specularComponent * lightColor;
+#endif
+
+    // Shadows remove the diffuse and specular light but keep the ambient light
+    float shadow = 1.0;
+#ifdef SHADOWS
+    shadow = KeyLightShadow(norm, lightDirection);
+#endif
+    vec3 lightingResult = (ambient + shadow * (diffuse + specular));
+
+#if LIGHT_COUNT > 1
+    /*Calculate for light 2
+     *Calculate Ambient lighting*/
+    float ambientStrength2 = 0.1f;                              // Set ambient or global lighting strength
+    vec3 ambient2 = ambientStrength2 * light2Color;             // Generate ambient light color
+
+    /*Calculate Diffuse lighting*/
+    vec3 light2Direction = normalize(light2Pos - vertexFragmentPos);    // Calculate distance (light direction) between light source and fragments/pixels on cube
+    float impact2 = max(dot(norm, light2Direction), 0.0);               // Calculate diffuse impact by generating dot product of normal and light
+    vec3 diffuse2 = impact2 * light2Color;                              // Generate diffuse light color
+
+    vec3 specular2 = vec3(0.0);
+#ifdef SPECULAR
+    /*Calculate Specular lighting*/
+    float highlightSize2 = 16.0f;                           // Set specular highlight size
+    vec3 reflectDir2 = reflect(-light2Direction, norm);     // Calculate reflection vector
+    //Calculate specular component
+    float specularComponent2 = pow(max(dot(viewDir, reflectDir2), 0.0), highlightSize2);
+    specular2 = specularIntensity2 * specularComponent2 * light2Color;
+#endif
+
+    float shadow2 = 1.0;
+#ifdef SHADOWS
+    shadow2 = FillLightShadow(norm, light2Direction);
+#endif
+
+    // Combine the results from both lights into one vec3
+    lightingResult += (ambient2 + shadow2 * (diffuse2 + specular2));
+#endif
+
+    // Texture holds the color to be used for all three components
+#ifdef TEXTURED
+    vec3 surfaceColor = texture(uTexture, vertexTextureCoordinate * uvScale).xyz;
+#else
+    vec3 surfaceColor = objectColor;
+#endif
+
+    // Calculate phong result
+    vec3 phong = (lightingResult)*surfaceColor;
+
+    fragmentColor = vec4(phong, 1.0); // Send lighting results to GPU
+}
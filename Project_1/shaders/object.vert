@@ -0,0 +1,43 @@
+// No #version line. ShaderVariants adds it along with the TEXTURED, SPECULAR, SHADOWS, INSTANCED, and
+// LIGHT_COUNT defines for each material
+
+layout(location = 0) in vec3 position;      // VAP position 0 for vertex position data
+layout(location = 1) in vec3 normal;        // VAP position 1 for normals
+layout(location = 2) in vec2 textureCoordinate;
+#ifdef INSTANCED
+layout(location = 3) in mat4 instanceModel;   // Model matrix of each copy, locations 3 to 6, advanced once per instance
+#endif
+
+out vec3 vertexNormal;                      // For outgoing normals to fragment shader
+out vec3 vertexFragmentPos;                 // For outgoing color / pixels to fragment shader
+#ifdef TEXTURED
+out vec2 vertexTextureCoordinate;
+#endif
+#if defined(SHADOWS) && LIGHT_COUNT > 1
+out vec4 vertexLight2Position;              // Position as seen from the fill light for shadows
+#endif
+
+//Uniform / Global variables for the  transform matrices
+#ifndef INSTANCED
+uniform mat4 model;
+#endif
+
+// FrameData, the per-frame values shared by every program, is added from frame_data.glsl when the program is built
+
+void main()
+{
+#ifdef INSTANCED
+    mat4 model = instanceModel;
+#endif
+    gl_Position = projection * view * model * vec4(position, 1.0f);     // Transforms vertices into clip coordinates
+
+    vertexFragmentPos = vec3(model * vec4(position, 1.0f));             // Gets fragment / pixel position in world space only (exclude view and projection)
+
+    vertexNormal = mat3(transpose(inverse(model))) * normal;            // get normal vectors in world space only and exclude normal translation properties
+#ifdef TEXTURED
+    vertexTextureCoordinate = textureCoordinate;
+#endif
+#if defined(SHADOWS) && LIGHT_COUNT > 1
+    vertexLight2Position = light2ViewProjection * vec4(vertexFragmentPos, 1.0f);
+#endif
+}
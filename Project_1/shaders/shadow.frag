@@ -0,0 +1,15 @@
+#version 440 core
+
+in vec3 fragmentWorldPos;
+
+uniform vec3 lightPosition;
+uniform float farPlane;
+uniform bool linearDepth;       // Store distance from the light for the point light cube map
+
+void main()
+{
+    if (linearDepth)
+        gl_FragDepth = length(fragmentWorldPos - lightPosition) / farPlane;
+    else
+        gl_FragDepth = gl_FragCoord.z;
+}
@@ -0,0 +1,16 @@
+#version 440 core
+
+layout(location = 0) in vec3 position;      // Vertex data from Vertex Attrib Pointer 0
+
+out vec3 fragmentWorldPos;                  // World position for distance from the light
+
+//Uniform / Global variables for the transform matrices
+uniform mat4 model;
+uniform mat4 lightViewProjection;
+
+void main()
+{
+    vec4 worldPosition = model * vec4(position, 1.0f);
+    fragmentWorldPos = worldPosition.xyz;
+    gl_Position = lightViewProjection * worldPosition;
+}